@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <atomic>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ARENA_PAGES_SUPPORTED
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+//Non-owning view of contiguous objects allocated by an Arena
+template <typename T>
+class ArenaSpan
+{
+	T* _data = nullptr;
+	size_t _size = 0;
+
+public:
+	ArenaSpan() = default;
+	ArenaSpan(T* data, size_t size): _data(data), _size(size) {}
+
+	T* begin() const { return _data; }
+	T* end() const { return _data + _size; }
+
+	T& operator[](size_t index) const
+	{
+		return _data[index];
+	}
+
+	T& front() const
+	{
+		return _data[0];
+	}
+
+	T& back() const
+	{
+		return _data[_size-1];
+	}
+
+	T* data() const
+	{
+		return _data;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	bool empty() const
+	{
+		return _size == 0;
+	}
+};
+
+//Bump allocator
+//Guarantees: objects allocated at once are contiguous, addresses never change
+//Does not guarantee: destructors are called, hence only trivially destructible types
+//Memory is released all at once when the arena is destroyed
+class Arena
+{
+	std::vector<void*> _blocks;
+	uint8_t* _ptr = nullptr;
+	size_t _left = 0;
+	size_t _block_size = 65536;
+
+	void* alloc(size_t bytes)
+	{
+		//make sure there's a slot for the block before allocating it
+		_blocks.reserve(_blocks.size()+1);
+		if(void* mem = std::malloc(bytes))
+		{
+			_blocks.push_back(mem);
+			return mem;
+		}
+		else
+			throw std::bad_alloc();
+	}
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		size_t padding = (alignment - reinterpret_cast<uintptr_t>(_ptr) % alignment) % alignment;
+		if(!_ptr || padding + bytes > _left)
+		{
+			reserve(bytes + alignment);
+			padding = (alignment - reinterpret_cast<uintptr_t>(_ptr) % alignment) % alignment;
+		}
+		void* mem = _ptr + padding;
+		_ptr += padding + bytes;
+		_left -= padding + bytes;
+		return mem;
+	}
+
+public:
+	Arena(size_t block_size = 65536): _block_size(block_size) {}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	Arena(Arena&& other)
+	{
+		swap(other);
+	}
+
+	Arena& operator=(Arena&& other)
+	{
+		swap(other);
+		return *this;
+	}
+
+	~Arena()
+	{
+		clear();
+	}
+
+	//Makes sure the next allocations of up to "bytes" in total
+	//come from a single block of memory
+	void reserve(size_t bytes)
+	{
+		if(_ptr && bytes <= _left) return;
+		size_t size = std::max(bytes, _block_size);
+		_ptr = static_cast<uint8_t*>(alloc(size));
+		_left = size;
+	}
+
+	//Allocates "count" contiguous default constructed objects
+	template <typename T>
+	ArenaSpan<T> create(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "Arena does not call destructors.");
+		if(count == 0) return ArenaSpan<T>();
+		size_t bytes = count * sizeof(T);
+		if(bytes / count != sizeof(T))
+		{
+			throw std::overflow_error(
+				"Allocation failed due to integer multiplication overflow."
+			);
+		}
+		T* mem = static_cast<T*>(allocate(bytes, alignof(T)));
+		for(size_t i = 0; i < count; ++i)
+			new (mem + i) T();
+		return ArenaSpan<T>(mem, count);
+	}
+
+	//Allocates contiguous copies of objects in range [first, last)
+	template <typename T, typename I>
+	ArenaSpan<T> copy(I first, I last)
+	{
+		auto span = create<T>(std::distance(first, last));
+		for(auto& elem : span)
+		{
+			elem = *first;
+			++first;
+		}
+		return span;
+	}
+
+	//Releases all memory, invalidates all allocated objects
+	void clear()
+	{
+		for(void* block : _blocks) std::free(block);
+		_blocks.clear();
+		_ptr = nullptr;
+		_left = 0;
+	}
+
+	void swap(Arena& other)
+	{
+		std::swap(_blocks, other._blocks);
+		std::swap(_ptr, other._ptr);
+		std::swap(_left, other._left);
+		std::swap(_block_size, other._block_size);
+	}
+};
+
+//Single region of memory taken directly from the OS, allocations are thread-safe
+//Guarantees: addresses never change, the region is never exceeded
+//Does not guarantee: memory of single allocations is reused
+//Memory is released all at once when the arena is destroyed
+class PageArena
+{
+	uint8_t* _data = nullptr;
+	size_t _size = 0;
+	size_t _mapped_size = 0;
+	std::atomic<size_t> _used = 0;
+	bool _locked = false;
+
+public:
+	struct Options
+	{
+		//backs the region with transparent huge pages where supported,
+		//fewer TLB misses when accessing large amounts of memory
+		bool huge_pages = false;
+		//keeps the region in physical memory, might fail due to resource limits
+		bool lock = false;
+		//touches every page up front, so that no page faults happen on first access
+		bool prefault = false;
+	};
+
+	//Reserves "size" bytes, check data() for failure
+	PageArena(size_t size): PageArena(size, Options()) {}
+	PageArena(size_t size, const Options& options)
+	{
+		if(size == 0) return;
+	#ifdef ARENA_PAGES_SUPPORTED
+		size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+		//huge pages need 2 MiB aligned memory
+		size_t alignment = options.huge_pages?std::max<size_t>(size_t(2) << 20, page_size):page_size;
+		size = (size + alignment - 1) / alignment * alignment;
+		size_t mapped_size = size + alignment - page_size;
+		void* mem = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+		if(mem == MAP_FAILED) return;
+		//give back what's beyond the aligned region
+		uint8_t* begin = static_cast<uint8_t*>(mem);
+		uint8_t* aligned = begin + (alignment - reinterpret_cast<uintptr_t>(begin) % alignment) % alignment;
+		if(aligned > begin) munmap(begin, aligned - begin);
+		if(aligned + size < begin + mapped_size) munmap(aligned + size, begin + mapped_size - (aligned + size));
+		_data = aligned;
+		_mapped_size = size;
+	#ifdef MADV_HUGEPAGE
+		if(options.huge_pages) madvise(_data, size, MADV_HUGEPAGE);
+	#endif
+		if(options.lock) _locked = mlock(_data, size) == 0;
+	#else
+		size_t page_size = 4096;
+		size = (size + page_size - 1) / page_size * page_size;
+		_data = static_cast<uint8_t*>(::operator new(size, std::align_val_t(page_size), std::nothrow));
+		if(!_data) return;
+	#endif
+		_size = size;
+		if(options.prefault)
+		{
+			for(size_t offset = 0; offset < size; offset += page_size)
+				static_cast<volatile uint8_t*>(_data)[offset] = 0;
+		}
+	}
+
+	PageArena(const PageArena&) = delete;
+	PageArena& operator=(const PageArena&) = delete;
+
+	~PageArena()
+	{
+		if(!_data) return;
+	#ifdef ARENA_PAGES_SUPPORTED
+		munmap(_data, _mapped_size);
+	#else
+		::operator delete(_data, std::align_val_t(4096));
+	#endif
+	}
+
+	//Returns nullptr if there's not enough space left
+	void* allocate(size_t bytes, size_t alignment = 64)
+	{
+		size_t used = _used.load(std::memory_order_relaxed);
+		size_t offset;
+		do
+		{
+			offset = (used + alignment - 1) / alignment * alignment;
+			if(offset > _size || bytes > _size - offset) return nullptr;
+		}
+		while(!_used.compare_exchange_weak(used, offset + bytes, std::memory_order_relaxed));
+		return _data + offset;
+	}
+
+	//nullptr if the region couldn't be reserved
+	uint8_t* data() const
+	{
+		return _data;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+	size_t used() const
+	{
+		return std::min(_used.load(std::memory_order_relaxed), _size);
+	}
+
+	//Whether the region is locked in physical memory
+	bool locked() const
+	{
+		return _locked;
+	}
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <array>
+#include <cctype>
+
+#include "sf2.hpp"
+
+namespace SF2
+{
+	//Index of a directory tree of soundfonts built from catalog scans,
+	//kept on disk and updated incrementally, only new or changed files are scanned
+	struct LibraryIndex
+	{
+		struct File
+		{
+			//canonical path
+			std::string path;
+			uint64_t size = 0;
+			//modification time, in file clock ticks
+			int64_t mtime = 0;
+			//false if the file couldn't be read or isn't a SoundFont2
+			bool valid = false;
+			SoundFont2::Catalog catalog;
+		};
+		//sorted by path
+		std::vector<File> files;
+
+		struct UpdateStats
+		{
+			size_t scanned = 0;
+			size_t unchanged = 0;
+			size_t removed = 0;
+		};
+
+		static constexpr char magic[8] = {'S','F','2','H','P','P','I','X'};
+		static constexpr uint32_t version = 1;
+
+		//Rescans .sf2 and .sf3 files under "root" that are new or changed since the last update
+		//using "threads" threads, 0 uses all hardware threads,
+		//entries of files that no longer exist under "root" are dropped
+		UpdateStats Update(const std::string& root, unsigned threads = 0)
+		{
+			namespace fs = std::filesystem;
+			UpdateStats stats;
+
+			//collect soundfonts
+			std::vector<File> found;
+			std::error_code error;
+			auto base = fs::canonical(root, error);
+			if(error) return stats;
+			for(fs::recursive_directory_iterator it(base, fs::directory_options::skip_permission_denied, error), end;
+				!error && it != end; it.increment(error))
+			{
+				if(!it->is_regular_file(error)) continue;
+				auto extension = it->path().extension().string();
+				std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c){ return std::tolower(c); });
+				if(extension != ".sf2" && extension != ".sf3") continue;
+				File file;
+				file.path = it->path().string();
+				file.size = it->file_size(error);
+				if(error) { error.clear(); continue; }
+				auto time = it->last_write_time(error);
+				if(error) { error.clear(); continue; }
+				file.mtime = time.time_since_epoch().count();
+				found.push_back(std::move(file));
+			}
+			std::sort(found.begin(), found.end(), [](auto&& a, auto&& b) { return a.path < b.path; });
+
+			//reuse entries of unchanged files
+			std::unordered_map<std::string, File*> previous;
+			for(auto& file : files) previous.emplace(file.path, &file);
+			std::vector<File*> pending;
+			for(auto& file : found)
+			{
+				auto it = previous.find(file.path);
+				if(it == previous.end()) { pending.push_back(&file); continue; }
+				if(it->second->size == file.size && it->second->mtime == file.mtime)
+				{
+					file = std::move(*it->second);
+					++stats.unchanged;
+				}
+				else pending.push_back(&file);
+				previous.erase(it);
+			}
+			//everything left under root is gone, entries outside of root are kept,
+			//they are added to "found" after the scan, as "pending" points into it
+			std::string prefix = (base / "").string();
+			std::vector<File> kept;
+			for(auto& [path, file] : previous)
+			{
+				if(path.compare(0, prefix.size(), prefix) == 0) ++stats.removed;
+				else kept.push_back(std::move(*file));
+			}
+			stats.scanned = pending.size();
+
+			//scan in parallel, largest first
+			std::sort(pending.begin(), pending.end(), [](File* a, File* b) { return a->size > b->size; });
+			if(threads == 0) threads = std::thread::hardware_concurrency();
+			threads = (unsigned)std::min<size_t>(std::max(threads, 1u), std::max<size_t>(pending.size(), 1));
+			std::atomic<size_t> next = 0;
+			auto worker = [&]
+			{
+				for(size_t i; (i = next.fetch_add(1)) < pending.size();)
+					pending[i]->valid = ScanFile(pending[i]->path, pending[i]->catalog);
+			};
+			std::vector<std::thread> workers;
+			for(unsigned i = 1; i < threads; ++i)
+				workers.emplace_back(worker);
+			worker();
+			for(auto& thread : workers)
+				thread.join();
+
+			found.insert(found.end(), std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()));
+			std::sort(found.begin(), found.end(), [](auto&& a, auto&& b) { return a.path < b.path; });
+			files = std::move(found);
+			return stats;
+		}
+
+		static bool ScanFile(const std::string& path, SoundFont2::Catalog& catalog)
+		{
+		#ifdef RIFF_POSIX_IO
+			RIFF::fd_reader file(path.c_str());
+		#else
+			RIFF::file_reader file(path.c_str());
+		#endif
+			if(!file.is_open()) return false;
+			//scan reads a handful of small chunks spread across the file
+			RIFF::buffered_reader buffered(file.get_stream(), 16384);
+			auto s = buffered.get_stream();
+			return SoundFont2::Scan(s, catalog);
+		}
+
+		const File* Find(const std::string& path) const
+		{
+			auto it = std::lower_bound(files.begin(), files.end(), path, [](const File& file, const std::string& p) { return file.path < p; });
+			return (it != files.end() && it->path == path)?&*it:nullptr;
+		}
+
+		//Index file layout, all little-endian:
+		//magic, version, file count, files, checksum of everything before it
+		//file: path, size, mtime, valid, ifil, iver, 9 INFO strings,
+		//sample count, sample bytes, preset count, presets (bank, num, name)
+		//strings are a 32 bit length followed by characters
+		bool Save(const std::string& path) const
+		{
+			std::vector<BYTE> out;
+			auto put = [&](const void* data, size_t size)
+			{
+				out.insert(out.end(), (const BYTE*)data, (const BYTE*)data + size);
+			};
+			auto put_string = [&](const std::string& str)
+			{
+				uint32_t size = (uint32_t)str.size();
+				put(&size, sizeof(size));
+				put(str.data(), str.size());
+			};
+			put(magic, sizeof(magic));
+			put(&version, sizeof(version));
+			uint32_t count = (uint32_t)files.size();
+			put(&count, sizeof(count));
+			for(auto& file : files)
+			{
+				put_string(file.path);
+				put(&file.size, sizeof(file.size));
+				put(&file.mtime, sizeof(file.mtime));
+				uint8_t valid = file.valid;
+				put(&valid, sizeof(valid));
+				auto& c = file.catalog;
+				put(&c.ifil, sizeof(c.ifil));
+				put(&c.iver, sizeof(c.iver));
+				for(auto str : InfoStrings(c)) put_string(*str);
+				uint32_t sample_count = (uint32_t)c.sample_count;
+				put(&sample_count, sizeof(sample_count));
+				put(&c.sample_bytes, sizeof(c.sample_bytes));
+				uint32_t preset_count = (uint32_t)c.presets.size();
+				put(&preset_count, sizeof(preset_count));
+				for(auto& preset : c.presets)
+				{
+					put(&preset.bank, sizeof(preset.bank));
+					put(&preset.num, sizeof(preset.num));
+					put_string(preset.name);
+				}
+			}
+			uint64_t checksum = SoundFont2::cache_checksum(out.data(), out.size());
+			put(&checksum, sizeof(checksum));
+
+			//write to a temporary file first, so that a failed write keeps the old index
+			std::string temp = path + ".tmp";
+			{
+				std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+				if(!file.write((const char*)out.data(), out.size())) return false;
+			}
+			std::error_code error;
+			std::filesystem::rename(temp, path, error);
+			return !error;
+		}
+
+		//Returns false and leaves the index empty if the file is missing or damaged
+		bool Load(const std::string& path)
+		{
+			files.clear();
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if(!file) return false;
+			std::vector<BYTE> in(size_t(file.tellg()));
+			file.seekg(0);
+			if(!file.read((char*)in.data(), in.size())) return false;
+			if(in.size() < sizeof(magic) + sizeof(version) + sizeof(uint32_t) + sizeof(uint64_t)) return false;
+			uint64_t checksum;
+			std::memcpy(&checksum, in.data() + in.size() - sizeof(checksum), sizeof(checksum));
+			size_t end = in.size() - sizeof(checksum);
+			if(SoundFont2::cache_checksum(in.data(), end) != checksum) return false;
+
+			size_t pos = 0;
+			bool ok = true;
+			auto get = [&](void* data, size_t size)
+			{
+				if(!ok || size > end - pos) { ok = false; return; }
+				std::memcpy(data, in.data() + pos, size);
+				pos += size;
+			};
+			auto get_string = [&](std::string& str)
+			{
+				uint32_t size = 0;
+				get(&size, sizeof(size));
+				if(!ok || size > end - pos) { ok = false; return; }
+				str.assign((const char*)in.data() + pos, size);
+				pos += size;
+			};
+			char file_magic[sizeof(magic)];
+			uint32_t file_version = 0, count = 0;
+			get(file_magic, sizeof(file_magic));
+			get(&file_version, sizeof(file_version));
+			get(&count, sizeof(count));
+			if(!ok || std::memcmp(file_magic, magic, sizeof(magic)) != 0 || file_version != version) return false;
+			std::vector<File> loaded;
+			for(uint32_t i = 0; ok && i < count; ++i)
+			{
+				File f;
+				get_string(f.path);
+				get(&f.size, sizeof(f.size));
+				get(&f.mtime, sizeof(f.mtime));
+				uint8_t valid = 0;
+				get(&valid, sizeof(valid));
+				f.valid = valid != 0;
+				auto& c = f.catalog;
+				get(&c.ifil, sizeof(c.ifil));
+				get(&c.iver, sizeof(c.iver));
+				for(auto str : InfoStrings(c)) get_string(*str);
+				uint32_t sample_count = 0, preset_count = 0;
+				get(&sample_count, sizeof(sample_count));
+				c.sample_count = sample_count;
+				get(&c.sample_bytes, sizeof(c.sample_bytes));
+				get(&preset_count, sizeof(preset_count));
+				//every preset takes at least 8 bytes
+				if(!ok || preset_count > (end - pos) / 8) return false;
+				c.presets.resize(preset_count);
+				for(auto& preset : c.presets)
+				{
+					get(&preset.bank, sizeof(preset.bank));
+					get(&preset.num, sizeof(preset.num));
+					get_string(preset.name);
+				}
+				loaded.push_back(std::move(f));
+			}
+			if(!ok || pos != end) return false;
+			files = std::move(loaded);
+			return true;
+		}
+
+	private:
+		static std::array<std::string*, 9> InfoStrings(SoundFont2::Catalog& c)
+		{
+			return {&c.szSoundEngine, &c.szROM, &c.szName, &c.szDate, &c.szProduct,
+				&c.szCreator, &c.szCopyright, &c.szComment, &c.szTools};
+		}
+		static std::array<const std::string*, 9> InfoStrings(const SoundFont2::Catalog& c)
+		{
+			return {&c.szSoundEngine, &c.szROM, &c.szName, &c.szDate, &c.szProduct,
+				&c.szCreator, &c.szCopyright, &c.szComment, &c.szTools};
+		}
+	};
+}
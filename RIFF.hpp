@@ -1,249 +1,937 @@
-#pragma once
-
-#include <cstdint>
-#include <string>
-#include <vector>
-#include <memory>
-
-#ifdef RIFF_DEBUG
-#include <iostream>
-#endif
-
-namespace RIFF
-{
-	typedef uint8_t BYTE;
-	typedef uint16_t WORD;
-	typedef uint32_t DWORD;
-	typedef uint32_t FOURCC;
-
-	inline bool FOURCC_equals(FOURCC code, const char* str)
-	{
-		return
-			((char*)&code)[0] == str[0] && 
-			((char*)&code)[1] == str[1] &&
-			((char*)&code)[2] == str[2] &&
-			((char*)&code)[3] == str[3];
-	}
-
-	inline std::string FOURCC_to_string(FOURCC code)
-	{
-		std::string result;
-		result += ((char*)&code)[0];
-		result += ((char*)&code)[1];
-		result += ((char*)&code)[2];
-		result += ((char*)&code)[3];
-
-		return result;
-	}
-
-	inline FOURCC string_to_FOURCC(const char* str)
-	{
-		FOURCC result = 0;
-
-		int i = 0;
-		while(i < 4 && str[i] != '\0')
-		{
-			result |= str[i] << ((i*8));
-			++i;
-		}
-		while(i < 4) result |= ' ' << ((i*8));
-
-		return result;
-	}
-
-	constexpr inline FOURCC constexpr_string_to_FOURCC(const char* str)
-	{
-		constexpr FOURCC result = 0;
-
-		int i = 0;
-		while(i < 4 && str[i] != '\0') ((char*)&result)[i] = str[i++];
-		while(i < 4) ((char*)&result)[i++] = ' ';
-
-		return result;
-	}
-
-	//"abstract" data stream
-	//can be used to read from file or from memory
-	struct stream
-	{
-		void* src;
-		size_t (*func_read_ptr)(void* src, void* dest, size_t size);
-		size_t (*func_skip_ptr)(void* src, size_t size);
-		size_t (*func_getpos_ptr)(void* src);
-		void (*func_setpos_ptr)(void* src, size_t pos);
-		size_t read(void* dest, size_t size)
-		{
-			return func_read_ptr(src, dest, size);
-		}
-		size_t skip(size_t size)
-		{
-			return func_skip_ptr(src, size);
-		}
-		size_t getpos()
-		{
-			return func_getpos_ptr(src);
-		}
-		void setpos(size_t pos)
-		{
-			func_setpos_ptr(src, pos);
-		}
-	};
-
-	struct RIFF
-	{
-		struct chunk {
-			//A chunk ID identifies the type of data within the chunk.
-			FOURCC id;
-			//The size of the chunk data in bytes, excluding any pad byte.
-			DWORD size;
-			//The actual data plus a pad byte if req’d to word align.
-			std::unique_ptr<BYTE[]> data;
-
-			//Form type for "RIFF" chunks or the list type for "LIST" chunks.
-			FOURCC type; 
-
-			//Data stream offset of the beginning of the chunk's data member,
-			//relative to the beginning of the data stream.
-			size_t data_offset;
-
-			//Calculate size padded to WORD
-			size_t get_padded_data_size() {return (size % 2)?(size+1):size;}
-
-			//Loads data from stream using saved offset
-			bool load_data(stream& s)
-			{
-				size_t old_pos = s.getpos();
-				size_t data_size = get_padded_data_size();
-				data = std::make_unique<BYTE[]>(data_size);
-				s.setpos(data_offset);			
-				if(s.read(data.get(), data_size) < data_size)
-				{
-					s.setpos(old_pos);
-					return false;
-				}
-				s.setpos(old_pos);
-				return true;
-			}
-		};
-
-		std::vector<std::unique_ptr<chunk>> chunks;
-
-		//In RIFF, order of chunks matters.
-		//Chunks of RIFF or LIST type contain subchunks,
-		//and that's why following functions provide
-		//ability to start lookup from a certain index.
-		chunk* get_chunk_by_id(FOURCC id, size_t start_index = 0)
-		{
-			for(size_t i = start_index; i < chunks.size(); ++i)
-			{
-				if(chunks[i]->id == id) return chunks[i].get();
-			}
-			return nullptr;
-		}
-		chunk* get_chunk_by_type(FOURCC type, size_t start_index = 0)
-		{
-			for(size_t i = start_index; i < chunks.size(); ++i)
-			{
-				if(chunks[i]->type == type) return chunks[i].get();
-			}
-			return nullptr;
-		}
-		chunk* get_chunk_by_id_type(FOURCC id, FOURCC type, size_t start_index = 0)
-		{
-			for(size_t i = start_index; i < chunks.size(); ++i)
-			{
-				if(chunks[i]->id == id && chunks[i]->type == type) return chunks[i].get();
-			}
-			return nullptr;
-		}
-		size_t get_chunk_index_by_id(FOURCC id, size_t start_index = 0)
-		{
-			for(size_t i = start_index; i < chunks.size(); ++i)
-			{
-				if(chunks[i]->id == id) return i;
-			}
-			return -1;
-		}
-		size_t get_chunk_index_by_type(FOURCC type, size_t start_index = 0)
-		{
-			for(size_t i = start_index; i < chunks.size(); ++i)
-			{
-				if(chunks[i]->type == type) return i;
-			}
-			return -1;
-		}
-		size_t get_chunk_index_by_id_type(FOURCC id, FOURCC type, size_t start_index = 0)
-		{
-			for(size_t i = start_index; i < chunks.size(); ++i)
-			{
-				if(chunks[i]->id == id && chunks[i]->type == type) return i;
-			}
-			return -1;
-		}
-
-		//Collect chunks from binary data stream
-		//"load_data" flag dictates whether data is immedieately loaded
-		//during parsing or ignored to be loaded manually later
-		void parse(stream& s, bool load_data = false)
-		{
-			auto read_chunk_info = [](stream& s, chunk* c)->bool
-			{
-			#define read_and_check(src, dest, size)\
-			{\
-				if(src.read(dest, size) < size) return false;\
-			}
-			#define skip_and_check(src, size)\
-			{\
-				if(src.skip(size) < size) return false;\
-			}
-				//Read FOURCC id
-				read_and_check(s, &c->id, sizeof(FOURCC));
-				//Read chunk data size (no padding)
-				read_and_check(s, &c->size, sizeof(DWORD));
-				if(FOURCC_equals(c->id, "RIFF") || FOURCC_equals(c->id, "LIST"))
-				{
-					//Read Form/List Type
-					read_and_check(s, &c->type, sizeof(FOURCC));
-					//save stream position to read data when needed
-					c->data_offset = s.getpos();
-					c->data = nullptr;
-					//don't read any data, because those chunks
-					//are special and only contain subchunks
-				}
-				else
-				{
-					c->type = 0;
-					//save stream position to read data when needed
-					c->data_offset = s.getpos();
-					c->data = nullptr;
-					//skip data field
-					skip_and_check(s, c->get_padded_data_size());
-				}
-				return true;
-			#undef read_and_check
-			#undef skip_and_check
-			};
-
-			while(true)
-			{
-				auto c = std::make_unique<chunk>();
-				if(!read_chunk_info(s, c.get()))
-					break;
-				if(load_data && !c->load_data(s))
-					break;
-				chunks.emplace_back(std::move(c));
-			}
-
-#ifdef RIFF_DEBUG
-			for(auto c : chunks)
-			{
-				std::cout << "//=======================" << std::endl;
-				std::cout << "ID:" << FOURCC_to_string(c->id) << std::endl;
-				std::cout << "Type:" << FOURCC_to_string(c->type) << std::endl;
-				std::cout << "Size:" << c->size << std::endl;
-				std::cout << "Data offset:" << c->data_offset << std::endl;
-			}
-#endif
-		}
-	};
-}
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RIFF_MMAP_SUPPORTED
+#define RIFF_POSIX_IO
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef RIFF_DEBUG
+#include <iostream>
+#endif
+
+namespace RIFF
+{
+	typedef uint8_t BYTE;
+	typedef uint16_t WORD;
+	typedef uint32_t DWORD;
+	typedef uint32_t FOURCC;
+
+	inline bool FOURCC_equals(FOURCC code, const char* str)
+	{
+		return
+			((char*)&code)[0] == str[0] && 
+			((char*)&code)[1] == str[1] &&
+			((char*)&code)[2] == str[2] &&
+			((char*)&code)[3] == str[3];
+	}
+
+	inline std::string FOURCC_to_string(FOURCC code)
+	{
+		std::string result;
+		result += ((char*)&code)[0];
+		result += ((char*)&code)[1];
+		result += ((char*)&code)[2];
+		result += ((char*)&code)[3];
+
+		return result;
+	}
+
+	//FOURCC codes are stored as little-endian 32-bit values,
+	//shorter strings are padded with spaces
+	constexpr inline FOURCC constexpr_string_to_FOURCC(const char* str)
+	{
+		FOURCC result = 0;
+
+		int i = 0;
+		for(; i < 4 && str[i] != '\0'; ++i) result |= FOURCC(uint8_t(str[i])) << (i*8);
+		for(; i < 4; ++i) result |= FOURCC(' ') << (i*8);
+
+		return result;
+	}
+
+	inline FOURCC string_to_FOURCC(const char* str)
+	{
+		return constexpr_string_to_FOURCC(str);
+	}
+
+	inline namespace literals
+	{
+		//"LIST"_FOURCC
+		constexpr inline FOURCC operator""_FOURCC(const char* str, size_t)
+		{
+			return constexpr_string_to_FOURCC(str);
+		}
+	}
+
+	//"abstract" data stream
+	//can be used to read from file or from memory
+	struct stream
+	{
+		void* src;
+		size_t (*func_read_ptr)(void* src, void* dest, size_t size);
+		size_t (*func_skip_ptr)(void* src, size_t size);
+		size_t (*func_getpos_ptr)(void* src);
+		//nullptr if the stream can only be read front to back
+		void (*func_setpos_ptr)(void* src, size_t pos) = nullptr;
+		//optional, returns read-only pointer to "size" bytes at "pos"
+		//if the source resides in memory, nullptr otherwise
+		const void* (*func_view_ptr)(void* src, size_t pos, size_t size) = nullptr;
+		//optional, reads "size" bytes at "pos" without using or moving the position,
+		//safe to call from multiple threads at once
+		size_t (*func_read_at_ptr)(void* src, size_t pos, void* dest, size_t size) = nullptr;
+		size_t read(void* dest, size_t size)
+		{
+			return func_read_ptr(src, dest, size);
+		}
+		size_t skip(size_t size)
+		{
+			return func_skip_ptr(src, size);
+		}
+		size_t getpos()
+		{
+			return func_getpos_ptr(src);
+		}
+		void setpos(size_t pos)
+		{
+			func_setpos_ptr(src, pos);
+		}
+		bool is_seekable() const
+		{
+			return func_setpos_ptr != nullptr;
+		}
+		const void* view(size_t pos, size_t size)
+		{
+			return func_view_ptr?func_view_ptr(src, pos, size):nullptr;
+		}
+		bool has_read_at() const
+		{
+			return func_read_at_ptr != nullptr;
+		}
+		//returns 0 if positional reads aren't supported
+		size_t read_at(size_t pos, void* dest, size_t size)
+		{
+			return func_read_at_ptr?func_read_at_ptr(src, pos, dest, size):0;
+		}
+	};
+
+	//Read-only block of memory with a cursor,
+	//stream source for data that is already in memory
+	struct memory_reader
+	{
+		const BYTE* data = nullptr;
+		size_t size = 0;
+		size_t pos = 0;
+
+		//The reader must outlive returned stream
+		stream get_stream()
+		{
+			stream s;
+			s.src = this;
+			s.func_read_ptr = [](void* src, void* dest, size_t size)->size_t
+			{
+				auto r = static_cast<memory_reader*>(src);
+				size_t count = (r->pos < r->size)?std::min(size, r->size - r->pos):0;
+				std::memcpy(dest, r->data + r->pos, count);
+				r->pos += count;
+				return count;
+			};
+			s.func_skip_ptr = [](void* src, size_t size)->size_t
+			{
+				auto r = static_cast<memory_reader*>(src);
+				size_t count = (r->pos < r->size)?std::min(size, r->size - r->pos):0;
+				r->pos += count;
+				return count;
+			};
+			s.func_getpos_ptr = [](void* src)->size_t
+			{
+				return static_cast<memory_reader*>(src)->pos;
+			};
+			s.func_setpos_ptr = [](void* src, size_t pos)
+			{
+				static_cast<memory_reader*>(src)->pos = pos;
+			};
+			s.func_view_ptr = [](void* src, size_t pos, size_t size)->const void*
+			{
+				auto r = static_cast<memory_reader*>(src);
+				if(pos > r->size || size > r->size - pos) return nullptr;
+				return r->data + pos;
+			};
+			s.func_read_at_ptr = [](void* src, size_t pos, void* dest, size_t size)->size_t
+			{
+				auto r = static_cast<memory_reader*>(src);
+				size_t count = (pos < r->size)?std::min(size, r->size - pos):0;
+				std::memcpy(dest, r->data + pos, count);
+				return count;
+			};
+			return s;
+		}
+	};
+
+#ifdef RIFF_POSIX_IO
+	//Reads from a file descriptor at "pos" until "size" bytes are read,
+	//the end of file or an error
+	inline size_t read_fd_at(int fd, size_t pos, void* dest, size_t size)
+	{
+		size_t done = 0;
+		while(done < size)
+		{
+			ssize_t count = pread(fd, static_cast<BYTE*>(dest) + done, size - done, off_t(pos + done));
+			if(count < 0 && errno == EINTR) continue;
+			if(count <= 0) break;
+			done += count;
+		}
+		return done;
+	}
+#endif
+
+	//Stream source reading from a C file
+	struct file_reader
+	{
+		FILE* file = nullptr;
+		bool owned = false;
+		size_t size = 0;
+
+		file_reader() = default;
+		file_reader(const char* path) {open(path);}
+		//The file isn't closed by the reader
+		file_reader(FILE* f) {attach(f);}
+		file_reader(const file_reader&) = delete;
+		file_reader& operator=(const file_reader&) = delete;
+		~file_reader() {close();}
+
+		static bool seek(FILE* f, size_t pos, int origin)
+		{
+		#if defined(_WIN32)
+			return _fseeki64(f, (long long)pos, origin) == 0;
+		#elif defined(RIFF_POSIX_IO)
+			return fseeko(f, (off_t)pos, origin) == 0;
+		#else
+			return fseek(f, (long)pos, origin) == 0;
+		#endif
+		}
+
+		static size_t tell(FILE* f)
+		{
+		#if defined(_WIN32)
+			return (size_t)_ftelli64(f);
+		#elif defined(RIFF_POSIX_IO)
+			return (size_t)ftello(f);
+		#else
+			return (size_t)ftell(f);
+		#endif
+		}
+
+		bool open(const char* path)
+		{
+			close();
+			FILE* f = std::fopen(path, "rb");
+			if(!f) return false;
+			attach(f);
+			owned = true;
+			return true;
+		}
+
+		void attach(FILE* f)
+		{
+			close();
+			file = f;
+			//size is needed to report how much was skipped
+			size_t pos = tell(file);
+			seek(file, 0, SEEK_END);
+			size = tell(file);
+			seek(file, pos, SEEK_SET);
+		}
+
+		void close()
+		{
+			if(file && owned) std::fclose(file);
+			file = nullptr;
+			owned = false;
+			size = 0;
+		}
+
+		bool is_open() const {return file != nullptr;}
+
+		//The reader must outlive returned stream
+		stream get_stream()
+		{
+			stream s;
+			s.src = this;
+			s.func_read_ptr = [](void* src, void* dest, size_t size)->size_t
+			{
+				return std::fread(dest, 1, size, static_cast<file_reader*>(src)->file);
+			};
+			s.func_skip_ptr = [](void* src, size_t size)->size_t
+			{
+				auto r = static_cast<file_reader*>(src);
+				size_t pos = tell(r->file);
+				size_t count = (pos < r->size)?std::min(size, r->size - pos):0;
+				seek(r->file, pos + count, SEEK_SET);
+				return count;
+			};
+			s.func_getpos_ptr = [](void* src)->size_t
+			{
+				return tell(static_cast<file_reader*>(src)->file);
+			};
+			s.func_setpos_ptr = [](void* src, size_t pos)
+			{
+				seek(static_cast<file_reader*>(src)->file, pos, SEEK_SET);
+			};
+		#ifdef RIFF_POSIX_IO
+			//positional reads of the descriptor leave the FILE position and buffer alone
+			s.func_read_at_ptr = [](void* src, size_t pos, void* dest, size_t size)->size_t
+			{
+				return read_fd_at(fileno(static_cast<file_reader*>(src)->file), pos, dest, size);
+			};
+		#endif
+			return s;
+		}
+	};
+
+#ifdef RIFF_POSIX_IO
+	//Stream source reading from a POSIX file descriptor,
+	//keeps its own position, so seeking doesn't need a system call
+	struct fd_reader
+	{
+		int fd = -1;
+		bool owned = false;
+		size_t size = 0;
+		size_t pos = 0;
+
+		fd_reader() = default;
+		fd_reader(const char* path) {open(path);}
+		//The descriptor isn't closed by the reader
+		fd_reader(int descriptor) {attach(descriptor);}
+		fd_reader(const fd_reader&) = delete;
+		fd_reader& operator=(const fd_reader&) = delete;
+		~fd_reader() {close();}
+
+		bool open(const char* path)
+		{
+			close();
+			int descriptor = ::open(path, O_RDONLY);
+			if(descriptor < 0) return false;
+			attach(descriptor);
+			owned = true;
+			return true;
+		}
+
+		void attach(int descriptor)
+		{
+			close();
+			fd = descriptor;
+			struct stat st;
+			size = (fstat(fd, &st) == 0)?size_t(st.st_size):0;
+			pos = 0;
+		}
+
+		void close()
+		{
+			if(fd >= 0 && owned) ::close(fd);
+			fd = -1;
+			owned = false;
+			size = 0;
+			pos = 0;
+		}
+
+		bool is_open() const {return fd >= 0;}
+
+		//The reader must outlive returned stream
+		stream get_stream()
+		{
+			stream s;
+			s.src = this;
+			s.func_read_ptr = [](void* src, void* dest, size_t size)->size_t
+			{
+				auto r = static_cast<fd_reader*>(src);
+				size_t count = read_fd_at(r->fd, r->pos, dest, size);
+				r->pos += count;
+				return count;
+			};
+			s.func_skip_ptr = [](void* src, size_t size)->size_t
+			{
+				auto r = static_cast<fd_reader*>(src);
+				size_t count = (r->pos < r->size)?std::min(size, r->size - r->pos):0;
+				r->pos += count;
+				return count;
+			};
+			s.func_getpos_ptr = [](void* src)->size_t
+			{
+				return static_cast<fd_reader*>(src)->pos;
+			};
+			s.func_setpos_ptr = [](void* src, size_t pos)
+			{
+				static_cast<fd_reader*>(src)->pos = pos;
+			};
+			s.func_read_at_ptr = [](void* src, size_t pos, void* dest, size_t size)->size_t
+			{
+				return read_fd_at(static_cast<fd_reader*>(src)->fd, pos, dest, size);
+			};
+			return s;
+		}
+	};
+#endif
+
+	//Stream source reading data front to back through a callback,
+	//for sources that can't seek, like pipes, sockets or decompressors,
+	//chunk data has to be loaded while parsing, e.g. with load_policy::all()
+	struct forward_reader
+	{
+		//reads up to "size" bytes, returns the number of bytes read, 0 at the end of data
+		size_t (*func_read)(void* user, void* dest, size_t size) = nullptr;
+		void* user = nullptr;
+		size_t pos = 0;
+
+		forward_reader() = default;
+		forward_reader(size_t (*func)(void* user, void* dest, size_t size), void* user_data):
+			func_read(func), user(user_data) {}
+	#ifdef RIFF_POSIX_IO
+		//Reads a file descriptor, e.g. a pipe or a socket, the descriptor isn't closed by the reader
+		forward_reader(int descriptor):
+			forward_reader(read_fd, reinterpret_cast<void*>(intptr_t(descriptor))) {}
+
+		static size_t read_fd(void* user, void* dest, size_t size)
+		{
+			ssize_t count;
+			do count = ::read(int(reinterpret_cast<intptr_t>(user)), dest, size);
+			while(count < 0 && errno == EINTR);
+			return (count > 0)?size_t(count):0;
+		}
+	#endif
+
+		size_t read(void* dest, size_t size)
+		{
+			size_t done = 0;
+			//the callback might return less than asked for before the end
+			while(done < size)
+			{
+				size_t count = func_read(user, static_cast<BYTE*>(dest) + done, size - done);
+				if(count == 0) break;
+				done += count;
+			}
+			pos += done;
+			return done;
+		}
+
+		size_t skip(size_t size)
+		{
+			BYTE scratch[4096];
+			size_t done = 0;
+			while(done < size)
+			{
+				size_t count = read(scratch, std::min(size - done, sizeof(scratch)));
+				if(count == 0) break;
+				done += count;
+			}
+			return done;
+		}
+
+		//The reader must outlive returned stream
+		stream get_stream()
+		{
+			stream s;
+			s.src = this;
+			s.func_read_ptr = [](void* src, void* dest, size_t size)->size_t
+			{
+				return static_cast<forward_reader*>(src)->read(dest, size);
+			};
+			s.func_skip_ptr = [](void* src, size_t size)->size_t
+			{
+				return static_cast<forward_reader*>(src)->skip(size);
+			};
+			s.func_getpos_ptr = [](void* src)->size_t
+			{
+				return static_cast<forward_reader*>(src)->pos;
+			};
+			return s;
+		}
+	};
+
+	//Read-ahead buffer over another stream,
+	//the source is read in large blocks starting at aligned positions,
+	//so small reads and seeks within a block don't reach the source
+	struct buffered_reader
+	{
+		static constexpr size_t alignment = 4096;
+
+		stream source;
+		size_t block_size;
+		std::unique_ptr<BYTE[]> storage;
+		//aligned start of storage
+		BYTE* buffer = nullptr;
+		//position of buffer[0] in the source and number of valid bytes
+		size_t buffer_pos = 0;
+		size_t buffer_size = 0;
+		size_t pos = 0;
+		//position of the source, to avoid redundant seeks
+		size_t source_pos = 0;
+
+		//"block_size" is rounded up to a multiple of alignment
+		buffered_reader(const stream& s, size_t block_size = 65536):
+			source(s),
+			block_size((std::max<size_t>(block_size, 1) + alignment - 1) / alignment * alignment)
+		{
+			storage = std::make_unique<BYTE[]>(this->block_size + alignment);
+			buffer = storage.get() + (alignment - reinterpret_cast<uintptr_t>(storage.get()) % alignment) % alignment;
+			pos = source_pos = source.getpos();
+		}
+		buffered_reader(const buffered_reader&) = delete;
+		buffered_reader& operator=(const buffered_reader&) = delete;
+
+		void seek_source(size_t p)
+		{
+			if(source_pos != p)
+			{
+				if(source.is_seekable())
+					source.setpos(p);
+				//a forward-only source can only skip ahead
+				else if(p > source_pos)
+					source.skip(p - source_pos);
+				source_pos = p;
+			}
+		}
+
+		size_t read(void* dest, size_t size)
+		{
+			auto out = static_cast<BYTE*>(dest);
+			size_t done = 0;
+			while(done < size)
+			{
+				if(pos >= buffer_pos && pos < buffer_pos + buffer_size)
+				{
+					size_t count = std::min(size - done, buffer_pos + buffer_size - pos);
+					std::memcpy(out + done, buffer + (pos - buffer_pos), count);
+					done += count;
+					pos += count;
+					continue;
+				}
+				//large reads go straight to the destination
+				if(size - done >= block_size)
+				{
+					seek_source(pos);
+					size_t count = source.read(out + done, size - done);
+					source_pos += count;
+					pos += count;
+					done += count;
+					break;
+				}
+				//a forward-only source continues where it is
+				size_t block_pos = source.is_seekable()?pos - pos % alignment:pos;
+				seek_source(block_pos);
+				buffer_pos = block_pos;
+				buffer_size = source.read(buffer, block_size);
+				source_pos += buffer_size;
+				//end of the source
+				if(pos >= buffer_pos + buffer_size) break;
+			}
+			return done;
+		}
+
+		size_t skip(size_t size)
+		{
+			size_t buffer_end = buffer_pos + buffer_size;
+			size_t done = 0;
+			if(pos >= buffer_pos && pos <= buffer_end)
+			{
+				if(size <= buffer_end - pos)
+				{
+					pos += size;
+					return size;
+				}
+				//the source continues after the buffer, unless it was read past it since
+				done = buffer_end - pos;
+				pos = buffer_end;
+			}
+			seek_source(pos);
+			size_t count = source.skip(size - done);
+			source_pos += count;
+			pos += count;
+			return done + count;
+		}
+
+		//The reader must outlive returned stream
+		stream get_stream()
+		{
+			stream s;
+			s.src = this;
+			s.func_read_ptr = [](void* src, void* dest, size_t size)->size_t
+			{
+				return static_cast<buffered_reader*>(src)->read(dest, size);
+			};
+			s.func_skip_ptr = [](void* src, size_t size)->size_t
+			{
+				return static_cast<buffered_reader*>(src)->skip(size);
+			};
+			s.func_getpos_ptr = [](void* src)->size_t
+			{
+				return static_cast<buffered_reader*>(src)->pos;
+			};
+			if(source.is_seekable())
+			{
+				s.func_setpos_ptr = [](void* src, size_t pos)
+				{
+					static_cast<buffered_reader*>(src)->pos = pos;
+				};
+			}
+			//views are only passed through, the buffer changes with every read
+			if(source.func_view_ptr)
+			{
+				s.func_view_ptr = [](void* src, size_t pos, size_t size)->const void*
+				{
+					return static_cast<buffered_reader*>(src)->source.view(pos, size);
+				};
+			}
+			//positional reads go to the source, so they stay safe to use concurrently
+			if(source.func_read_at_ptr)
+			{
+				s.func_read_at_ptr = [](void* src, size_t pos, void* dest, size_t size)->size_t
+				{
+					return static_cast<buffered_reader*>(src)->source.read_at(pos, dest, size);
+				};
+			}
+			return s;
+		}
+	};
+
+#ifdef RIFF_MMAP_SUPPORTED
+	//Read-only memory mapped file,
+	//chunk data is viewed in place instead of being copied
+	struct mapped_file
+	{
+		memory_reader reader;
+
+		mapped_file() = default;
+		mapped_file(const char* path) {open(path);}
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		~mapped_file() {close();}
+
+		bool open(const char* path)
+		{
+			close();
+			int fd = ::open(path, O_RDONLY);
+			if(fd < 0) return false;
+			struct stat st;
+			if(fstat(fd, &st) != 0 || st.st_size <= 0)
+			{
+				::close(fd);
+				return false;
+			}
+			void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			//mapping holds its own reference to the file
+			::close(fd);
+			if(mem == MAP_FAILED) return false;
+			reader.data = static_cast<const BYTE*>(mem);
+			reader.size = st.st_size;
+			reader.pos = 0;
+			return true;
+		}
+
+		void close()
+		{
+			if(reader.data) munmap(const_cast<BYTE*>(reader.data), reader.size);
+			reader = memory_reader();
+		}
+
+		bool is_open() const {return reader.data != nullptr;}
+
+		//The file must outlive returned stream
+		stream get_stream() {return reader.get_stream();}
+	};
+#endif
+
+	struct RIFF
+	{
+		struct chunk;
+
+		//List of chunks with constant time lookup by ID and Form/List type,
+		//preserves order of chunks
+		struct chunk_list
+		{
+			std::vector<chunk*> chunks;
+			std::unordered_map<uint64_t, chunk*> index;
+
+			static uint64_t key(FOURCC id, FOURCC type) {return (uint64_t(type) << 32) | id;}
+
+			void add(chunk* c, FOURCC id, FOURCC type)
+			{
+				chunks.push_back(c);
+				//first chunk with given ID and type takes precedence
+				index.emplace(key(id, type), c);
+			}
+			//type is only set for "RIFF" and "LIST" chunks, zero for others
+			chunk* find(FOURCC id, FOURCC type = 0) const
+			{
+				auto it = index.find(key(id, type));
+				return (it != index.end())?it->second:nullptr;
+			}
+		};
+
+		struct chunk {
+			//A chunk ID identifies the type of data within the chunk.
+			FOURCC id;
+			//The size of the chunk data in bytes, excluding any pad byte.
+			DWORD size;
+			//The actual data plus a pad byte if req’d to word align.
+			std::unique_ptr<BYTE[]> data;
+			//Same as data, but pointing into the stream's memory instead of owning a copy,
+			//set when the stream provides direct access to its contents
+			const BYTE* view = nullptr;
+
+			//Form type for "RIFF" chunks or the list type for "LIST" chunks.
+			FOURCC type; 
+
+			//Data stream offset of the beginning of the chunk's data member,
+			//relative to the beginning of the data stream.
+			size_t data_offset;
+
+			//"RIFF" or "LIST" chunk containing this chunk, nullptr for top level chunks
+			chunk* parent = nullptr;
+			//Subchunks of "RIFF" and "LIST" chunks
+			chunk_list children;
+
+			bool is_list() const {return id == "RIFF"_FOURCC || id == "LIST"_FOURCC;}
+
+			//Direct subchunk lookup
+			chunk* find(FOURCC id, FOURCC type = 0) const {return children.find(id, type);}
+
+			//Calculate size padded to WORD
+			size_t get_padded_data_size() {return (size % 2)?(size+1):size;}
+
+			//Loaded data, either owned or viewed, nullptr if not loaded
+			const BYTE* get_data() const {return data?data.get():view;}
+
+			//Loads data from stream using saved offset,
+			//fails if the stream can't seek
+			bool load_data(stream& s)
+			{
+				size_t data_size = get_padded_data_size();
+				//don't copy if data can be accessed in place
+				if((view = static_cast<const BYTE*>(s.view(data_offset, data_size))))
+					return true;
+				if(!s.is_seekable()) return false;
+				size_t old_pos = s.getpos();
+				data = std::make_unique<BYTE[]>(data_size);
+				s.setpos(data_offset);			
+				if(s.read(data.get(), data_size) < data_size)
+				{
+					s.setpos(old_pos);
+					return false;
+				}
+				s.setpos(old_pos);
+				return true;
+			}
+
+			//Loads data at the current position of the stream and moves past it,
+			//doesn't need the stream to seek
+			bool read_data(stream& s)
+			{
+				size_t data_size = get_padded_data_size();
+				if((view = static_cast<const BYTE*>(s.view(data_offset, data_size))))
+					return s.skip(data_size) == data_size;
+				data = std::make_unique<BYTE[]>(data_size);
+				if(s.read(data.get(), data_size) < data_size)
+				{
+					data = nullptr;
+					return false;
+				}
+				return true;
+			}
+		};
+
+		//All chunks in order of appearance
+		std::vector<std::unique_ptr<chunk>> chunks;
+		//Top level chunks, root nodes of the chunk tree
+		chunk_list top_chunks;
+
+		//Top level chunk lookup
+		chunk* find(FOURCC id, FOURCC type = 0) const {return top_chunks.find(id, type);}
+
+		//Determines which chunks are loaded into memory during parsing,
+		//the rest can be loaded manually later
+		struct load_policy
+		{
+			//chunks with larger data are not loaded
+			size_t max_size = 0;
+			//subchunks of "RIFF" and "LIST" chunks of these types are not loaded
+			std::vector<FOURCC> excluded_types;
+
+			static load_policy none() {return {0, {}};}
+			static load_policy all() {return {SIZE_MAX, {}};}
+			//Loads small chunks only, never any of the sample data in "sdta" list
+			static load_policy metadata(size_t max_size = 1 << 24) {return {max_size, {"sdta"_FOURCC}};}
+
+			bool should_load(const chunk* c) const
+			{
+				//lists contain subchunks only, which are loaded by themselves
+				if(c->is_list() || c->size > max_size) return false;
+				for(auto p = c->parent; p; p = p->parent)
+				{
+					if(std::find(excluded_types.begin(), excluded_types.end(), p->type) != excluded_types.end())
+						return false;
+				}
+				return true;
+			}
+		};
+
+		//In RIFF, order of chunks matters.
+		//Chunks of RIFF or LIST type contain subchunks,
+		//and that's why following functions provide
+		//ability to start lookup from a certain index.
+		chunk* get_chunk_by_id(FOURCC id, size_t start_index = 0)
+		{
+			for(size_t i = start_index; i < chunks.size(); ++i)
+			{
+				if(chunks[i]->id == id) return chunks[i].get();
+			}
+			return nullptr;
+		}
+		chunk* get_chunk_by_type(FOURCC type, size_t start_index = 0)
+		{
+			for(size_t i = start_index; i < chunks.size(); ++i)
+			{
+				if(chunks[i]->type == type) return chunks[i].get();
+			}
+			return nullptr;
+		}
+		chunk* get_chunk_by_id_type(FOURCC id, FOURCC type, size_t start_index = 0)
+		{
+			for(size_t i = start_index; i < chunks.size(); ++i)
+			{
+				if(chunks[i]->id == id && chunks[i]->type == type) return chunks[i].get();
+			}
+			return nullptr;
+		}
+		size_t get_chunk_index_by_id(FOURCC id, size_t start_index = 0)
+		{
+			for(size_t i = start_index; i < chunks.size(); ++i)
+			{
+				if(chunks[i]->id == id) return i;
+			}
+			return -1;
+		}
+		size_t get_chunk_index_by_type(FOURCC type, size_t start_index = 0)
+		{
+			for(size_t i = start_index; i < chunks.size(); ++i)
+			{
+				if(chunks[i]->type == type) return i;
+			}
+			return -1;
+		}
+		size_t get_chunk_index_by_id_type(FOURCC id, FOURCC type, size_t start_index = 0)
+		{
+			for(size_t i = start_index; i < chunks.size(); ++i)
+			{
+				if(chunks[i]->id == id && chunks[i]->type == type) return i;
+			}
+			return -1;
+		}
+
+		//Collect chunks from binary data stream
+		//"load_data" flag dictates whether data is immedieately loaded
+		//during parsing or ignored to be loaded manually later
+		void parse(stream& s, bool load_data = false)
+		{
+			parse(s, load_data?load_policy::all():load_policy::none());
+		}
+
+		//Collect chunks from binary data stream and build the chunk tree,
+		//"policy" dictates which chunks are immediately loaded during parsing,
+		//the stream is read front to back, so it doesn't have to be seekable,
+		//but then chunks that aren't loaded can't be loaded later
+		void parse(stream& s, const load_policy& policy)
+		{
+			auto read_chunk_info = [](stream& s, chunk* c)->bool
+			{
+			#define read_and_check(src, dest, size)\
+			{\
+				if(src.read(dest, size) < size) return false;\
+			}
+				//Read FOURCC id
+				read_and_check(s, &c->id, sizeof(FOURCC));
+				//Read chunk data size (no padding)
+				read_and_check(s, &c->size, sizeof(DWORD));
+				if(c->is_list())
+				{
+					//Read Form/List Type
+					read_and_check(s, &c->type, sizeof(FOURCC));
+					//save stream position to read data when needed
+					c->data_offset = s.getpos();
+					c->data = nullptr;
+					//don't read any data, because those chunks
+					//are special and only contain subchunks
+				}
+				else
+				{
+					c->type = 0;
+					//save stream position to read data when needed
+					c->data_offset = s.getpos();
+					c->data = nullptr;
+					//data field is loaded or skipped by the caller
+				}
+				return true;
+			#undef read_and_check
+			};
+
+			//currently open "RIFF" and "LIST" chunks
+			std::vector<chunk*> lists;
+			auto list_end = [](chunk* c)->size_t
+			{
+				//list size includes Form/List type
+				return c->data_offset - sizeof(FOURCC) + c->size;
+			};
+
+			while(true)
+			{
+				//close lists ending before the next chunk
+				size_t pos = s.getpos();
+				while(!lists.empty() && list_end(lists.back()) <= pos)
+					lists.pop_back();
+
+				auto c = std::make_unique<chunk>();
+				if(!read_chunk_info(s, c.get()))
+					break;
+				c->parent = lists.empty()?nullptr:lists.back();
+				if(!c->is_list())
+				{
+					//data is loaded or skipped in order, so that the stream never seeks
+					if(policy.should_load(c.get()))
+					{
+						if(!c->read_data(s)) break;
+					}
+					else if(s.skip(c->get_padded_data_size()) < c->get_padded_data_size())
+						break;
+				}
+				(c->parent?c->parent->children:top_chunks).add(c.get(), c->id, c->type);
+				if(c->is_list())
+					lists.push_back(c.get());
+				chunks.emplace_back(std::move(c));
+			}
+
+#ifdef RIFF_DEBUG
+			for(auto& c : chunks)
+			{
+				std::cout << "//=======================" << std::endl;
+				std::cout << "ID:" << FOURCC_to_string(c->id) << std::endl;
+				std::cout << "Type:" << FOURCC_to_string(c->type) << std::endl;
+				std::cout << "Size:" << c->size << std::endl;
+				std::cout << "Data offset:" << c->data_offset << std::endl;
+			}
+#endif
+		}
+	};
+}
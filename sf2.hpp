@@ -1,2949 +1,6151 @@
-#pragma once
-//if long comments quoting standard bother you,
-//use /\*(.|\n)*?\*/ regex command to remove them
-
-#include <string>
-#include <vector>
-#include <cstdint>
-#include <algorithm>
-#include <cmath>
-
-#include <fstream>
-
-#ifndef M_TAU
-#define M_TAU 6.28318530717958647692
-#endif
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include "RIFF.hpp"
-#include "DynamicPool.hpp"
-
-#ifdef SF2_DEBUG
-#define SF2_DEBUG_OUTPUT(msg) {printf(msg);}
-#else
-#define SF2_DEBUG_OUTPUT(msg) {}
-#endif
-
-namespace SF2
-{
-	typedef uint8_t byte;
-	typedef uint16_t word;
-	typedef uint32_t doubleword;
-	typedef int8_t CHAR;
-	typedef uint8_t BYTE;
-	typedef int16_t SHORT;
-	typedef uint16_t WORD;
-	typedef uint32_t DWORD;
-
-	double fastPow(double a, double b) {
-		union {
-			double d;
-			int x[2];
-		} u = { a };
-		u.x[1] = (int)(b * (u.x[1] - 1072632447) + 1072632447);
-		u.x[0] = 0;
-		return u.d;
-	}
-
-	inline float cents_to_hertz(float cents)
-	{
-		return std::pow(2.0f, cents / 1200.0f);
-	}
-	inline float hertz_to_cents(float hz)
-	{
-		return 1200.0f * std::log2(hz);
-	}
-	inline float decibels_to_gain(float db)
-	{
-		//return (db > -100.0f)?std::pow(10.0f, db * 0.05f):0.0f;		
-		return (db > -100.0f)?fastPow(10.0f, db * 0.05f):0.0f;
-	}
-	inline float gain_to_decibels(float gain)
-	{
-		return (gain <= 0.00001f)?-100.0f:(20.0f * std::log10(gain));
-	}
-	inline float calc_interval_cents(float hz1, float hz2)
-	{
-		return hertz_to_cents(hz2/hz1);
-	}
-	inline float apply_interval_cents(float hz, float cents)
-	{
-		return hz*cents_to_hertz(cents);
-	}
-	float timecents_to_seconds(float timecents)
-	{		
-		//return (timecents == -32768)?0.000001f:std::pow(2.0f, timecents / 1200.0f);
-		return (timecents <= -12000)?0.001f:std::pow(2.0f, timecents / 1200.0f);
-	}
-	float seconds_to_timecents(float seconds)
-	{
-		return 1200.0f*std::log2(seconds);
-	}
-	inline void constant_power_pan(float& factor_L, float& factor_R, float pan)
-	{
-		//constant is sqrt(2.0)/2.0
-		constexpr const float sqrt2_2 = 0.70710678f;
-		pan = pan*M_TAU*0.125f;
-		factor_L = sqrt2_2*(cos(pan)-sin(pan));
-		factor_R = sqrt2_2*(cos(pan)+sin(pan));
-	}
-	inline float clamp_panning(float pan)
-	{
-		pan = std::max(std::min(pan, 2.0f), -2.0f);
-		pan = (pan > 1.0f)?(2.0f-pan):((pan < -1.0f)?-(-2.0f+pan):pan);
-		return pan;
-	}
-	inline float lerp(float a, float b, float f)
-	{
-		return (a * (1.0f - f)) + (b * f);
-	}
-	//algebraically simplified algorithm, less precise
-	inline float fast_lerp(float a, float b, float f)
-	{
-		return a + f * (b - a);
-	}
-	//input must be in range [0, 127]
-	//might as well precompute a table for it later
-	//TODO: write a program to precompute 127 values for convex curve
-	inline float convex_curve(float input)
-	{
-		if(input == 0.0f) return 0.0f;//mathematically undefined
-		return 1.0f+20.0f*std::log10((input*input)/(127.0f*127.0f))/96.0f;
-	}
-	inline float concave_curve(float input)
-	{
-		return 1.0f-convex_curve(127.0f-input);
-	}
-
-	//SoundFont2-structured RIFF
-	//I was planning to use this for editing, but...
-	struct RIFF_SoundFont2
-	{
-		//Supplemental Information
-		struct INFO_chunk
-		{
-			RIFF::RIFF::chunk* ifil;
-			//Refers to the target Sound Engine
-			RIFF::RIFF::chunk* isng;
-			//Refers to the Sound Font Bank Name
-			RIFF::RIFF::chunk* INAM;
-			//Refers to the Sound ROM Name
-			RIFF::RIFF::chunk* irom;
-			//Refers to the Sound ROM Version
-			RIFF::RIFF::chunk* iver;
-			//Refers to the Date of Creation of the Bank
-			RIFF::RIFF::chunk* ICRD;
-			//Sound Designers and Engineers for the Bank
-			RIFF::RIFF::chunk* IENG;
-			//Product for which the Bank was intended
-			RIFF::RIFF::chunk* IPRD;
-			//Contains any Copyright message
-			RIFF::RIFF::chunk* ICOP;
-			//Contains any Comments on the Bank
-			RIFF::RIFF::chunk* ICMT;
-			//The SoundFont tools used to create and alter the bank
-			RIFF::RIFF::chunk* ISFT;
-		};
-		INFO_chunk INFO;
-
-		//The Sample Binary Data
-		struct sdta_chunk
-		{
-			//The Digital Audio Samples for the upper 16 bits
-			RIFF::RIFF::chunk* smpl;
-			//The Digital Audio Samples for the lower 8 bits
-			RIFF::RIFF::chunk* sm24;
-		};
-		sdta_chunk sdta;
-
-		//The Preset, Instrument, and Sample Header data
-		struct pdta_chunk
-		{
-			//The Preset Headers
-			RIFF::RIFF::chunk* phdr;
-			//The Preset Index list
-			RIFF::RIFF::chunk* pbag;
-			//The Preset Modulator list
-			RIFF::RIFF::chunk* pmod;
-			//The Preset Generator list
-			RIFF::RIFF::chunk* pgen;
-			//The Instrument Names and Indices
-			RIFF::RIFF::chunk* inst;
-			//The Instrument Index list
-			RIFF::RIFF::chunk* ibag;
-			//The Instrument Modulator list
-			RIFF::RIFF::chunk* imod;
-			//The Instrument Generator list
-			RIFF::RIFF::chunk* igen;
-			//The Sample Headers
-			RIFF::RIFF::chunk* shdr;
-		};
-		pdta_chunk pdta;
-
-		bool structurally_unsound = false;
-
-		RIFF_SoundFont2(RIFF::RIFF* riff)
-		{
-#define cond_check(cond)\
-			{\
-				if(cond)\
-				{\
-					structurally_unsound = true;\
-					return;\
-				}\
-			}
-#define get_subchunk(chunk, riff, id, start_index)\
-			{\
-				chunk.id = riff->get_chunk_by_id(\
-					RIFF::string_to_FOURCC(#id),\
-					start_index\
-				);\
-			}
-			auto& chunks = riff->chunks;
-			cond_check(chunks.empty());
-			//Check RIFF chunk, must be first
-			cond_check(!RIFF::FOURCC_equals(chunks[0]->id, "RIFF") || !RIFF::FOURCC_equals(chunks[0]->type, "sfbk"));
-			//Get INFO-list chunk
-			auto INFO_list_index = riff->get_chunk_index_by_id_type(
-				RIFF::string_to_FOURCC("LIST"),
-				RIFF::string_to_FOURCC("INFO")
-			);
-			//Check INFO-list chunk, must exist
-			cond_check(INFO_list_index == -1);
-			//Get INFO-list subchunks
-			get_subchunk(INFO, riff, ifil, INFO_list_index);
-			get_subchunk(INFO, riff, isng, INFO_list_index);
-			get_subchunk(INFO, riff, INAM, INFO_list_index);
-			get_subchunk(INFO, riff, irom, INFO_list_index);
-			get_subchunk(INFO, riff, iver, INFO_list_index);
-			get_subchunk(INFO, riff, ICRD, INFO_list_index);
-			get_subchunk(INFO, riff, IENG, INFO_list_index);
-			get_subchunk(INFO, riff, IPRD, INFO_list_index);
-			get_subchunk(INFO, riff, ICOP, INFO_list_index);
-			get_subchunk(INFO, riff, ICMT, INFO_list_index);
-			get_subchunk(INFO, riff, ISFT, INFO_list_index);
-			//Check mandatory subchunks
-			cond_check(!INFO.ifil);
-
-			//Get sdta chunk
-			auto sdta_index = riff->get_chunk_index_by_id_type(
-				RIFF::string_to_FOURCC("LIST"),
-				RIFF::string_to_FOURCC("sdta")
-			);
-			//Check sdta chunk, must exist
-			cond_check(sdta_index == -1);
-			//Get sdta subchunks
-			get_subchunk(sdta, riff, smpl, sdta_index);
-			get_subchunk(sdta, riff, sm24, sdta_index);
-
-			//Get pdta chunk
-			auto pdta_index = riff->get_chunk_index_by_id_type(
-				RIFF::string_to_FOURCC("LIST"),
-				RIFF::string_to_FOURCC("sdta")
-			);
-			//Check pdta chunk, must exist
-			cond_check(pdta_index == -1);
-			//Get pdta subchunks
-			get_subchunk(pdta, riff, phdr, pdta_index);
-			get_subchunk(pdta, riff, pbag, pdta_index);
-			get_subchunk(pdta, riff, pmod, pdta_index);
-			get_subchunk(pdta, riff, pgen, pdta_index);
-			get_subchunk(pdta, riff, inst, pdta_index);
-			get_subchunk(pdta, riff, ibag, pdta_index);
-			get_subchunk(pdta, riff, imod, pdta_index);
-			get_subchunk(pdta, riff, igen, pdta_index);
-			get_subchunk(pdta, riff, shdr, pdta_index);
-
-			//Check chunk sizes
-			cond_check(pdta.phdr->size % 38);
-			cond_check(pdta.pbag->size % 4);
-			cond_check(pdta.pmod->size % 10);
-			cond_check(pdta.pgen->size % 4);
-			cond_check(pdta.inst->size % 22);
-			cond_check(pdta.ibag->size % 4);
-			cond_check(pdta.imod->size % 10);
-			cond_check(pdta.igen->size % 4);
-			cond_check(pdta.shdr->size % 46);
-
-#undef check
-#undef get_subchunk
-		}
-	};
-
-	struct SoundFont2
-	{
-		struct rangesType
-		{
-			BYTE byLo;
-			BYTE byHi;
-
-			//expand
-			inline rangesType& operator+=(const rangesType& rhs)
-			{
-				byLo = std::min(byLo, rhs.byLo);
-				byHi = std::max(byHi, rhs.byHi);
-				return *this;
-			}
-			//expand
-			friend inline rangesType operator+(rangesType lhs, const rangesType& rhs)
-			{
-				lhs += rhs;
-				return lhs;
-			}
-			//intersect
-			inline rangesType& operator*=(const rangesType& rhs)
-			{
-				byLo = std::max(byLo, rhs.byLo);
-				byHi = std::min(byHi, rhs.byHi);
-				return *this;
-			}
-			//intersect
-			friend inline rangesType operator*(rangesType lhs, const rangesType& rhs)
-			{
-				lhs *= rhs;
-				return lhs;
-			}
-		};
-		typedef union
-		{
-			rangesType ranges;
-			SHORT shAmount;
-			WORD wAmount;
-		} genAmountType; 
-		typedef enum
-		{
-			monoSample = 1,
-			rightSample = 2,
-			leftSample = 4,
-			linkedSample = 8,
-			RomMonoSample = 0x8001,
-			RomRightSample = 0x8002,
-			RomLeftSample = 0x8004,
-			RomLinkedSample = 0x8008
-		} SFSampleLink;
-		inline bool IsSampleROM(SFSampleLink type) {return type & 0xFFF0;};
-		inline bool CheckSampleLinkType(SFSampleLink type)
-		{
-			return (type >= 1 && type <= 8) || (type >= 0x8001 && type <= 0x8008);
-		};
-
-		struct SFModulator
-		{
-			WORD enumeration;
-		};
-		struct SFGenerator
-		{
-			enum class GenType : WORD
-			{
-				/*The offset, in sample data points, beyond the Start sample header parameter to the
-				first sample data point to be played for this instrument. For example, if Start were 7
-				and startAddrOffset were 2, the first sample data point played would be sample data
-				point 9. */
-				startAddrsOffset = 0,
-
-				/*The offset, in sample sample data points, beyond the End sample header parameter to
-				the last sample data point to be played for this instrument. For example, if End were
-				17 and endAddrOffset were -2, the last sample data point played would be sample
-				data point 15.*/
-				endAddrsOffset = 1,
-
-				/*The offset, in sample data points, beyond the Startloop sample header parameter to
-				the first sample data point to be repeated in the loop for this instrument. For
-				example, if Startloop were 10 and startloopAddrsOffset were -1, the first repeated
-				loop sample data point would be sample data point 9.*/
-				startloopAddrsOffset = 2,
-
-				/*The offset, in sample data points, beyond the Endloop sample header parameter to
-				the sample data point considered equivalent to the Startloop sample data point for the
-				loop for this instrument. For example, if Endloop were 15 and endloopAddrsOffset
-				were 2, sample data point 17 would be considered equivalent to the Startloop sample
-				data point, and hence sample data point 16 would effectively precede Startloop
-				during looping. */
-				endloopAddrsOffset = 3,
-
-				/*The offset, in 32768 sample data point increments beyond the Start sample header
-				parameter and the first sample data point to be played in this instrument. This
-				parameter is added to the startAddrsOffset parameter. For example, if Start were 5, 
-				startAddrsOffset were 3 and startAddrsCoarseOffset were 2, the first sample data
-				point played would be sample data point 65544. */
-				startAddrsCoarseOffset = 4,
-
-				/*This is the degree, in cents, to which a full scale excursion of the Modulation LFO
-				will influence pitch. A positive value indicates a positive LFO excursion increases
-				pitch; a negative value indicates a positive excursion decreases pitch. Pitch is always
-				modified logarithmically, that is the deviation is in cents, semitones, and octaves
-				rather than in Hz. For example, a value of 100 indicates that the pitch will first rise 1
-				semitone, then fall one semitone. */
-				modLfoToPitch = 5,
-
-				/*This is the degree, in cents, to which a full scale excursion of the Vibrato LFO will
-				influence pitch. A positive value indicates a positive LFO excursion increases pitch;
-				a negative value indicates a positive excursion decreases pitch. Pitch is always
-				modified logarithmically, that is the deviation is in cents, semitones, and octaves
-				rather than in Hz. For example, a value of 100 indicates that the pitch will first rise 1
-				semitone, then fall one semitone. */
-				vibLfoToPitch = 6,
-
-				/*This is the degree, in cents, to which a full scale excursion of the Modulation
-				Envelope will influence pitch. A positive value indicates an increase in pitch; a
-				negative value indicates a decrease in pitch. Pitch is always modified
-				logarithmically, that is the deviation is in cents, semitones, and octaves rather than in
-				Hz. For example, a value of 100 indicates that the pitch will rise 1 semitone at the
-				envelope peak. */
-				modEnvToPitch = 7,
-
-				/*This is the cutoff and resonant frequency of the lowpass filter in absolute cent units.
-				The lowpass filter is defined as a second order resonant pole pair whose pole
-				frequency in Hz is defined by the Initial Filter Cutoff parameter. When the cutoff
-				frequency exceeds 20kHz and the Q (resonance) of the filter is zero, the filter does
-				not affect the signal. */
-				initialFilterFc = 8,
-
-				/*This is the height above DC gain in centibels which the filter resonance exhibits at
-				the cutoff frequency. A value of zero or less indicates the filter is not resonant; the
-				gain at the cutoff frequency (pole angle) may be less than zero when zero is
-				specified. The filter gain at DC is also affected by this parameter such that the gain
-				at DC is reduced by half the specified gain. For example, for a value of 100, the
-				filter gain at DC would be 5 dB below unity gain, and the height of the resonant peak
-				would be 10 dB above the DC gain, or 5 dB above unity gain. Note also that if
-				initialFilterQ is set to zero or less and the cutoff frequency exceeds 20 kHz, then the
-				filter response is flat and unity gain. */
-				initialFilterQ = 9,
-
-				/*This is the degree, in cents, to which a full scale excursion of the Modulation LFO
-				will influence filter cutoff frequency. A positive number indicates a positive LFO
-				excursion increases cutoff frequency; a negative number indicates a positive
-				excursion decreases cutoff frequency. Filter cutoff frequency is always modified
-				logarithmically, that is the deviation is in cents, semitones, and octaves rather than in
-				Hz. For example, a value of 1200 indicates that the cutoff frequency will first rise 1
-				octave, then fall one octave. */
-				modLfoToFilterFc = 10,
-
-				/*This is the degree, in cents, to which a full scale excursion of the Modulation
-				Envelope will influence filter cutoff frequency. A positive number indicates an
-				increase in cutoff frequency; a negative number indicates a decrease in filter cutoff
-				frequency. Filter cutoff frequency is always modified logarithmically, that is the
-				deviation is in cents, semitones, and octaves rather than in Hz. For example, a value
-				of 1000 indicates that the cutoff frequency will rise one octave at the envelope attack
-				peak. */
-				modEnvToFilterFc = 11,
-
-				/*The offset, in 32768 sample data point increments beyond the End sample header
-				parameter and the last sample data point to be played in this instrument. This
-				parameter is added to the endAddrsOffset parameter. For example, if End were
-				65536, startAddrsOffset were -3 and startAddrsCoarseOffset were -1, the last sample
-				data point played would be sample data point 32765. */
-				endAddrsCoarseOffset = 12,
-
-				/*This is the degree, in centibels, to which a full scale excursion of the Modulation
-				LFO will influence volume. A positive number indicates a positive LFO excursion
-				increases volume; a negative number indicates a positive excursion decreases
-				volume. Volume is always modified logarithmically, that is the deviation is in
-				decibels rather than in linear amplitude. For example, a value of 100 indicates that
-				the volume will first rise ten dB, then fall ten dB. */
-				modLfoToVolume = 13,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				unused1 = 14,
-
-				/*This is the degree, in 0.1% units, to which the audio output of the note is sent to the
-				chorus effects processor. A value of 0% or less indicates no signal is sent from this
-				note; a value of 100% or more indicates the note is sent at full level. Note that this
-				parameter has no effect on the amount of this signal sent to the dry or unprocessed
-				portion of the output. For example, a value of 250 indicates that the signal is sent at
-				25% of full level (attenuation of 12 dB from full level) to the chorus effects
-				processor. */
-				chorusEffectsSend = 15,
-
-				/*This is the degree, in 0.1% units, to which the audio output of the note is sent to the
-				reverb effects processor. A value of 0% or less indicates no signal is sent from this
-				note; a value of 100% or more indicates the note is sent at full level. Note that this
-				parameter has no effect on the amount of this signal sent to the dry or unprocessed
-				portion of the output. For example, a value of 250 indicates that the signal is sent at
-				25% of full level (attenuation of 12 dB from full level) to the reverb effects
-				processor. */
-				reverbEffectsSend = 16,
-
-				/*This is the degree, in 0.1% units, to which the dry audio output of the note is
-				positioned to the left or right output. A value of -50% or less indicates the signal is
-				sent entirely to the left output and not sent to the right output; a value of +50% or
-				more indicates the note is sent entirely to the right and not sent to the left. A value of
-				zero places the signal centered between left and right. For example, a value of -250
-				indicates that the signal is sent at 75% of full level to the left output and 25% of full
-				level to the right output. */
-				pan = 17,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				unused2 = 18,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				unused3 = 19,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				unused4 = 20,
-
-				/*This is the delay time, in absolute timecents, from key on until the Modulation LFO
-				begins its upward ramp from zero value. A value of 0 indicates a 1 second delay. A
-				negative value indicates a delay less than one second and a positive value a delay
-				longer than one second. The most negative number (-32768) conventionally
-				indicates no delay. For example, a delay of 10 msec would be 1200log2(.01) = -
-				7973. */
-				delayModLFO = 21,
-
-				/*This is the frequency, in absolute cents, of the Modulation LFOs triangular period.
-				A value of zero indicates a frequency of 8.176 Hz. A negative value indicates a
-				frequency less than 8.176 Hz; a positive value a frequency greater than 8.176 Hz.
-				For example, a frequency of 10 mHz would be 1200log2(.01/8.176) = -11610. */
-				freqModLFO = 22,
-
-				/*This is the delay time, in absolute timecents, from key on until the Vibrato LFO
-				begins its upward ramp from zero value. A value of 0 indicates a 1 second delay. A
-				negative value indicates a delay less than one second; a positive value a delay longer
-				than one second. The most negative number (-32768) conventionally indicates no
-				delay. For example, a delay of 10 msec would be 1200log2(.01) = -7973. */
-				delayVibLFO = 23,
-
-				/*This is the frequency, in absolute cents, of the Vibrato LFOs triangular period. A
-				value of zero indicates a frequency of 8.176 Hz. A negative value indicates a
-				frequency less than 8.176 Hz; a positive value a frequency greater than 8.176 Hz.
-				For example, a frequency of 10 mHz would be 1200log2(.01/8.176) = -11610. */
-				freqVibLFO = 24,
-
-				/*This is the delay time, in absolute timecents, between key on and the start of the
-				attack phase of the Modulation envelope. A value of 0 indicates a 1 second delay. A
-				negative value indicates a delay less than one second; a positive value a delay longer
-				than one second. The most negative number (-32768) conventionally indicates no
-				delay. For example, a delay of 10 msec would be 1200log2(.01) = -7973. */
-				delayModEnv = 25,
-
-				/*This is the time, in absolute timecents, from the end of the Modulation Envelope
-				Delay Time until the point at which the Modulation Envelope value reaches its peak.
-				Note that the attack is convex; the curve is nominally such that when applied to a
-				decibel or semitone parameter, the result is linear in amplitude or Hz respectively. A
-				value of 0 indicates a 1 second attack time. A negative value indicates a time less
-				than one second; a positive value a time longer than one second. The most negative
-				number (-32768) conventionally indicates instantaneous attack. For example, an
-				attack time of 10 msec would be 1200log2(.01) = -7973. */
-				attackModEnv = 26,
-
-				/*This is the time, in absolute timecents, from the end of the attack phase to the entry
-				into decay phase, during which the envelope value is held at its peak. A value of 0
-				indicates a 1 second hold time. A negative value indicates a time less than one
-				second; a positive value a time longer than one second. The most negative number (-
-				32768) conventionally indicates no hold phase. For example, a hold time of 10 msec
-				would be 1200log2(.01) = -7973. */
-				holdModEnv = 27,
-
-				/*This is the time, in absolute timecents, for a 100% change in the Modulation
-				Envelope value during decay phase. For the Modulation Envelope, the decay phase
-				linearly ramps toward the sustain level. If the sustain level were zero, the
-				Modulation Envelope Decay Time would be the time spent in decay phase. A value
-				of 0 indicates a 1 second decay time for a zero-sustain level. A negative value
-				indicates a time less than one second; a positive value a time longer than one second.
-				For example, a decay time of 10 msec would be 1200log2(.01) = -7973. */
-				decayModEnv = 28,
-
-				/*This is the decrease in level, expressed in 0.1% units, to which the Modulation
-				Envelope value ramps during the decay phase. For the Modulation Envelope, the
-				sustain level is properly expressed in percent of full scale. Because the volume
-				envelope sustain level is expressed as an attenuation from full scale, the sustain level
-				is analogously expressed as a decrease from full scale. A value of 0 indicates the
-				sustain level is full level; this implies a zero duration of decay phase regardless of
-				decay time. A positive value indicates a decay to the corresponding level. Values
-				less than zero are to be interpreted as zero; values above 1000 are to be interpreted as
-				1000. For example, a sustain level which corresponds to an absolute value 40% of
-				peak would be 600. */
-				sustainModEnv = 29,
-
-				/*This is the time, in absolute timecents, for a 100% change in the Modulation
-				Envelope value during release phase. For the Modulation Envelope, the release
-				phase linearly ramps toward zero from the current level. If the current level were
-				full scale, the Modulation Envelope Release Time would be the time spent in release
-				phase until zero value were reached. A value of 0 indicates a 1 second decay time 
-				for a release from full level. A negative value indicates a time less than one second;
-				a positive value a time longer than one second. For example, a release time of 10
-				msec would be 1200log2(.01) = -7973. */
-				releaseModEnv = 30,
-
-				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
-				Modulation Envelope is decreased by increasing MIDI key number. The hold time
-				at key number 60 is always unchanged. The unit scaling is such that a value of 100
-				provides a hold time which tracks the keyboard; that is, an upward octave causes the
-				hold time to halve. For example, if the Modulation Envelope Hold Time were -7973
-				= 10 msec and the Key Number to Mod Env Hold were 50 when key number 36 was
-				played, the hold time would be 20 msec. */
-				keynumToModEnvHold = 31,
-
-				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
-				Modulation Envelope is decreased by increasing MIDI key number. The hold time
-				at key number 60 is always unchanged. The unit scaling is such that a value of 100
-				provides a hold time that tracks the keyboard; that is, an upward octave causes the
-				hold time to halve. For example, if the Modulation Envelope Hold Time were -7973
-				= 10 msec and the Key Number to Mod Env Hold were 50 when key number 36 was
-				played, the hold time would be 20 msec. */
-				keynumToModEnvDecay = 32,
-
-				/*This is the delay time, in absolute timecents, between key on and the start of the
-				attack phase of the Volume envelope. A value of 0 indicates a 1 second delay. A
-				negative value indicates a delay less than one second; a positive value a delay longer
-				than one second. The most negative number (-32768) conventionally indicates no
-				delay. For example, a delay of 10 msec would be 1200log2(.01) = -7973. */
-				delayVolEnv = 33,
-
-				/*This is the time, in absolute timecents, from the end of the Volume Envelope Delay
-				Time until the point at which the Volume Envelope value reaches its peak. Note that
-				the attack is convex; the curve is nominally such that when applied to the decibel
-				volume parameter, the result is linear in amplitude. A value of 0 indicates a 1 second
-				attack time. A negative value indicates a time less than one second; a positive value
-				a time longer than one second. The most negative number (-32768) conventionally
-				indicates instantaneous attack. For example, an attack time of 10 msec would be
-				1200log2(.01) = -7973. */
-				attackVolEnv = 34,
-
-				/*This is the time, in absolute timecents, from the end of the attack phase to the entry
-				into decay phase, during which the Volume envelope value is held at its peak. A
-				value of 0 indicates a 1 second hold time. A negative value indicates a time less than
-				one second; a positive value a time longer than one second. The most negative
-				number (-32768) conventionally indicates no hold phase. For example, a hold time
-				of 10 msec would be 1200log2(.01) = -7973. */
-				holdVolEnv = 35,
-
-				/*This is the time, in absolute timecents, for a 100% change in the Volume Envelope
-				value during decay phase. For the Volume Envelope, the decay phase linearly ramps
-				toward the sustain level, causing a constant dB change for each time unit. If the
-				sustain level were -100dB, the Volume Envelope Decay Time would be the time
-				spent in decay phase. A value of 0 indicates a 1-second decay time for a zero-sustain
-				level. A negative value indicates a time less than one second; a positive value a time
-				longer than one second. For example, a decay time of 10 msec would be
-				1200log2(.01) = -7973. */
-				decayVolEnv = 36,
-
-				/*This is the decrease in level, expressed in centibels, to which the Volume Envelope
-				value ramps during the decay phase. For the Volume Envelope, the sustain level is
-				best expressed in centibels of attenuation from full scale. A value of 0 indicates the
-				sustain level is full level; this implies a zero duration of decay phase regardless of
-				decay time. A positive value indicates a decay to the corresponding level. Values
-				less than zero are to be interpreted as zero; conventionally 1000 indicates full 
-				attenuation. For example, a sustain level which corresponds to an absolute value
-				12dB below of peak would be 120. */
-				sustainVolEnv = 37,
-
-				/*This is the time, in absolute timecents, for a 100% change in the Volume Envelope
-				value during release phase. For the Volume Envelope, the release phase linearly
-				ramps toward zero from the current level, causing a constant dB change for each
-				time unit. If the current level were full scale, the Volume Envelope Release Time
-				would be the time spent in release phase until 100dB attenuation were reached. A
-				value of 0 indicates a 1-second decay time for a release from full level. A negative
-				value indicates a time less than one second; a positive value a time longer than one
-				second. For example, a release time of 10 msec would be 1200log2(.01) = -7973. */
-				releaseVolEnv = 38,
-
-				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
-				Volume Envelope is decreased by increasing MIDI key number. The hold time at
-				key number 60 is always unchanged. The unit scaling is such that a value of 100
-				provides a hold time which tracks the keyboard; that is, an upward octave causes the
-				hold time to halve. For example, if the Volume Envelope Hold Time were -7973 =
-				10 msec and the Key Number to Vol Env Hold were 50 when key number 36 was
-				played, the hold time would be 20 msec. */
-				keynumToVolEnvHold = 39,
-
-				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
-				Volume Envelope is decreased by increasing MIDI key number. The hold time at
-				key number 60 is always unchanged. The unit scaling is such that a value of 100
-				provides a hold time that tracks the keyboard; that is, an upward octave causes the
-				hold time to halve. For example, if the Volume Envelope Hold Time were -7973 =
-				10 msec and the Key Number to Vol Env Hold were 50 when key number 36 was
-				played, the hold time would be 20 msec. */
-				keynumToVolEnvDecay = 40,
-
-				/*This is the index into the INST sub-chunk providing the instrument to be used for the
-				current preset zone. A value of zero indicates the first instrument in the list. The
-				value should never exceed two less than the size of the instrument list. The
-				instrument enumerator is the terminal generator for PGEN zones. As such, it should
-				only appear in the PGEN sub-chunk, and it must appear as the last generator
-				enumerator in all but the global preset zone. */
-				instrument = 41,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				reserved1 = 42,
-
-				/*This is the minimum and maximum MIDI key number values for which this preset
-				zone or instrument zone is active. The LS byte indicates the highest and the MS byte
-				the lowest valid key. The keyRange enumerator is optional, but when it does appear,
-				it must be the first generator in the zone generator list. */
-				keyRange = 43,
-
-				/*This is the minimum and maximum MIDI velocity values for which this preset zone
-				or instrument zone is active. The LS byte indicates the highest and the MS byte the
-				lowest valid velocity. The velRange enumerator is optional, but when it does appear,
-				it must be preceded only by keyRange in the zone generator list. */
-				velRange = 44,
-
-				/*The offset, in 32768 sample data point increments beyond the Startloop sample
-				header parameter and the first sample data point to be repeated in this instruments
-				loop. This parameter is added to the startloopAddrsOffset parameter. For example,
-				if Startloop were 5, startloopAddrsOffset were 3 and startAddrsCoarseOffset were 2,
-				the first sample data point in the loop would be sample data point 65544. */
-				startloopAddrsCoarseOffset = 45,
-
-				/*This enumerator forces the MIDI key number to effectively be interpreted as the
-				value given. This generator can only appear at the instrument level. Valid values are
-				from 0 to 127. */
-				keynum = 46,
-
-				/*This enumerator forces the MIDI velocity to effectively be interpreted as the value
-				given. This generator can only appear at the instrument level. Valid values are from
-				0 to 127. */
-				velocity = 47,
-
-				/*This is the attenuation, in centibels, by which a note is attenuated below full scale. A
-				value of zero indicates no attenuation; the note will be played at full scale. For
-				example, a value of 60 indicates the note will be played at 6 dB below full scale for
-				the note. */
-				initialAttenuation = 48,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				reserved2 = 49,
-
-				/*The offset, in 32768 sample data point increments beyond the Endloop sample
-				header parameter to the sample data point considered equivalent to the Startloop
-				sample data point for the loop for this instrument. This parameter is added to the
-				endloopAddrsOffset parameter. For example, if Endloop were 5,
-				endloopAddrsOffset were 3 and endAddrsCoarseOffset were 2, sample data point
-				65544 would be considered equivalent to the Startloop sample data point, and hence
-				sample data point 65543 would effectively precede Startloop during looping. */
-				endloopAddrsCoarseOffset = 50,
-
-				/*This is a pitch offset, in semitones, which should be applied to the note. A positive
-				value indicates the sound is reproduced at a higher pitch; a negative value indicates a
-				lower pitch. For example, a Coarse Tune value of -4 would cause the sound to be
-				reproduced four semitones flat. */
-				coarseTune = 51,
-
-				/*This is a pitch offset, in cents, which should be applied to the note. It is additive
-				with coarseTune. A positive value indicates the sound is reproduced at a higher
-				pitch; a negative value indicates a lower pitch. For example, a Fine Tuning value of -
-				5 would cause the sound to be reproduced five cents flat. */
-				fineTune = 52,
-
-				/*This is the index into the SHDR sub-chunk providing the sample to be used for the
-				current instrument zone. A value of zero indicates the first sample in the list. The
-				value should never exceed two less than the size of the sample list. The sampleID
-				enumerator is the terminal generator for IGEN zones. As such, it should only appear
-				in the IGEN sub-chunk, and it must appear as the last generator enumerator in all but
-				the global zone. */
-				sampleID = 53,
-
-				/*This enumerator indicates a value which gives a variety of Boolean flags describing
-				the sample for the current instrument zone. The sampleModes should only appear in
-				the IGEN sub-chunk, and should not appear in the global zone. The two LS bits of
-				the value indicate the type of loop in the sample: 0 indicates a sound reproduced with
-				no loop, 1 indicates a sound which loops continuously, 2 is unused but should be
-				interpreted as indicating no loop, and 3 indicates a sound which loops for the
-				duration of key depression then proceeds to play the remainder of the sample. */
-				sampleModes = 54,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				reserved3 = 55,
-
-				/*This parameter represents the degree to which MIDI key number influences pitch. A
-				value of zero indicates that MIDI key number has no effect on pitch; a value of 100
-				represents the usual tempered semitone scale. */
-				scaleTuning = 56,
-
-				/*This parameter provides the capability for a key depression in a given instrument to
-				terminate the playback of other instruments. This is particularly useful for
-				percussive instruments such as a hi-hat cymbal. An exclusive class value of zero
-				indicates no exclusive class; no special action is taken. Any other value indicates
-				that when this note is initiated, any other sounding note with the same exclusive class
-				value should be rapidly terminated. The exclusive class generator can only appear at
-				the instrument level. The scope of the exclusive class is the entire preset. In other 
-				words, any other instrument zone within the same preset holding a corresponding
-				exclusive class will be terminated. */
-				exclusiveClass = 57,
-
-				/*This parameter represents the MIDI key number at which the sample is to be played
-				back at its original sample rate. If not present, or if present with a value of -1, then
-				the sample header parameter Original Key is used in its place. If it is present in the
-				range 0-127, then the indicated key number will cause the sample to be played back
-				at its sample header Sample Rate. For example, if the sample were a recording of a
-				piano middle C (Original Key = 60) at a sample rate of 22.050 kHz, and Root Key
-				were set to 69, then playing MIDI key number 69 (A above middle C) would cause a
-				piano note of pitch middle C to be heard.*/
-				overridingRootKey = 58,
-
-				/*Unused, reserved. Should be ignored if encountered. */
-				unused5 = 59,
-
-				/*Unused, reserved. Should be ignored if encountered. Unique name provides value
-				to end of defined list. */
-				endOper = 60
-			};
-			GenType enumeration;
-
-			friend inline bool operator==(const SFGenerator& lhs, const SFGenerator& rhs)
-			{
-				return lhs.enumeration == rhs.enumeration;
-			}
-			friend inline bool operator!=(const SFGenerator& lhs, const SFGenerator& rhs)
-			{
-				return !(lhs == rhs);
-			}
-			friend inline bool operator==(const SFGenerator& lhs, const GenType& rhs)
-			{
-				return lhs.enumeration == rhs;
-			}
-			friend inline bool operator!=(const SFGenerator& lhs, const GenType& rhs)
-			{
-				return !(lhs == rhs);
-			}
-		};
-		struct SFTransform
-		{
-			WORD enumeration;
-		};
-
-		struct sfVersionTag
-		{
-			WORD wMajor;
-			WORD wMinor;
-		};
-
-		RIFF::stream* stream;
-
-		sfVersionTag ifil;
-		sfVersionTag iver;
-		std::string szSoundEngine;
-		std::string szROM;
-		std::string szName;
-		std::string szDate;
-		std::string szProduct;
-		std::string szCreator;
-		std::string szCopyright;
-		std::string szComment;
-		std::string szTools;
-
-		struct HYDRA
-		{
-			struct sfPresetHeader
-			{
-				CHAR achPresetName[20];
-				WORD wPreset;//MIDI Preset Number
-				WORD wBank;//MIDI Bank Number
-				WORD wPresetBagNdx;//index to the presets zone list
-				DWORD dwLibrary;//reserved
-				DWORD dwGenre;//reserved
-				DWORD dwMorphology;//reserved
-			};
-			//Preset header list
-			std::vector<std::unique_ptr<sfPresetHeader>> phdr;
-
-			struct sfPresetBag
-			{
-				WORD wGenNdx;//index to the presets zone list of generators in PGEN
-				WORD wModNdx;//index to the list of modulators in PMOD
-			};
-			//Pointers to first entries of preset zone generator and modulator lists
-			std::vector<std::unique_ptr<sfPresetBag>> pbag;
-
-			struct sfModList
-			{
-				//indicates the source of data for the modulator
-				SFModulator sfModSrcOper;
-				//destination of the modulator
-				SFGenerator sfModDestOper;
-				//degree to which the source modulates the destination
-				//a zero value indicates there is no fixed amount. 
-				SHORT modAmount;
-				//indicates the degree to which the source modulates the destination
-				//is to be controlled by the specified modulation source
-				SFModulator sfModAmtSrcOper;
-				//indicates that a transform of the specified type will be applied
-				//to the modulation source before application to the modulator
-				SFTransform sfModTransOper;
-			};
-			//Preset zone modulators
-			std::vector<std::unique_ptr<sfModList>> pmod;
-
-			struct sfGenList
-			{
-				SFGenerator sfGenOper;
-				//value to be assigned to the specified generator
-				//note that this can be of three formats. 
-				genAmountType genAmount;
-			};
-			//Preset zone generators
-			std::vector<std::unique_ptr<sfGenList>> pgen;
-
-			struct sfInst
-			{
-				CHAR achInstName[20];
-				//index to the instruments zone list in the IBAG sub-chunk
-				WORD wInstBagNdx;
-			};
-			//Instrument list
-			std::vector<std::unique_ptr<sfInst>> inst;
-
-			struct sfInstBag
-			{
-				//index to the instrument zones list of generators in the IGEN sub-chunk
-				WORD wInstGenNdx;
-				//index to the list of modulators in the IMOD sub-chunk
-				WORD wInstModNdx;
-			};
-			//Pointers to first entries of instrument zone generator and modulator lists
-			std::vector<std::unique_ptr<sfInstBag>> ibag;
-
-			struct sfInstModList
-			{
-				//indicates the source of data for the modulator
-				SFModulator sfModSrcOper;
-				//indicates the destination of the modulator
-				SFGenerator sfModDestOper;
-				//indicates the degree to which the source modulates the destination
-				//a zero value indicates there is no fixed amount. 
-				SHORT modAmount;
-				//indicates the degree to which the source modulates the destination
-				//is to be controlled by the specified modulation source
-				SFModulator sfModAmtSrcOper;
-				//indicates that a transform of the specified type will be applied
-				//to the modulation source before application to the modulator
-				SFTransform sfModTransOper;
-			};
-			//Instrument zone modulators
-			std::vector<std::unique_ptr<sfInstModList>> imod;
-
-			struct sfInstGenList
-			{
-				SFGenerator sfGenOper;
-				//value to be assigned to the specified generator
-				//note that this can be of three formats.
-				genAmountType genAmount;
-			};
-			//Instrument zone generators
-			std::vector<std::unique_ptr<sfInstGenList>> igen;
-
-			struct sfSample
-			{
-				CHAR achSampleName[20];
-				//index, in sample data points, from the beginning of the sample data
-				//field to the first data point of this sample. 
-				DWORD dwStart;
-				//index, in sample data points, from the beginning of the sample data
-				//field to the first of the set of 46 zero valued data points following
-				//this sample. 
-				DWORD dwEnd;
-				//index, in sample data points, from the beginning of the sample data
-				//field to the first data point in the loop of this sample. 
-				DWORD dwStartloop;
-				//index, in sample data points, from the beginning of the sample data
-				//field to the first data point following the loop of this sample.
-				//Note that this is the data point equivalent to the first loop data point,
-				//and that to produce portable artifact free loops, the eight proximal data
-				//points surrounding both the Startloop and Endloop points should be identical. 
-				DWORD dwEndloop;
-				//the sample rate, in hertz, at which this sample was acquired or to which
-				//it was most recently converted.
-				DWORD dwSampleRate;
-				//contains the MIDI key number of the recorded pitch of the sample
-				BYTE byOriginalKey;
-				//contains a pitch correction in cents that should be applied to
-				//the sample on playback.
-				//The purpose of this field is to compensate for any pitch errors during
-				//the sample recording process. The correction value is that of the correction
-				//to be applied. For example, if the sound is 4 cents sharp, a correction
-				//bringing it 4 cents flat is required; thus the value should be -4.
-				CHAR chCorrection;
-				//sample header link, accordingly indicated by sfSampleType
-				WORD wSampleLink;
-				//sample type
-				SFSampleLink sfSampleType;
-			};
-			//Samples
-			std::vector<std::unique_ptr<sfSample>> shdr;
-		};
-		HYDRA hydra;
-
-		size_t sample_data_offset;
-		size_t sample_data_24_offset;
-
-		struct Sample
-		{
-			std::string name;
-
-			uint32_t loop_start;
-			uint32_t loop_end;
-
-			uint32_t sample_rate;
-			uint8_t original_key;
-			int8_t correction;
-
-			uint32_t data_stream_offset;
-			std::unique_ptr<float[]> data;
-			uint32_t size;
-
-			SFSampleLink sample_type;
-			Sample* linked_sample;
-
-			void load_data(SoundFont2& sf2)
-			{
-				SF2_DEBUG_OUTPUT((std::string("Loading sample data \"") + name + "\"...\n").c_str());
-				auto data16 = std::make_unique<int16_t[]>(size);
-				//set up position of the stream
-				sf2.stream->setpos(sf2.sample_data_offset+data_stream_offset*sizeof(int16_t));
-				//read 16 bit samples
-				sf2.stream->read(data16.get(), size*sizeof(int16_t));
-				if(sf2.sample_data_24_offset)
-				{
-					auto data24 = std::make_unique<uint8_t[]>(size);
-					//set up position of the stream
-					sf2.stream->setpos(sf2.sample_data_24_offset+data_stream_offset);
-					//read 8 bit of 24 bit complementary additional sample data
-					sf2.stream->read(data24.get(), size);
-					//combine both buffers, convert to float and store
-					data = std::make_unique<float[]>(size);
-					for(uint32_t j = 0; j < size; ++j)
-					{
-						data[j] = (float)
-							(
-								(
-									(((uint8_t*)&data16[j])[1] << 24) |
-									(((uint8_t*)&data16[j])[0] << 16) |
-									(data24[j] << 8)
-									) >> 8
-								) / 8388607.0;
-					}
-				}
-				else
-				{
-					//just convert to float and store
-					data = std::make_unique<float[]>(size);
-					for(uint32_t j = 0; j < size; ++j)
-					{
-						data[j] = (float)data16[j] / 32767.0;
-					}
-				}
-
-				//test
-				//save RAW
-				/*std::ofstream outfile ("wave.raw",std::ofstream::binary);
-				outfile.write((char*)data, sizeof(float)*size);
-				outfile.close();*/
-			}
-		};
-		std::vector<std::unique_ptr<Sample>> samples;
-
-		struct LFO
-		{
-			int16_t delay = -12000;
-			int16_t frequency = 0;
-
-			LFO& operator+=(const LFO& rhs)
-			{
-				delay += rhs.delay;
-				frequency += rhs.frequency;
-				return *this;
-			}
-
-			friend LFO operator+(LFO lhs, const LFO& rhs)
-			{
-				lhs += rhs;
-				return lhs;
-			}
-		};
-		struct Envelope
-		{
-			int16_t attack = 0;
-			int16_t decay = 0;
-			int16_t sustain = 0;
-			int16_t release = 0;
-			int16_t hold = 0;
-			int16_t delay = 0;
-
-			int16_t keynumToHold = 0;
-			int16_t keynumToDecay = 0;
-
-			void SetToDefault()
-			{
-				attack = -12000;
-				decay = -12000;
-				release = -12000;
-				hold = -12000;
-				delay = -12000;
-			}
-
-			Envelope& operator+=(const Envelope& rhs)
-			{
-				attack += rhs.attack;
-				decay += rhs.decay;
-				sustain += rhs.sustain;
-				release += rhs.release;
-				hold += rhs.hold;
-				delay += rhs.delay;
-				keynumToHold += rhs.keynumToHold;
-				keynumToDecay += rhs.keynumToDecay;
-				return *this;
-			}
-
-			friend Envelope operator+(Envelope lhs, const Envelope& rhs)
-			{
-				lhs += rhs;
-				return lhs;
-			}
-		};
-		enum class LoopMode
-		{
-			None = 0,
-			Continuous = 1,
-			Sustain = 2
-		};
-
-		struct Instrument
-		{
-			std::string name;
-
-			//Also known as Split
-			//used for different key and velocity ranges
-			struct Zone
-			{
-				Sample* sample = nullptr;
-				int32_t start_offset = 0;
-				int32_t end_offset = 0;
-				int32_t loop_start_offset = 0;
-				int32_t loop_end_offset = 0;
-				int16_t filter_freq = 13500;
-				float filter_q = 0.0f;
-				int16_t chorus_send = 0;
-				int16_t reverb_send = 0;
-				float scale_tuning = 1.0f;
-				int16_t root_key = -1;
-				uint8_t key_low = 0, key_high = 127;
-				uint8_t vel_low = 0, vel_high = 127;
-				int16_t keynum = -1;
-				int16_t velocity = -1;
-				int32_t tune = 0;
-				uint16_t exclusive_class = 0;
-				float pan = 0.0f;
-				float attenuation = 0.0f;
-				LoopMode loop_mode = LoopMode::None;
-
-				LFO modLFO;
-				int16_t modLFO_to_pitch = 0;
-				int16_t modLFO_to_filter_fc = 0;
-				int16_t modLFO_to_volume = 0;
-				LFO vibLFO;
-				int16_t vibLFO_to_pitch = 0;
-
-				Envelope modEnv;
-				int16_t modEnv_to_pitch = 0;
-				int16_t modEnv_to_filter_fc = 0;
-				Envelope volEnv;
-			};
-			//Zone* global_zone = nullptr;
-			std::vector<std::unique_ptr<Zone>> splits;
-		};
-		std::vector<std::unique_ptr<Instrument>> instruments;
-
-		struct Preset
-		{
-			std::string name;
-			//MIDI Preset Number
-			uint16_t num;
-
-			//Also known as Layer
-			//used to specify list of layered instruments of a preset
-			//does not contain default generators
-			struct Zone
-			{
-				Instrument* instrument = nullptr;
-				int16_t filter_freq = 0;
-				float filter_q = 0.0f;
-				int16_t chorus_send = 0;
-				int16_t reverb_send = 0;
-				float scale_tuning = 0.0f;
-				uint8_t key_low = 0, key_high = 127;
-				uint8_t vel_low = 0, vel_high = 127;
-				int32_t tune = 0;
-				float pan = 0.0f;
-				float attenuation = 0.0f;
-
-				LFO modLFO = {0,0};
-				int16_t modLFO_to_pitch = 0;
-				int16_t modLFO_to_filter_fc = 0;
-				int16_t modLFO_to_volume = 0;
-				LFO vibLFO = {0,0};
-				int16_t vibLFO_to_pitch = 0;
-
-				Envelope modEnv;
-				int16_t modEnv_to_pitch = 0;
-				int16_t modEnv_to_filter_fc = 0;
-				Envelope volEnv;
-			};
-			//Zone* global_zone = nullptr;
-			std::vector<std::unique_ptr<Zone>> layers;
-		};
-		struct Bank
-		{
-			uint16_t num;//MIDI Bank Number
-			std::vector<std::unique_ptr<Preset>> presets;
-		};
-		std::vector<std::unique_ptr<Bank>> banks;
-
-		struct BiQuadLowpass
-		{
-			float inv_Q;
-			float a0;
-			float a1;
-			float b1;
-			float b2;
-			float z1 = 0;
-			float z2 = 0;
-			bool active;
-
-			inline void set_Q(float Q)
-			{
-				inv_Q = 1.0f / Q;
-			}
-
-			inline void set_frequency(float Fc)
-			{
-				float K = std::tan(M_PI * Fc);
-				float KK = K * K;
-				float norm = 1.0f / (1.0f + K * inv_Q + KK);
-				a0 = KK * norm;
-				a1 = 2.0f * a0;
-				b1 = 2.0f * (KK - 1) * norm;
-				b2 = (1.0f - K * inv_Q + KK) * norm;
-			}
-
-			inline float process(float in)
-			{
-				float out = in * a0 + z1;
-				z1 = in * a1 + z2 - b1 * out;
-				z2 = in * a0 - b2 * out;
-				return out;
-			}
-		};
-
-		struct Voice
-		{
-			Instrument::Zone* zone = nullptr;
-
-			Sample* sample = nullptr;
-			double sample_pos = 0;
-			uint32_t sample_end_pos = 0;
-
-			bool hold = false;
-			uint32_t loop_start = 0;
-			uint32_t loop_end = 0;
-
-			float pan_factor_l = 0.0f, pan_factor_r = 0.0f;
-			//float src_freq_factor = 0.0f;
-			float freq = 0.0f;
-			float gain = 0.0f;
-			float filter_freq = 0.0f;
-			float filter_q = 0.0f;
-			float modenv_to_filter_freq = 0.0f;
-			float modenv_to_pitch = 0.0f;
-
-			uint8_t key = 0;
-
-			enum class EnvPhase : int
-			{
-				Delay = 0,
-				Attack = 1,
-				Hold = 2,
-				Decay = 3,
-				Sustain = 4,
-				Release = 5,
-				End = 6
-			};
-
-			template <bool is_decibels = true>
-			struct Env
-			{
-				float
-					delay,
-					attack,
-					hold,
-					decay,
-					sustain,
-					release;
-
-				float keynumToHold = 1.0f;
-				float keynumToDecay = 1.0f;
-
-				double slope_factor;
-				EnvPhase phase = EnvPhase::Delay;
-				double time = 0;
-				float value = 0;
-
-				Env()
-				{
-
-				}
-				Env(const Envelope& env, const Envelope& env2, uint8_t key)
-				{
-					if constexpr(is_decibels) value = -96.0f;
-
-					Envelope tmp_envelope = env+env2;
-					//setup volume envelope
-					delay = timecents_to_seconds(tmp_envelope.delay);
-					attack = timecents_to_seconds(tmp_envelope.attack);
-					hold = timecents_to_seconds(tmp_envelope.hold);
-					hold *= timecents_to_seconds(tmp_envelope.keynumToHold*(60-key));
-					decay = timecents_to_seconds(tmp_envelope.decay);
-					decay *= timecents_to_seconds(tmp_envelope.keynumToDecay*(60-key));
-					release = timecents_to_seconds(tmp_envelope.release);
-					if constexpr(is_decibels)
-						sustain = tmp_envelope.sustain*0.1f;//this one is decibels
-					else
-						sustain = 1.0f-tmp_envelope.sustain*0.001f;//this one is 0.1 units, expressed as percents
-					slope_factor = 1.0f/delay;
-				}
-
-				//ADSR envelope operates in decibels
-				float Get(float delta_time)
-				{
-					switch(phase)
-					{
-					case EnvPhase::Delay:
-					{
-						//wait before fading in
-						time += delta_time;
-						if(time >= delay)
-						{
-							//go to the next phase
-							time -= delay;
-							phase = EnvPhase::Attack;
-							slope_factor = 1.0f/attack;				
-						}
-						if constexpr(is_decibels)
-							return -96.0f;
-						else
-							return 0.0f;
-						break;
-					}
-					case EnvPhase::Attack:
-					{
-						float val;
-						if constexpr(is_decibels)
-							val = gain_to_decibels(time * slope_factor);
-						else
-							val = time * slope_factor;
-						value = val;
-
-						time += delta_time;
-						if(time >= attack)
-						{
-							//go to the next phase
-							time -= attack;
-							phase = EnvPhase::Hold;
-							slope_factor = 1.0f/hold;
-						}
-						return val;
-					}
-					case EnvPhase::Hold:
-					{
-						//stay at maximum level for some time
-						if constexpr(is_decibels)
-							value = 0.0f;
-						else
-							value = 1.0f;
-
-						time += delta_time;
-						if(time >= hold)
-						{
-							//go to the next phase
-							time -= hold;
-							phase = EnvPhase::Decay;
-							slope_factor = 1.0f/decay;
-						}
-						if constexpr(is_decibels)
-							return 0.0f;
-						else
-							return 1.0f;
-					}
-					case EnvPhase::Decay:
-					{
-						//fade from maximum to sustain level
-						float val;
-						if constexpr(is_decibels)
-							val = -sustain * time * slope_factor;
-						else
-							val = fast_lerp(1.0f, sustain, time * slope_factor);
-						value = val;
-						time += delta_time;
-						if(time >= decay)
-						{
-							//go to the next phase
-							time -= decay;
-							phase = EnvPhase::Sustain;
-						}
-						return value;
-					}
-					case EnvPhase::Sustain:
-					{
-						//wait for note off
-						if constexpr(is_decibels)
-							return -sustain;
-						else
-							return sustain;
-					}
-					case EnvPhase::Release:
-					{
-						//fade out linearly
-						float val;
-						if constexpr(is_decibels)
-							val = value + (time * slope_factor) * (-96.0f - value);
-						else
-							val = fast_lerp(value, 0.0f, time * slope_factor);
-						time += delta_time;
-						if(time >= release)
-						{
-							//go to the next phase
-							time -= release;
-							phase = EnvPhase::End;
-						}
-						return val;
-					}
-					default:
-					{
-						//finished or error
-						if constexpr(is_decibels)
-							return -96.0f;
-						else
-							return 0.0f;
-					}
-					}
-
-					//unreachable code
-					/*if constexpr(is_decibels)
-						return -96.0f;
-					else
-						return 0.0f;*/
-				}
-
-				void Release()
-				{
-					slope_factor = 1.0f/release;
-					phase = Voice::EnvPhase::Release;
-					time = 0.0f;
-				}
-			};
-			Env<true> volenv;
-			Env<false> modenv;
-			BiQuadLowpass lowpass;
-
-			struct VoiceLFO
-			{
-				float time;
-				float freq;
-				float delay;
-
-				VoiceLFO()
-				{
-				}
-
-				VoiceLFO(LFO& lfo, LFO& lfo2)
-				{
-					LFO tmp_lfo = lfo+lfo2;
-					time = 0.0f;
-					freq = 8.176f*cents_to_hertz(tmp_lfo.frequency);
-					delay = timecents_to_seconds(tmp_lfo.delay);
-				}
-
-				float Get(float delta_time)
-				{
-					//triangle wave
-					time += delta_time;
-					return (time < delay)?0.0f:abs(fmod(4.0f*freq*(time-delay)+3.0f, 4.0f)-2.0f)-1.0f;
-				}
-			};
-			VoiceLFO modLFO;
-			float modLFO_to_pitch = 0;
-			float modLFO_to_filter_fc = 0;
-			float modLFO_to_volume = 0;
-			VoiceLFO vibLFO;
-			float vibLFO_to_pitch = 0;
-
-			//Note Off
-			void Release()
-			{
-				hold = false;
-			}
-
-			void Render(float* output_L, float* output_R, uint32_t size, float sample_rate)
-			{
-				//Wavetable oscillator implementation
-				//TODO: optimize
-
-				//inverse of sample rate (which is also delta time)
-				double sample_rate_inv = 1.0f/sample_rate;
-
-				//calculate sample data playback step
-				//float step = sample->sample_rate/(source_frequency*sample_rate)*frequency;
-				//double step = (src_freq_factor*freq)/sample_rate;
-				double step = freq/sample_rate;
-				double step_ = step;
-				//time, in seconds, specifying duration of a sample
-				double delta_time = sample_rate_inv;
-				for(uint32_t i = 0; i < size && sample_pos < sample->size; ++i)
-				{
-					//truncate floating point position to integer
-					//effectively removing fractional part
-					uint32_t pos = sample_pos;
-					bool is_looping = ((hold && zone->loop_mode != LoopMode::None) || zone->loop_mode == LoopMode::Continuous);
-					//get position next to the current or wrapped around if out of loop bounds
-					uint32_t pos_next = (pos >= loop_end && is_looping || pos + 1 >= sample->size)?((is_looping)?loop_start:pos):(pos + 1);
-					//get interpolation factor by subtracting truncated position from original,
-					//resulting value is the fractional part of the position
-					float lerp_factor = sample_pos - float(pos);
-					//get interpolated value between two adjacent sample points
-					float val = fast_lerp(sample->data[pos], sample->data[pos_next], lerp_factor);
-					if(pos > sample->size) printf("pos out of range!\n");
-					if(pos_next > sample->size) printf("pos_next out of range!\n");
-					if(sample_pos >= sample->size)
-					{
-						printf("out of range: %f\n", val);
-					}
-					//increment sample position using pitch based step value
-					sample_pos += step;
-					if(sample_pos >= loop_end && is_looping)
-						sample_pos -= (loop_end - loop_start);
-
-					auto tmp_state = volenv.phase;
-					float volenv_gain = decibels_to_gain(volenv.Get(delta_time));
-					float modenv_gain = modenv.Get(delta_time);
-					//prematurely end inaudible voice (optimization)
-					//TODO: add an option to disable
-					if(volenv_gain < 0.002f && volenv.phase == Voice::EnvPhase::Release)
-						volenv.phase = Voice::EnvPhase::End;
-					//release volume envelope
-					if(static_cast<int>(volenv.phase) < static_cast<int>(Voice::EnvPhase::Release) && !hold)
-					{
-						//immediately jump to the release phase after a note off
-						volenv.Release();
-					}
-					//release modulation envelope
-					if(static_cast<int>(modenv.phase) < static_cast<int>(Voice::EnvPhase::Release) && !hold)
-					{
-						//immediately jump to the release phase after a note off
-						modenv.Release();
-					}
-					val *= gain * volenv_gain;
-					float viblfo_val;
-					if(vibLFO_to_pitch)
-						viblfo_val = vibLFO.Get(delta_time);
-					float modlfo_val;
-					if(modLFO_to_pitch || modLFO_to_filter_fc || modLFO_to_volume)
-						modlfo_val = modLFO.Get(delta_time);
-					float filter_freq_new = filter_freq;
-					if(modenv_to_filter_freq || modLFO_to_filter_fc)
-					{
-						if(modenv_to_filter_freq)
-							filter_freq_new *= cents_to_hertz(modenv_gain*modenv_to_filter_freq);
-						if(modLFO_to_filter_fc)
-							filter_freq_new *= cents_to_hertz(modlfo_val*modLFO_to_filter_fc);
-						//lowpass.active = !(filter_freq_new > sample_rate*0.45f || filter_q == 0.0f);
-					}
-					if(lowpass.active)
-					{			
-						//Spec says 20kHz is the limit but it causes clicks,
-						//so a multiple of sample rate is used instead, to avoid biquad filter instability
-						//I don't exclude the possibility that maybe I misunderstood something though
-						/*if(filter_freq_new > sample_rate * 0.45f)
-						{
-							filter_freq_new = sample_rate*0.45f;
-						}*/if(filter_freq_new > sample_rate * 0.4977f)
-						{
-							filter_freq_new = sample_rate*0.4977f;
-						}
-						if(filter_freq_new != filter_freq)
-						{
-							//lowpass.set_frequency(filter_freq_new/sample_rate);
-							lowpass.set_frequency(filter_freq_new*sample_rate_inv);
-						}
-						val = lowpass.process(val);
-					}
-					float adjusted_pitch = 1.0f;
-					if(modenv_to_pitch || vibLFO_to_pitch || modLFO_to_pitch)
-					{
-						if(modenv_to_pitch)
-							adjusted_pitch *= cents_to_hertz(modenv_gain*modenv_to_pitch);
-						if(vibLFO_to_pitch)
-							adjusted_pitch *= cents_to_hertz(vibLFO_to_pitch*viblfo_val);
-						if(modLFO_to_pitch)
-							adjusted_pitch *= cents_to_hertz(modLFO_to_pitch*modlfo_val);
-						//step = (src_freq_factor*freq*adjusted_pitch)/sample_rate;
-						step = step_*adjusted_pitch;
-					}
-					if(modLFO_to_volume)
-					{
-						val *= decibels_to_gain(modlfo_val*modLFO_to_volume);
-					}
-					//val = volenv_gain;
-					//val = modenv_gain;
-					/*if(modLFO_to_pitch || modLFO_to_filter_fc || modLFO_to_volume)
-					val = modlfo_val;
-					else val = 0;*/
-
-					//add value to the outputs with appropriate panning factors applied
-					output_L[i] += val * pan_factor_l;
-					output_R[i] += val * pan_factor_r;
-				}
-
-				//test
-				//save RAW
-				/*std::ofstream outfile ("wave.raw",std::ofstream::binary);
-				outfile.write((char*)sample->data, sizeof(float)*sample->size);
-				outfile.close();*/
-			}
-
-			bool IsDone()
-			{
-				return (sample_pos >= sample->size && !hold) || volenv.phase == Voice::EnvPhase::End;
-			}
-		};
-
-		struct Channel
-		{
-			DynamicPool<Voice> voices = DynamicPool<Voice>(64, 64);
-			std::vector<bool> key_states;
-			Bank* bank = nullptr;
-			Preset* preset = nullptr;
-			SoundFont2* sf = nullptr;
-			bool sustain = false;
-
-			Channel()
-			{
-				key_states.resize(255, false);
-			}
-
-			~Channel()
-			{
-				//for(auto v : voices) delete v;
-			}
-
-			void SetPreset(size_t presetno, size_t bankno = 0)
-			{
-				if(!sf) return;
-				if(sf->banks.empty()) return;
-
-				//find bank by number
-				Bank* target_bank = nullptr;
-				for(auto& b : sf->banks)
-				{
-					if(b->num == bankno)
-					{
-						target_bank = b.get();
-						break;
-					}
-				}
-				if(!target_bank) goto fallback_bank_zero;
-
-				//try to find a matching preset in requested bank
-				for(auto& p : target_bank->presets)
-				{
-					if(p->num == presetno)
-					{
-						bank = target_bank;
-						preset = p.get();
-						goto load_samples_proc;
-					}
-				}
-				//fallback to default bank 0
-				//exception: percussion bank 128
-				if(target_bank->num == 128)
-				{
-					if(!target_bank->presets.empty())
-					{
-						preset = target_bank->presets[0].get();
-						goto load_samples_proc;
-					}
-				}
-			fallback_bank_zero:
-				for(auto& p : sf->banks[0]->presets)
-				{
-					if(p->num == presetno)
-					{
-						bank = sf->banks[0].get();
-						preset = p.get();
-						goto load_samples_proc;
-					}
-				}
-
-			load_samples_proc:
-				//load samples
-				if(preset)
-				{
-					for(auto& layer : preset->layers)
-					{
-						for(auto& split : layer->instrument->splits)
-						{
-							if(!split->sample->data)
-							{
-								split->sample->load_data(*sf);
-							}
-						}
-					}
-					return;
-				}
-				//failsafe
-				//on the second thought.. no failsafe
-			}
-
-			void NoteOn(uint8_t key, uint8_t velocity, float sample_rate)
-			{
-				if(!preset || !sf) return;
-
-				key_states[key] = true;
-
-				size_t size = voices.size();
-				sf->GenerateVoices(preset, key, velocity, sample_rate, voices);
-
-				//release exclusive voices
-				for(auto nv = voices.begin()+size; nv != voices.end(); ++nv)
-				{
-					if(nv->zone->exclusive_class != 0)
-					{
-						for(auto v = voices.begin(); v != voices.begin()+size; ++v)
-						{
-							if(v->zone->exclusive_class == nv->zone->exclusive_class)
-							{
-								v->Release();
-								//extinguish fast
-								v->volenv.value = v->volenv.Get(0.0f);
-								v->volenv.time = 0.0f;
-								v->volenv.release = 0.001f;
-							}
-						}
-					}
-				}
-			}
-
-			void NoteOff(uint8_t key)
-			{
-				key_states[key] = false;
-				if(!sustain)
-				{
-					for(auto& v : voices)
-					{
-						if(v.key == key)
-						{
-							v.Release();
-						}
-					}
-				}
-			}
-
-			void SetSustain(bool enable)
-			{
-				sustain = enable;
-				if(!enable)
-				{
-					//go through all recorded key states
-					for(size_t key = 0; key < key_states.size(); ++key)
-					{
-						//check if key is not held
-						if(!key_states[key])
-						{
-							//release all voices with that key
-							for(size_t i = 0; i < voices.size(); i++)
-							{
-								if(voices[i].key == key)
-								{
-									voices[i].Release();
-								}
-							}
-						}
-					}
-				}
-			}
-
-			void Render(float* output_L, float* output_R, uint32_t size, float sample_rate)
-			{
-				for(size_t i = 0; i < voices.size();)
-				{
-					auto& v = voices[i];
-					v.Render(output_L, output_R, size, sample_rate);
-					if(v.IsDone())
-					{
-						//delete v;
-						voices.erase(voices.begin() + i);
-					}
-					else ++i;
-				}
-			}
-
-			void Panic()
-			{
-				//for(auto v : voices) delete v;
-				voices.clear();
-			}
-		};
-
-		//Note On
-		void GenerateVoices(Preset* preset, uint8_t key, uint8_t velocity, float sample_rate, DynamicPool<Voice>& container)
-		{
-			for(auto& layer : preset->layers)
-			{
-				//check if passes by key and velocity
-				if(key < layer->key_low || layer->key_high < key ||
-				   velocity < layer->vel_low || layer->vel_high < velocity)
-					continue;
-				for(auto& split : layer->instrument->splits)
-				{
-					//check if passes by key and velocity
-					if(key < split->key_low || split->key_high < key ||
-					   velocity < split->vel_low || split->vel_high < velocity)
-						continue;
-					//check if sample isn't ROM (because it's not supported)
-					if(IsSampleROM(split->sample->sample_type)) continue;
-
-					uint8_t tmp_vel = velocity;
-					uint8_t tmp_key = key;
-					//override velocity
-					if(split->velocity != -1)
-						tmp_vel = split->velocity;
-					//override key
-					if(split->keynum != -1)
-						tmp_key = split->keynum;
-
-					//get sample
-					Sample* sample_first = split->sample;
-					Sample* sample = sample_first;
-					float pan = 0.0f;//mono
-
-				create_voice:
-					{
-						//create new voice
-						container.emplace_back();
-						auto voice = &container.back();
-						voice->key = tmp_key;
-						voice->sample = sample;
-						voice->zone = split.get();
-						voice->hold = true;
-
-						//sample points
-						voice->sample_pos = split->start_offset;
-						voice->sample_end_pos = sample->size + split->end_offset;
-
-						//loop points
-						voice->loop_start = sample->loop_start + split->loop_start_offset;
-						voice->loop_end = sample->loop_end + split->loop_end_offset;
-
-						//add preset and instrument envelope value generators together
-						voice->volenv = Voice::Env<true>(layer->volEnv, split->volEnv, key);
-						voice->modenv = Voice::Env<false>(layer->modEnv, split->modEnv, key);
-						//setup lowpass filter
-						//8.176f - MIDI key 0 frequency used to convert "absolute pitch cents" to Hz
-						voice->filter_q = (layer->filter_q+split->filter_q);
-						voice->filter_freq = 8.176f*cents_to_hertz(layer->filter_freq+split->filter_freq);
-						voice->modenv_to_filter_freq = layer->modEnv_to_filter_fc+split->modEnv_to_filter_fc;
-						voice->lowpass.active = !(voice->filter_freq > 20000.0f && voice->filter_q < 0.0f && voice->modenv_to_filter_freq != 0.0f);
-						if(voice->lowpass.active)
-						{
-							voice->lowpass.set_Q(decibels_to_gain(voice->filter_q));
-							voice->lowpass.set_frequency(voice->filter_freq/sample_rate);
-						}
-						voice->modenv_to_pitch = layer->modEnv_to_pitch+split->modEnv_to_pitch;
-
-						voice->modLFO = Voice::VoiceLFO(layer->modLFO, split->modLFO);
-						voice->modLFO_to_filter_fc = layer->modLFO_to_filter_fc + split->modLFO_to_filter_fc;
-						voice->modLFO_to_pitch = layer->modLFO_to_pitch + split->modLFO_to_pitch;
-						voice->modLFO_to_volume = (layer->modLFO_to_volume + split->modLFO_to_volume)/10.0f;
-						voice->vibLFO = Voice::VoiceLFO(layer->modLFO, split->modLFO);
-						voice->vibLFO_to_pitch = layer->vibLFO_to_pitch + split->vibLFO_to_pitch;
-
-						//Calculate gain
-						//Factor of 0.4 is for compatibility, many soundfonts expect this behaviour...
-						//Even though it's against the specification, apparently that's how some
-						//E-MU synthesizers are designed as well, which leaves many questions.
-						//TODO: add an option to disable this behaviour
-						voice->gain = decibels_to_gain(-(layer->attenuation + split->attenuation)*0.4);
-						//linear velocity curve
-						voice->gain *= float(tmp_vel) / 127.0f;
-
-						//get pan on per sample basis
-						switch(sample->sample_type)
-						{
-						case SFSampleLink::monoSample: pan = 0.0f; break;
-						case SFSampleLink::leftSample: pan = -0.5f; break;
-						case SFSampleLink::rightSample: pan = 0.5f; break;
-						case SFSampleLink::linkedSample: pan = 0.0f; break;
-						}
-						//calculate panning factors
-						constant_power_pan(
-							voice->pan_factor_l,
-							voice->pan_factor_r,
-							clamp_panning(pan + layer->pan + split->pan)
-						);
-
-						//printf("pitch correction: %f\n", sample->correction);
-
-						//calculate pitch factors
-						float root_key_cents = ((split->root_key == -1)?sample->original_key:split->root_key)*100.0f;
-						float note_cents = tmp_key*100.0f + split->tune + layer->tune;
-						float src_freq_factor = sample->sample_rate/cents_to_hertz(root_key_cents);
-						voice->freq = src_freq_factor*cents_to_hertz(root_key_cents + (note_cents - root_key_cents)*(split->scale_tuning+layer->scale_tuning));
-						if(sample->correction)
-						{
-							voice->freq *= cents_to_hertz(sample->correction);
-						}
-
-						//Check for next linked sample if sample type isn't mono.
-						//Since SoundFont 2.4 doesn't yet define circular linking,
-						//all we have to do is just handle one more sample for stereo
-						//but we'll go ahead and try to loop all of them.
-						if(split->sample->sample_type != SFSampleLink::monoSample)
-						{
-							//check for full circle
-							if(sample->linked_sample == sample_first || !sample->linked_sample)
-							{
-								//the circle is now complete
-								continue;
-							}
-
-							//get next sample
-							sample = sample->linked_sample;
-							//start over
-							goto create_voice;
-						}
-					}
-				}
-			}
-		}
-
-		SoundFont2(RIFF::RIFF* riff, RIFF::stream* s)
-		{
-#define read_zstr(chunk, string, max_len)\
-			{\
-				if(chunk)\
-				{\
-					s->setpos(chunk->data_offset);\
-					for(int i = 0; i < max_len; ++i)\
-					{\
-						char c = 0;\
-						s->read(&c, sizeof(char));\
-						if(c != 0)\
-							string += c;\
-						else break;\
-					}\
-				}\
-			}
-#define read_versiontag(chunk, tag)\
-			{\
-				if(chunk)\
-				{\
-					s->setpos(chunk->data_offset);\
-					s->read(&tag.wMajor, sizeof(WORD));\
-					s->read(&tag.wMinor, sizeof(WORD));\
-				}\
-			}
-#define read_field(field){s->read(&field, sizeof(field));}
-
-			RIFF_SoundFont2 sf2(riff);
-
-			SF2_DEBUG_OUTPUT("Reading file info...\n");
-			read_versiontag(sf2.INFO.ifil, ifil);
-			//check version
-			if(ifil.wMajor != 2)
-			{
-				//not supported
-				//TODO: reject the file
-			}
-			read_zstr(sf2.INFO.isng, szSoundEngine, 256);
-			read_zstr(sf2.INFO.INAM, szName, 256);
-			read_zstr(sf2.INFO.irom, szROM, 256);
-			read_versiontag(sf2.INFO.iver, iver);
-			read_zstr(sf2.INFO.ICRD, szDate, 256);
-			read_zstr(sf2.INFO.IENG, szCreator, 256);
-			read_zstr(sf2.INFO.IPRD, szProduct, 256);
-			read_zstr(sf2.INFO.ICOP, szCopyright, 256);
-			read_zstr(sf2.INFO.ICMT, szComment, 65536);
-			read_zstr(sf2.INFO.ISFT, szTools, 256);
-
-			SF2_DEBUG_OUTPUT("Storing sample data offsets...\n");
-			//Get sample data offsets of smpl and sm24 subchunks of sdta-list chunk
-			sample_data_offset = sf2.sdta.smpl->data_offset;
-			if(sf2.sdta.sm24)
-				sample_data_24_offset = sf2.sdta.sm24->data_offset;
-			else
-				sample_data_24_offset = 0;
-
-			//The HYDRA Data Structure 
-			//========================================================================
-			SF2_DEBUG_OUTPUT("Reading HYDRA data...\n");
-			//The PHDR sub-chunk is a required sub-chunk listing all
-			//presets within the SoundFont compatible file
-			s->setpos(sf2.pdta.phdr->data_offset);
-			hydra.phdr.resize(sf2.pdta.phdr->size/38);
-			for(auto& preset : hydra.phdr)
-			{
-				preset = std::make_unique<HYDRA::sfPresetHeader>();
-				read_field(preset->achPresetName);
-				//null-terminate preset name
-				//but why do I have to do this anyway? Standard says I should reject it!
-				preset->achPresetName[19] = 0;
-				read_field(preset->wPreset);
-				read_field(preset->wBank);
-				read_field(preset->wPresetBagNdx);
-				read_field(preset->dwLibrary);
-				read_field(preset->dwGenre);
-				read_field(preset->dwMorphology);
-			}
-			//The PBAG sub-chunk is a required sub-chunk listing all
-			//preset zones within the SoundFont compatible file.
-			//
-			/*If a preset has more than one zone, the first zone may be a global zone.
-			A global zone is determined by the fact that the last
-			generator in the list is not an Instrument generator.
-			All generator lists must contain at least one generator with one
-			exception - if a global zone exists for which there are
-			no generators but only modulators. The modulator lists can contain
-			zero or more modulators. */
-			s->setpos(sf2.pdta.pbag->data_offset);
-			hydra.pbag.resize(sf2.pdta.pbag->size/4);
-			for(auto& preset_zone : hydra.pbag)
-			{
-				preset_zone = std::make_unique<HYDRA::sfPresetBag>();
-				read_field(preset_zone->wGenNdx);
-				read_field(preset_zone->wModNdx);
-			}
-			//The PMOD sub-chunk is a required sub-chunk listing all
-			//preset zone modulators within the SoundFont compatible file.
-			//
-			/*Modulators in the PMOD sub-chunk act as additively
-			relative modulators with respect to those in the IMOD sub-chunk.
-			In other words, a PMOD modulator can increase or
-			decrease the amount of an IMOD modulator. */
-			s->setpos(sf2.pdta.pmod->data_offset);
-			hydra.pmod.resize(sf2.pdta.pmod->size/10);
-			for(auto& modulator : hydra.pmod)
-			{
-				modulator = std::make_unique<HYDRA::sfModList>();
-				read_field(modulator->sfModSrcOper);
-				read_field(modulator->sfModDestOper);
-				read_field(modulator->modAmount);
-				read_field(modulator->sfModAmtSrcOper);
-				read_field(modulator->sfModTransOper);
-			}
-			//The PGEN chunk is a required chunk containing a list
-			//of preset zone generators for each preset zone within the SoundFont
-			//compatible file.
-			//
-			/*The preset zones wGenNdx points to the first generator
-			for that preset zone. Unless the zone is a global zone, the last
-			generator in the list is an Instrument generator,
-			whose value is a pointer to the instrument associated with that zone.
-			If a key range generator exists for the preset zone,
-			it is always the first generator in the list for that preset zone.
-			If a velocity range generator exists for the preset zone,
-			it will only be preceded by a key range generator. If any generators follow an
-			Instrument generator, they will be ignored.
-
-			A generator is defined by its sfGenOper.
-			All generators within a zone must have a unique sfGenOper enumerator.
-			If a second generator is encountered with the same sfGenOper enumerator
-			as a previous generator with the same zone, the first
-			generator will be ignored.
-
-			Generators in the PGEN sub-chunk are applied relative to generators
-			in the IGEN sub-chunk in an additive manner.
-			In other words, PGEN generators increase or decrease the value
-			of an IGEN generator. */
-			s->setpos(sf2.pdta.pgen->data_offset);
-			hydra.pgen.resize(sf2.pdta.pgen->size/4);
-			for(auto& generator : hydra.pgen)
-			{
-				generator = std::make_unique<HYDRA::sfGenList>();
-				read_field(generator->sfGenOper);
-				read_field(generator->genAmount);
-			}
-			//The inst sub-chunk is a required sub-chunk listing all
-			//instruments within the SoundFont compatible file.
-			s->setpos(sf2.pdta.inst->data_offset);
-			hydra.inst.resize(sf2.pdta.inst->size/22);
-			for(auto& instrument : hydra.inst)
-			{
-				instrument = std::make_unique<HYDRA::sfInst>();
-				read_field(instrument->achInstName);
-				//null-terminate instrument name
-				//you think it's funny not to terminate a string, soundfont editing software?
-				instrument->achInstName[19] = 0;
-				read_field(instrument->wInstBagNdx);
-			}
-			//The IBAG sub-chunk is a required sub-chunk listing all
-			//instrument zones within the SoundFont compatible file. 
-			//
-			/*The first zone in a given instrument is located at that
-			instruments wInstBagNdx. The number of zones in the instrument is
-			determined by the difference between the next instruments wInstBagNdx
-			and the current wInstBagNdx.
-
-			If an instrument has more than one zone, the first zone may be a global zone.
-			A global zone is determined by the fact that the last generator in the list
-			is not a sampleID generator. All generator lists must contain at least
-			one generator with one exception - if a global zone exists for which there
-			are no generators but only modulators. The modulator lists can contain
-			zero or more modulators. */
-			s->setpos(sf2.pdta.ibag->data_offset);
-			hydra.ibag.resize(sf2.pdta.ibag->size/4);
-			for(auto& instrument_zone : hydra.ibag)
-			{
-				instrument_zone = std::make_unique<HYDRA::sfInstBag>();
-				read_field(instrument_zone->wInstGenNdx);
-				read_field(instrument_zone->wInstModNdx);
-			}
-			//The IMOD sub-chunk is a required sub-chunk listing all
-			//instrument zone modulators within the SoundFont compatible file.
-			//
-			/*The zones wInstModNdx points to the first modulator for that zone,
-			and the number of modulators present for a zone is determined
-			by the difference between the next higher zones wInstModNdx
-			and the current zones wModNdx.
-			A difference of zero indicates there are no modulators in this zone.
-
-			Modulators in the IMOD sub-chunk are absolute.
-			This means that an IMOD modulator replaces, rather than adds to, a
-			default modulator. However the effect of a modulator on a generator
-			is additive, IE the output of a modulator adds to a generator value. */
-			s->setpos(sf2.pdta.imod->data_offset);
-			hydra.imod.resize(sf2.pdta.imod->size/10);
-			for(auto& instrument_zone_modulator : hydra.imod)
-			{
-				instrument_zone_modulator = std::make_unique<HYDRA::sfInstModList>();
-				read_field(instrument_zone_modulator->sfModSrcOper);
-				read_field(instrument_zone_modulator->sfModDestOper);
-				read_field(instrument_zone_modulator->modAmount);
-				read_field(instrument_zone_modulator->sfModAmtSrcOper);
-				read_field(instrument_zone_modulator->sfModTransOper);
-			}
-			//The IGEN chunk is a required chunk containing a list of zone generators
-			//for each instrument zone within the SoundFont compatible file.
-			//
-			/*The zones wInstGenNdx points to the first generator for that zone.
-			Unless the zone is a global zone, the last generator in the list is
-			a sampleID generator, whose value is a pointer to the sample associated
-			with that zone. If a key range generator exists for the zone, it is always
-			the first generator in the list for that zone. If a velocity range generator
-			exists for the zone, it will only be preceded by a key range generator.
-			If any generators follow a sampleID generator, they will be ignored.
-
-			Generators in the IGEN sub-chunk are absolute in nature.
-			This means that an IGEN generator replaces, rather than adds to,
-			the default value for the generator. */
-			s->setpos(sf2.pdta.igen->data_offset);
-			hydra.igen.resize(sf2.pdta.igen->size/4);
-			for(auto& zone_generator : hydra.igen)
-			{
-				zone_generator = std::make_unique<HYDRA::sfInstGenList>();
-				read_field(zone_generator->sfGenOper);
-				read_field(zone_generator->genAmount);
-			}
-			//The SHDR chunk is a required sub-chunk listing all samples within the smpl
-			//sub-chunk and any referenced ROM samples.
-			//
-			/*The values of dwStart, dwEnd, dwStartloop, and dwEndloop must all be within
-			the range of the sample data field included in the SoundFont compatible bank
-			or referenced in the sound ROM. Also, to allow a variety of hardware platforms
-			to be able to reproduce the data, the samples have a minimum length of 48 data
-			points, a minimum loop size of 32 data points and a minimum of 8 valid points
-			prior to dwStartloop and after dwEndloop.
-			Thus dwStart must be less than dwStartloop-7, dwStartloop must be less than
-			dwEndloop-31, and dwEndloop must be less than dwEnd-7.
-			If these constraints are not met, the sound may optionally not be played
-			if the hardware cannot support artifact-free playback for the parameters given.
-
-			Sample rate values of greater than 50000 or less than 400 may not be reproducible
-			by some hardware platforms and should be avoided. A value of zero is illegal.
-			If an illegal or impractical value is encountered, the nearest practical value
-			should be used.
-
-			If sfSampleType indicates a mono sample, then wSampleLink is undefined and
-			its value should be conventionally zero, but will be ignored regardless of value.
-			If sfSampleType indicates a left or right sample, then wSampleLink is the sample
-			header index of the associated right or left stereo sample respectively.
-			Both samples should be played entirely syncrhonously, with their pitch controlled
-			by the right samples generators. All non-pitch generators should apply as normal;
-			in particular the panning of the individual samples to left and right should
-			be accomplished via the pan generator.
-			Left-right pairs should always be found within the same instrument.
-			Note also that no instrument should be designed in which it is possible to
-			activate more than one instance of a particular stereo pair. The linked sample
-			type is not currently fully defined in the SoundFont 2 specification,
-			but will ultimately support a circularly linked list of samples using 
-			wSampleLink. Note that this enumeration is two bytes in length. */
-			s->setpos(sf2.pdta.shdr->data_offset);
-			hydra.shdr.resize(sf2.pdta.shdr->size/46);
-			for(auto& sample : hydra.shdr)
-			{
-				sample = std::make_unique<HYDRA::sfSample>();
-				read_field(sample->achSampleName);
-				//null-terminate sample name
-				//unfortunately, some soundfonts don't do that!
-				sample->achSampleName[19] = 0;
-				read_field(sample->dwStart);
-				read_field(sample->dwEnd);
-				read_field(sample->dwStartloop);
-				read_field(sample->dwEndloop);
-				read_field(sample->dwSampleRate);
-				read_field(sample->byOriginalKey);
-				read_field(sample->chCorrection);
-				read_field(sample->wSampleLink);
-				s->read(&sample->sfSampleType, sizeof(WORD));
-			}
-
-#undef read_zstr
-#undef read_versiontag
-#undef read_field
-
-			//save stream
-			stream = s;
-
-			//Translate HYDRA structure data
-			//========================================================================
-			SF2_DEBUG_OUTPUT("Parsing HYDRA data...\n");
-			SF2_DEBUG_OUTPUT("Scanning banks...\n");
-			//Scan banks
-			for(size_t i = 0; i < hydra.phdr.size(); ++i)
-			{
-				//check for already listed ones
-				for(auto& b : banks)
-				{
-					if(b->num == hydra.phdr[i]->wBank)
-					{
-						//already exists, skip
-						goto next_preset;
-					}
-				}
-				//not listed yet, add to the list
-				banks.emplace_back(std::make_unique<Bank>());
-				banks.back()->num = hydra.phdr[i]->wBank;
-			next_preset:{}
-			}
-
-			//Load samples
-			SF2_DEBUG_OUTPUT("Loading samples...\n");
-			samples.resize(hydra.shdr.size()-1);
-			for(auto& sample : samples) sample = std::make_unique<Sample>();
-
-			{
-				size_t i = 0;
-				for(auto sample = hydra.shdr[i].get(); sample != hydra.shdr.back().get(); ++i, sample = hydra.shdr[i].get())
-				{
-					samples[i]->name = (const char*)sample->achSampleName;
-					samples[i]->sample_rate = sample->dwSampleRate;
-					//need to subtract stream offset from loop points
-					//to get them to be local to the data buffer pointer
-					samples[i]->loop_start = sample->dwStartloop - sample->dwStart;
-					samples[i]->loop_end = sample->dwEndloop - sample->dwStart;
-					samples[i]->original_key = sample->byOriginalKey;
-					samples[i]->correction = sample->chCorrection;
-					samples[i]->sample_type = sample->sfSampleType;
-					//check sfSampleType and try to fix
-					if(!CheckSampleLinkType(samples[i]->sample_type))
-					{
-						samples[i]->sample_type = SFSampleLink::monoSample;
-					}
-					if(samples[i]->sample_type != SFSampleLink::monoSample)
-						samples[i]->linked_sample = samples[sample->wSampleLink].get();
-					else samples[i]->linked_sample = nullptr;
-					//Don't load sample data but prepare it for on demand streaming
-					//or manually requested loading
-					samples[i]->data_stream_offset = sample->dwStart;
-					samples[i]->size = sample->dwEnd/* + 46*/ - sample->dwStart;
-					samples[i]->data = nullptr;
-
-					//test load
-					//samples[i]->load_data(*this, s);
-				}
-			}
-
-			//Load instruments
-			SF2_DEBUG_OUTPUT("Loading instruments...\n");
-			instruments.resize(hydra.inst.size()-1);
-			{
-				size_t i = 0;
-				for(auto inst = hydra.inst[i].get(); inst != hydra.inst.back().get(); ++i, inst = hydra.inst[i].get())
-				{
-
-					instruments[i] = std::make_unique<Instrument>();
-					instruments[i]->name = (const char*)hydra.inst[i]->achInstName;
-					{
-						std::unique_ptr<Instrument::Zone> global_zone;
-
-						size_t j = inst->wInstBagNdx;
-						//first zone of the next instrument marks the end of the current
-						//instrument zone list
-						auto iz_end = hydra.ibag[hydra.inst[i+1]->wInstBagNdx].get();
-						//for each instrument zone
-						for(auto iz = hydra.ibag[j].get(); iz != iz_end; ++j, iz = hydra.ibag[j].get())
-						{							
-							auto split = std::make_unique<Instrument::Zone>();
-							//Only instrument generators have default values
-							split->modEnv.SetToDefault();
-							split->volEnv.SetToDefault();
-
-							/*Points below (until noted) apply to Value Generators ONLY. */
-							/*
-							A generator in a global instrument zone that is identical to a default
-							generator supersedes or replaces the default generator. 
-							*/
-							if(global_zone)
-							{
-								//split->CopyValueGenerators(*global_zone);
-								*split = *global_zone;
-							}
-
-							size_t k = iz->wInstGenNdx;
-							auto igen_end = hydra.igen[hydra.ibag[j+1]->wInstGenNdx].get();
-							//for each generator
-							for(auto ig = hydra.igen[k].get(); ig != igen_end; ++k, ig = hydra.igen[k].get())
-							{
-								/*
-								A generator in a local instrument zone that is identical to a default
-								generator or to a generator in a global instrument zone supersedes or
-								replaces that generator. 
-								*/
-								switch(ig->sfGenOper.enumeration)
-								{
-								case SFGenerator::GenType::sampleID:
-								{
-									split->sample =	samples[ig->genAmount.wAmount].get();
-									break;
-								}
-								case SFGenerator::GenType::startAddrsOffset:
-								{
-									split->start_offset += ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::startAddrsCoarseOffset:
-								{
-									split->start_offset += ig->genAmount.shAmount*32768;
-									break;
-								}
-								case SFGenerator::GenType::endAddrsOffset:
-								{
-									split->end_offset += ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::endAddrsCoarseOffset:
-								{
-									split->end_offset += ig->genAmount.shAmount*32768;
-									break;
-								}
-								case SFGenerator::GenType::startloopAddrsOffset:
-								{
-									split->loop_start_offset += ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::startloopAddrsCoarseOffset:
-								{
-									split->loop_start_offset += ig->genAmount.shAmount*32768;
-									break;
-								}
-								case SFGenerator::GenType::endloopAddrsOffset:
-								{
-									split->loop_end_offset += ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::endloopAddrsCoarseOffset:
-								{
-									split->loop_end_offset += ig->genAmount.shAmount*32768;
-									break;
-								}
-								case SFGenerator::GenType::modLfoToPitch:
-								{
-									split->modLFO_to_pitch = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::vibLfoToPitch:
-								{
-									split->vibLFO_to_pitch = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::modEnvToPitch:
-								{
-									split->modEnv_to_pitch = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::initialFilterFc:
-								{
-									split->filter_freq = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::initialFilterQ:
-								{
-									split->filter_q = ig->genAmount.shAmount / 10.0f;
-									break;
-								}
-								case SFGenerator::GenType::modLfoToFilterFc:
-								{
-									split->modLFO_to_filter_fc = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::modEnvToFilterFc:
-								{
-									split->modEnv_to_filter_fc = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::modLfoToVolume:
-								{
-									split->modLFO_to_volume = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::chorusEffectsSend:
-								{
-									split->chorus_send = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::reverbEffectsSend:
-								{
-									split->reverb_send = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::pan:
-								{
-									split->pan = float(ig->genAmount.shAmount)/1000.0f;
-									break;
-								}
-								case SFGenerator::GenType::delayModLFO:
-								{
-									split->modLFO.delay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::freqModLFO:
-								{
-									split->modLFO.frequency = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::delayVibLFO:
-								{
-									split->vibLFO.delay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::freqVibLFO:
-								{
-									split->vibLFO.frequency = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::delayModEnv:
-								{
-									split->modEnv.delay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::attackModEnv:
-								{
-									split->modEnv.attack = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::holdModEnv:
-								{
-									split->modEnv.hold = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::decayModEnv:
-								{
-									split->modEnv.decay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::sustainModEnv:
-								{
-									split->modEnv.sustain = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::releaseModEnv:
-								{
-									split->modEnv.release = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::keynumToModEnvHold:
-								{
-									split->modEnv.keynumToHold = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::keynumToModEnvDecay:
-								{
-									split->modEnv.keynumToDecay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::delayVolEnv:
-								{
-									split->volEnv.delay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::attackVolEnv:
-								{
-									split->volEnv.attack = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::holdVolEnv:
-								{
-									split->volEnv.hold = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::decayVolEnv:
-								{
-									split->volEnv.decay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::sustainVolEnv:
-								{
-									split->volEnv.sustain = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::releaseVolEnv:
-								{
-									split->volEnv.release = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::keynumToVolEnvHold:
-								{
-									split->volEnv.keynumToHold = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::keynumToVolEnvDecay:
-								{
-									split->volEnv.keynumToDecay = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::keyRange:
-								{
-									split->key_low = ig->genAmount.ranges.byLo;
-									split->key_high = ig->genAmount.ranges.byHi;
-									break;
-								}
-								case SFGenerator::GenType::velRange:
-								{
-									split->vel_low = ig->genAmount.ranges.byLo;
-									split->vel_high = ig->genAmount.ranges.byHi;
-									break;
-								}
-								case SFGenerator::GenType::keynum:
-								{
-									split->keynum = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::velocity:
-								{
-									split->velocity = ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::initialAttenuation:
-								{
-									split->attenuation = float(ig->genAmount.shAmount)/10.0f;
-									break;
-								}
-								case SFGenerator::GenType::coarseTune:
-								{
-									split->tune += ig->genAmount.shAmount*100;
-									break;
-								}
-								case SFGenerator::GenType::fineTune:
-								{
-									split->tune += ig->genAmount.shAmount;
-									break;
-								}
-								case SFGenerator::GenType::sampleModes:
-								{
-									switch(ig->genAmount.wAmount & 3)
-									{
-									case 0: split->loop_mode = LoopMode::None; break;
-									case 1: split->loop_mode = LoopMode::Continuous; break;
-									case 2: split->loop_mode = LoopMode::None; break;
-									case 3: split->loop_mode = LoopMode::Sustain; break;
-									}
-									break;
-								}
-								case SFGenerator::GenType::scaleTuning:
-								{
-									//[0;1] range
-									split->scale_tuning = float(ig->genAmount.shAmount)/100.0f;
-									break;
-								}
-								case SFGenerator::GenType::exclusiveClass:
-								{
-									split->exclusive_class = ig->genAmount.wAmount;
-									break;
-								}
-								case SFGenerator::GenType::overridingRootKey:
-								{
-									split->root_key = ig->genAmount.shAmount;
-									break;
-								}
-								}
-							}
-							//if last generator is not a sampleID generator
-							if(split->sample == nullptr)
-							{
-								//also must be more than one zone for a global one to exist
-								//and it also must be first zone in the list
-								if(j == inst->wInstBagNdx && (hydra.inst[i+1]->wInstBagNdx - inst->wInstBagNdx) > 1)
-								{
-									//global zone detected
-									//instruments[i]->global_zone = split;
-									global_zone = std::move(split);
-								} else goto discard_zone;
-							} else instruments[i]->splits.push_back(std::move(split));
-
-							continue;
-						discard_zone:
-							{
-								instruments[i]->splits.erase(
-									instruments[i]->splits.begin()+instruments[i]->splits.size()-1
-								);
-							}
-							global_zone = nullptr;
-						}
-					}
-
-					//instrument zone list
-					auto zones = hydra.ibag[hydra.inst[i]->wInstBagNdx].get();
-					auto zone_gen = hydra.igen[zones->wInstGenNdx].get();
-					int dummy_dum = 0;
-				}
-			}
-
-			//Load presets
-			SF2_DEBUG_OUTPUT("Loading presets...\n");
-			for(size_t i = 0; i < hydra.phdr.size()-1; ++i)
-			{
-				auto p = std::make_unique<Preset>();
-				p->name = (const char*)hydra.phdr[i]->achPresetName;
-				p->num = hydra.phdr[i]->wPreset;
-
-				//a global zone is a first zone and may only exist if
-				//there is more than one zone for a given preset
-				//Preset::Zone* global_zone = nullptr;
-				auto global_zone_begin = hydra.pgen.begin();
-				auto global_zone_end = global_zone_begin;
-
-				if((hydra.phdr[i+1]->wPresetBagNdx - hydra.phdr[i]->wPresetBagNdx) > 1)
-				{
-					//Get first zone of the preset
-					auto zone = hydra.pbag[hydra.phdr[i]->wPresetBagNdx].get();
-					//Get first generator of the next zone to acts as an end of the current list.
-					//For this to work, there exists a dummy terminator zone in the end of the
-					//PGEN chunk just so we can iterate all of them using this method.
-					auto pgen_end = hydra.pgen.begin()+hydra.pbag[hydra.phdr[i]->wPresetBagNdx+1]->wGenNdx;
-					//if zone isn't empty
-					if(pgen_end != hydra.pgen.begin())
-					{
-						//if last generator isn't an instrument generator
-						if((*(pgen_end - 1))->sfGenOper != SFGenerator::GenType::instrument)
-						{
-							//store global zone iterators
-							global_zone_begin = hydra.pgen.begin()+zone->wGenNdx;
-							global_zone_end = pgen_end;
-						}
-					}
-				}
-
-				{
-					size_t j = hydra.phdr[i]->wPresetBagNdx;
-					//first zone of the next preset marks the end of the current
-					//preset zone list
-					auto pz_end = hydra.pbag[hydra.phdr[i+1]->wPresetBagNdx].get();
-					//for each preset zone
-					for(auto pz = hydra.pbag[j].get(); pz != pz_end; ++j, pz = hydra.pbag[j].get())
-					{
-						//check if zone isn't empty
-						if(hydra.pgen.begin()+pz->wGenNdx == hydra.pgen.begin()+hydra.pbag[j+1]->wGenNdx)
-						{
-							//discard zone
-							continue;
-						}
-						//check if last generator isn't an instrument generator
-						if((*(hydra.pgen.begin()+hydra.pbag[j+1]->wGenNdx - 1))->sfGenOper != SFGenerator::GenType::instrument)
-						{
-							//discard zone
-							continue;
-						}
-
-						/*Points below (until noted) apply to Value Generators ONLY. */
-						/*
-						A generator in a local preset zone that is identical to a generator in
-						a global preset zone supersedes or replaces that generator in the global
-						preset zone. That generator then has its effects added to the destination-summing
-						node of all zones in the given instrument.
-						*/
-
-						std::vector<HYDRA::sfGenList*> generators;
-						//copy zone generators and supersede identical globals with locals
-						{							
-							//collect all generators from the global zone
-							for(auto pg = global_zone_begin; pg != global_zone_end; ++pg)
-							{
-								generators.push_back(pg->get());
-							}
-
-							//for each generator of the current preset zone
-							for(auto pg = hydra.pgen.begin()+pz->wGenNdx; pg != hydra.pgen.begin()+hydra.pbag[j+1]->wGenNdx; ++pg)
-							{
-								//try to find identical generator
-								for(auto gen = generators.begin(); gen != generators.end(); ++gen)
-								{
-									if((*gen)->sfGenOper == (*pg)->sfGenOper)
-									{
-										//replace global generator with local
-										*gen = pg->get();
-										goto pg_next_generator;
-									}
-								}
-								//generator is unique, has its effect added
-								generators.push_back(pg->get());
-							pg_next_generator:{}
-							}
-						}
-						//Get the zone instrument
-						//Instrument* instrument = instruments[(*(hydra.pgen.begin()+hydra.pbag[j+1]->wGenNdx - 1))->genAmount.wAmount];
-						//Initialize preset zone with instrument's zone
-						//*layer = instrument->splits;
-						//TODO: possibly precompute (combine with preset zones) splits for each preset
-
-						//check if no generators exist for this zone
-						if(generators.empty()) continue;
-
-						auto layer = std::make_unique<Preset::Zone>();
-
-						//for each generator
-						for(auto pg = generators.begin(); pg != generators.end(); ++pg)
-						{
-							switch((*pg)->sfGenOper.enumeration)
-							{
-							case SFGenerator::GenType::instrument:
-							{
-								layer->instrument = instruments[(*pg)->genAmount.wAmount].get();
-								break;
-							}
-							case SFGenerator::GenType::modLfoToPitch:
-							{
-								layer->modLFO_to_pitch = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::vibLfoToPitch:
-							{
-								layer->vibLFO_to_pitch = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::modEnvToPitch:
-							{
-								layer->modEnv_to_pitch = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::initialFilterFc:
-							{
-								layer->filter_freq = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::initialFilterQ:
-							{
-								layer->filter_q = (*pg)->genAmount.shAmount / 10.0f;
-								break;
-							}
-							case SFGenerator::GenType::modLfoToFilterFc:
-							{
-								layer->modLFO_to_filter_fc = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::modEnvToFilterFc:
-							{
-								layer->modEnv_to_filter_fc = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::modLfoToVolume:
-							{
-								layer->modLFO_to_volume = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::chorusEffectsSend:
-							{
-								layer->chorus_send = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::reverbEffectsSend:
-							{
-								layer->reverb_send = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::pan:
-							{
-								layer->pan = float((*pg)->genAmount.shAmount)/1000.0f;
-								break;
-							}
-							case SFGenerator::GenType::delayModLFO:
-							{
-								layer->modLFO.delay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::freqModLFO:
-							{
-								layer->modLFO.frequency = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::delayVibLFO:
-							{
-								layer->vibLFO.delay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::freqVibLFO:
-							{
-								layer->vibLFO.frequency = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::delayModEnv:
-							{
-								layer->modEnv.delay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::attackModEnv:
-							{
-								layer->modEnv.attack = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::holdModEnv:
-							{
-								layer->modEnv.hold = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::decayModEnv:
-							{
-								layer->modEnv.decay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::sustainModEnv:
-							{
-								layer->modEnv.sustain = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::releaseModEnv:
-							{
-								layer->modEnv.release = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::keynumToModEnvHold:
-							{
-								layer->modEnv.keynumToHold = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::keynumToModEnvDecay:
-							{
-								layer->modEnv.keynumToDecay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::delayVolEnv:
-							{
-								layer->volEnv.delay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::attackVolEnv:
-							{
-								layer->volEnv.attack = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::holdVolEnv:
-							{
-								layer->volEnv.hold = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::decayVolEnv:
-							{
-								layer->volEnv.decay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::sustainVolEnv:
-							{
-								layer->volEnv.sustain = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::releaseVolEnv:
-							{
-								layer->volEnv.release = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::keynumToVolEnvHold:
-							{
-								layer->volEnv.keynumToHold = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::keynumToVolEnvDecay:
-							{
-								layer->volEnv.keynumToDecay = (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::keyRange:
-							{
-								layer->key_low = (*pg)->genAmount.ranges.byLo;
-								layer->key_high = (*pg)->genAmount.ranges.byHi;
-								break;
-							}
-							case SFGenerator::GenType::velRange:
-							{
-								layer->vel_low = (*pg)->genAmount.ranges.byLo;
-								layer->vel_high = (*pg)->genAmount.ranges.byHi;
-								break;
-							}
-							case SFGenerator::GenType::initialAttenuation:
-							{
-								layer->attenuation = float((*pg)->genAmount.shAmount)/10.0f;
-								break;
-							}
-							case SFGenerator::GenType::coarseTune:
-							{
-								layer->tune += (*pg)->genAmount.shAmount*100;
-								break;
-							}
-							case SFGenerator::GenType::fineTune:
-							{
-								layer->tune += (*pg)->genAmount.shAmount;
-								break;
-							}
-							case SFGenerator::GenType::scaleTuning:
-							{
-								//[0;1] range
-								layer->scale_tuning = float((*pg)->genAmount.shAmount)/100.0f;
-								break;
-							}
-							}
-						}
-						//add layer to the list
-						p->layers.emplace_back(std::move(layer));
-					}
-				}
-
-				//find bank
-				for(auto& bank : banks)
-				{
-					if(bank->num == hydra.phdr[i]->wBank)
-					{
-						//add preset to the bank
-						bank->presets.emplace_back(std::move(p));
-						break;
-					}
-				}
-			}
-
-
-			SF2_DEBUG_OUTPUT("Sorting banks...\n");
-			//Sort banks
-			std::sort(
-				banks.begin(),
-				banks.end(),
-				[](auto&& a, auto&& b) { return a->num < b->num; });
-			SF2_DEBUG_OUTPUT("Sorting presets...\n");
-			//Sort presets
-			for(auto& bank : banks)
-			{
-				std::sort(
-					bank->presets.begin(),
-					bank->presets.end(),
-					[](auto&& a, auto&& b) { return a->num < b->num; });
-			}
-
-		}
-	};
-}
+#pragma once
+//if long comments quoting standard bother you,
+//use /\*(.|\n)*?\*/ regex command to remove them
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <map>
+#include <unordered_map>
+#include <tuple>
+#include <functional>
+#include <filesystem>
+#include <type_traits>
+
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SF2_SSE2_SUPPORTED
+#include <emmintrin.h>
+//AVX2 kernels are compiled regardless of compiler flags and selected at runtime
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define SF2_AVX2_SUPPORTED
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#endif
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SF2_IO_URING_SUPPORTED
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#endif
+
+#ifndef M_TAU
+#define M_TAU 6.28318530717958647692
+#endif
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#include "RIFF.hpp"
+#include "DynamicPool.hpp"
+#include "Arena.hpp"
+
+#ifdef SF2_DEBUG
+#define SF2_DEBUG_OUTPUT(msg) {printf(msg);}
+#else
+#define SF2_DEBUG_OUTPUT(msg) {}
+#endif
+
+namespace SF2
+{
+	using namespace RIFF::literals;
+
+	typedef uint8_t byte;
+	typedef uint16_t word;
+	typedef uint32_t doubleword;
+	typedef int8_t CHAR;
+	typedef uint8_t BYTE;
+	typedef int16_t SHORT;
+	typedef uint16_t WORD;
+	typedef uint32_t DWORD;
+
+	double fastPow(double a, double b) {
+		union {
+			double d;
+			int x[2];
+		} u = { a };
+		u.x[1] = (int)(b * (u.x[1] - 1072632447) + 1072632447);
+		u.x[0] = 0;
+		return u.d;
+	}
+
+	inline float cents_to_hertz(float cents)
+	{
+		return std::pow(2.0f, cents / 1200.0f);
+	}
+	inline float hertz_to_cents(float hz)
+	{
+		return 1200.0f * std::log2(hz);
+	}
+	inline float decibels_to_gain(float db)
+	{
+		//return (db > -100.0f)?std::pow(10.0f, db * 0.05f):0.0f;		
+		return (db > -100.0f)?fastPow(10.0f, db * 0.05f):0.0f;
+	}
+	inline float gain_to_decibels(float gain)
+	{
+		return (gain <= 0.00001f)?-100.0f:(20.0f * std::log10(gain));
+	}
+	inline float calc_interval_cents(float hz1, float hz2)
+	{
+		return hertz_to_cents(hz2/hz1);
+	}
+	inline float apply_interval_cents(float hz, float cents)
+	{
+		return hz*cents_to_hertz(cents);
+	}
+	float timecents_to_seconds(float timecents)
+	{		
+		//return (timecents == -32768)?0.000001f:std::pow(2.0f, timecents / 1200.0f);
+		return (timecents <= -12000)?0.001f:std::pow(2.0f, timecents / 1200.0f);
+	}
+	float seconds_to_timecents(float seconds)
+	{
+		return 1200.0f*std::log2(seconds);
+	}
+	inline void constant_power_pan(float& factor_L, float& factor_R, float pan)
+	{
+		//constant is sqrt(2.0)/2.0
+		constexpr const float sqrt2_2 = 0.70710678f;
+		pan = pan*M_TAU*0.125f;
+		factor_L = sqrt2_2*(cos(pan)-sin(pan));
+		factor_R = sqrt2_2*(cos(pan)+sin(pan));
+	}
+	inline float clamp_panning(float pan)
+	{
+		pan = std::max(std::min(pan, 2.0f), -2.0f);
+		pan = (pan > 1.0f)?(2.0f-pan):((pan < -1.0f)?-(-2.0f+pan):pan);
+		return pan;
+	}
+	inline float lerp(float a, float b, float f)
+	{
+		return (a * (1.0f - f)) + (b * f);
+	}
+	//algebraically simplified algorithm, less precise
+	inline float fast_lerp(float a, float b, float f)
+	{
+		return a + f * (b - a);
+	}
+	//input must be in range [0, 127]
+	//might as well precompute a table for it later
+	//TODO: write a program to precompute 127 values for convex curve
+	inline float convex_curve(float input)
+	{
+		if(input == 0.0f) return 0.0f;//mathematically undefined
+		return 1.0f+20.0f*std::log10((input*input)/(127.0f*127.0f))/96.0f;
+	}
+	inline float concave_curve(float input)
+	{
+		return 1.0f-convex_curve(127.0f-input);
+	}
+
+	//Converts 16 bit PCM to float, or 24 bit PCM if the least significant bytes
+	//are provided in "data24"
+	//Single precision division gives exactly the same results as double precision
+	//for all 16 and 24 bit values, SIMD versions rely on that
+	inline void convert_samples_scalar(float* dest, const int16_t* data16, const uint8_t* data24, size_t count)
+	{
+		if(data24)
+		{
+			//combine both buffers and convert
+			for(size_t j = 0; j < count; ++j)
+				dest[j] = (float)((int32_t(data16[j]) * 256) | data24[j]) / 8388607.0f;
+		}
+		else
+		{
+			//just convert
+			for(size_t j = 0; j < count; ++j)
+				dest[j] = (float)data16[j] / 32767.0f;
+		}
+	}
+
+#ifdef SF2_SSE2_SUPPORTED
+	inline void convert_samples_sse2(float* dest, const int16_t* data16, const uint8_t* data24, size_t count)
+	{
+		size_t j = 0;
+		if(data24)
+		{
+			const __m128 scale = _mm_set1_ps(8388607.0f);
+			const __m128i zero = _mm_setzero_si128();
+			for(; j + 8 <= count; j += 8)
+			{
+				__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data16 + j));
+				__m128i lo = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data24 + j)), zero);
+				//place the 16 bit word above the extra byte,
+				//arithmetic shift by 8 sign extends the result
+				__m128i v0 = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_slli_epi16(lo, 8), hi), 8);
+				__m128i v1 = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_slli_epi16(lo, 8), hi), 8);
+				_mm_storeu_ps(dest + j, _mm_div_ps(_mm_cvtepi32_ps(v0), scale));
+				_mm_storeu_ps(dest + j + 4, _mm_div_ps(_mm_cvtepi32_ps(v1), scale));
+			}
+		}
+		else
+		{
+			const __m128 scale = _mm_set1_ps(32767.0f);
+			for(; j + 8 <= count; j += 8)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data16 + j));
+				//sign extend to 32 bit
+				__m128i v0 = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+				__m128i v1 = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+				_mm_storeu_ps(dest + j, _mm_div_ps(_mm_cvtepi32_ps(v0), scale));
+				_mm_storeu_ps(dest + j + 4, _mm_div_ps(_mm_cvtepi32_ps(v1), scale));
+			}
+		}
+		convert_samples_scalar(dest + j, data16 + j, data24?data24 + j:nullptr, count - j);
+	}
+#endif
+
+#ifdef SF2_AVX2_SUPPORTED
+#if defined(__GNUC__) || defined(__clang__)
+	__attribute__((target("avx2")))
+#endif
+	inline void convert_samples_avx2(float* dest, const int16_t* data16, const uint8_t* data24, size_t count)
+	{
+		size_t j = 0;
+		if(data24)
+		{
+			const __m256 scale = _mm256_set1_ps(8388607.0f);
+			for(; j + 8 <= count; j += 8)
+			{
+				__m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data16 + j)));
+				__m256i lo = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data24 + j)));
+				__m256i v = _mm256_or_si256(_mm256_slli_epi32(hi, 8), lo);
+				_mm256_storeu_ps(dest + j, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+			}
+		}
+		else
+		{
+			const __m256 scale = _mm256_set1_ps(32767.0f);
+			for(; j + 8 <= count; j += 8)
+			{
+				__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data16 + j)));
+				_mm256_storeu_ps(dest + j, _mm256_div_ps(_mm256_cvtepi32_ps(v), scale));
+			}
+		}
+		convert_samples_scalar(dest + j, data16 + j, data24?data24 + j:nullptr, count - j);
+	}
+
+	inline bool cpu_supports_avx2()
+	{
+		static const bool supported = []
+		{
+		#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			if(info[0] < 7) return false;
+			__cpuid(info, 1);
+			//OS has to save AVX registers
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			if(!osxsave || (_xgetbv(0) & 6) != 6) return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+		#else
+			return __builtin_cpu_supports("avx2") != 0;
+		#endif
+		}();
+		return supported;
+	}
+#endif
+
+	//Converts 16 bit PCM to float, or 24 bit PCM if the least significant bytes
+	//are provided in "data24", uses the widest instruction set available
+	inline void convert_samples(float* dest, const int16_t* data16, const uint8_t* data24, size_t count)
+	{
+	#ifdef SF2_AVX2_SUPPORTED
+		if(cpu_supports_avx2())
+			return convert_samples_avx2(dest, data16, data24, count);
+	#endif
+	#ifdef SF2_SSE2_SUPPORTED
+		convert_samples_sse2(dest, data16, data24, count);
+	#else
+		convert_samples_scalar(dest, data16, data24, count);
+	#endif
+	}
+
+	//In-memory format of sample data
+	enum class SampleFormat
+	{
+		//32 bit float, no conversion during rendering
+		Float = 0,
+		//16 bit PCM as stored in smpl chunk
+		Int16 = 1,
+		//24 bit PCM, smpl data combined with sm24 data, 3 bytes per frame
+		Int24 = 2,
+		//IEEE 754 half precision float
+		Half = 3,
+		//upper half of 32 bit float
+		BFloat16 = 4,
+		//lossless block compressed 16 bit PCM, or 24 bit PCM if the file has sm24 chunk,
+		//blocks are decoded on demand into a small cache of every voice playing them
+		Compressed = 5
+	};
+
+	inline size_t sample_format_size(SampleFormat format)
+	{
+		switch(format)
+		{
+		case SampleFormat::Int16:
+		case SampleFormat::Half:
+		case SampleFormat::BFloat16:
+			return 2;
+		case SampleFormat::Int24:
+			return 3;
+		//variable size, see compressed_size
+		case SampleFormat::Compressed:
+			return 0;
+		default:
+			return 4;
+		}
+	}
+
+	//Rounds to nearest even
+	inline uint16_t float_to_half(float value)
+	{
+	#if defined(__F16C__)
+		return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+	#else
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		uint16_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+		//infinity and NaN
+		if(((bits >> 23) & 0xFF) == 0xFF) return sign | 0x7C00 | (mantissa?0x200:0);
+		//overflow
+		if(exponent >= 31) return sign | 0x7C00;
+		uint32_t shift = 13;
+		if(exponent <= 0)
+		{
+			//underflow
+			if(exponent < -10) return sign;
+			//subnormal, make implicit bit explicit
+			mantissa |= 0x800000;
+			shift = 14 - exponent;
+			exponent = 0;
+		}
+		uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> shift);
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t midpoint = 1u << (shift - 1);
+		//carry into exponent is intended
+		if(remainder > midpoint || (remainder == midpoint && (half & 1))) ++half;
+		return sign | uint16_t(half);
+	#endif
+	}
+
+	inline float half_to_float(uint16_t value)
+	{
+	#if defined(__F16C__)
+		return _cvtsh_ss(value);
+	#else
+		uint32_t sign = uint32_t(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+		uint32_t bits;
+		if(exponent == 0x1F)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else if(exponent)
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		else if(mantissa)
+		{
+			//subnormal
+			float result = float(mantissa) * (1.0f / 16777216.0f);
+			return sign?-result:result;
+		}
+		else
+			bits = sign;
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	#endif
+	}
+
+	//Rounds to nearest even
+	inline uint16_t float_to_bfloat16(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		//keep NaN from rounding to infinity
+		if((bits & 0x7FFFFFFF) > 0x7F800000) return uint16_t((bits >> 16) | 0x40);
+		bits += 0x7FFF + ((bits >> 16) & 1);
+		return uint16_t(bits >> 16);
+	}
+
+	inline float bfloat16_to_float(uint16_t value)
+	{
+		uint32_t bits = uint32_t(value) << 16;
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	//Stores 16 bit PCM, or 24 bit PCM if the least significant bytes
+	//are provided in "data24", in the given format
+	inline void store_samples(uint8_t* dest, SampleFormat format, const int16_t* data16, const uint8_t* data24, size_t count)
+	{
+		switch(format)
+		{
+		case SampleFormat::Int16:
+			std::memcpy(dest, data16, count*sizeof(int16_t));
+			break;
+		case SampleFormat::Int24:
+			for(size_t j = 0; j < count; ++j)
+			{
+				dest[j*3] = data24?data24[j]:0;
+				dest[j*3+1] = ((const uint8_t*)&data16[j])[0];
+				dest[j*3+2] = ((const uint8_t*)&data16[j])[1];
+			}
+			break;
+		case SampleFormat::Half:
+		case SampleFormat::BFloat16:
+			//convert in blocks to keep SIMD conversion in use
+			for(size_t first = 0; first < count; first += 256)
+			{
+				float values[256];
+				size_t block = std::min<size_t>(count - first, 256);
+				convert_samples(values, data16 + first, data24?data24 + first:nullptr, block);
+				for(size_t j = 0; j < block; ++j)
+				{
+					uint16_t packed = (format == SampleFormat::Half)?
+						float_to_half(values[j]):float_to_bfloat16(values[j]);
+					std::memcpy(dest + (first + j)*sizeof(packed), &packed, sizeof(packed));
+				}
+			}
+			break;
+		default:
+			convert_samples(reinterpret_cast<float*>(dest), data16, data24, count);
+			break;
+		}
+	}
+
+	//Reads frame at "index" of data stored in the given format and converts it to float,
+	//gives the same result as convert_samples for Int16 and Int24
+	template <SampleFormat format>
+	inline float load_sample(const uint8_t* data, uint32_t index)
+	{
+		if constexpr(format == SampleFormat::Int16)
+		{
+			int16_t value;
+			std::memcpy(&value, data + size_t(index)*sizeof(value), sizeof(value));
+			return (float)value / 32767.0f;
+		}
+		else if constexpr(format == SampleFormat::Int24)
+		{
+			const uint8_t* frame = data + size_t(index)*3;
+			int32_t value = int32_t(
+				(uint32_t(frame[2]) << 24) |
+				(uint32_t(frame[1]) << 16) |
+				(uint32_t(frame[0]) << 8)
+				) >> 8;
+			return (float)value / 8388607.0f;
+		}
+		else if constexpr(format == SampleFormat::Half || format == SampleFormat::BFloat16)
+		{
+			uint16_t value;
+			std::memcpy(&value, data + size_t(index)*sizeof(value), sizeof(value));
+			if constexpr(format == SampleFormat::Half)
+				return half_to_float(value);
+			else
+				return bfloat16_to_float(value);
+		}
+		else
+		{
+			float value;
+			std::memcpy(&value, data + size_t(index)*sizeof(value), sizeof(value));
+			return value;
+		}
+	}
+
+	//Lossless compression of PCM data
+	//========================================================================
+	//Frames are split into blocks that are decoded independently.
+	//The first frame of a block is stored as is, the rest are predicted
+	//with a fixed polynomial predictor of order 0 to 3 chosen per block
+	//and residuals are Rice coded with a per block parameter.
+	//Layout: CompressedHeader, byte offsets of blocks and of the end,
+	//blocks, padding for the bit reader.
+	//Block: order in bits 5-6 and Rice parameter in bits 0-4 of the first byte,
+	//first frame in 16 or 24 bits, residuals, all bits most significant first.
+	//Residual: quotient in unary terminated by 0 and the remainder in k bits,
+	//or compressed_escape ones followed by 32 bits of the zigzag encoded residual.
+	constexpr uint32_t compressed_block_frames = 128;
+	constexpr uint32_t compressed_escape = 24;
+	constexpr size_t compressed_padding = 8;
+
+	struct CompressedHeader
+	{
+		//total size in bytes
+		uint32_t size;
+		uint32_t frames;
+		//16 or 24
+		uint32_t bits;
+		uint32_t blocks;
+	};
+
+	inline size_t compressed_size(const uint8_t* data)
+	{
+		if(!data) return 0;
+		CompressedHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		return header.size;
+	}
+
+	//Compresses "count" frames stored as Int16 or Int24
+	inline std::shared_ptr<const uint8_t[]> compress_samples(const uint8_t* pcm, SampleFormat pcm_format, uint32_t count)
+	{
+		CompressedHeader header;
+		header.frames = count;
+		header.bits = (pcm_format == SampleFormat::Int24)?24:16;
+		header.blocks = (count + compressed_block_frames - 1) / compressed_block_frames;
+		auto frame = [&](size_t index)->int32_t
+		{
+			if(pcm_format == SampleFormat::Int24)
+			{
+				const uint8_t* f = pcm + index*3;
+				return int32_t((uint32_t(f[2]) << 24) | (uint32_t(f[1]) << 16) | (uint32_t(f[0]) << 8)) >> 8;
+			}
+			int16_t value;
+			std::memcpy(&value, pcm + index*sizeof(value), sizeof(value));
+			return value;
+		};
+		//order 0 predicts zero, higher orders extrapolate previous frames
+		auto residual = [](const int32_t* x, size_t n, int order)->int64_t
+		{
+			order = std::min<int>(order, int(n));
+			switch(order)
+			{
+			case 0: return x[n];
+			case 1: return int64_t(x[n]) - x[n-1];
+			case 2: return int64_t(x[n]) - 2*int64_t(x[n-1]) + x[n-2];
+			default: return int64_t(x[n]) - 3*int64_t(x[n-1]) + 3*int64_t(x[n-2]) - x[n-3];
+			}
+		};
+
+		std::vector<uint8_t> out(sizeof(CompressedHeader) + (size_t(header.blocks) + 1) * sizeof(uint32_t), 0);
+		uint64_t bit_buffer = 0;
+		int bit_count = 0;
+		//up to 32 bits at once, less than 8 bits are pending between calls
+		auto put_bits = [&](uint32_t value, int count)
+		{
+			if(count < 32) value &= (1u << count) - 1;
+			bit_buffer = (bit_buffer << count) | value;
+			bit_count += count;
+			for(; bit_count >= 8; bit_count -= 8)
+				out.push_back(uint8_t(bit_buffer >> (bit_count - 8)));
+		};
+		auto flush_bits = [&]
+		{
+			if(bit_count) put_bits(0, 8 - bit_count);
+		};
+
+		int32_t x[compressed_block_frames];
+		uint32_t u[compressed_block_frames];
+		for(uint32_t block = 0; block < header.blocks; ++block)
+		{
+			uint32_t offset = (uint32_t)out.size();
+			std::memcpy(out.data() + sizeof(CompressedHeader) + block*sizeof(uint32_t), &offset, sizeof(offset));
+			size_t first = size_t(block) * compressed_block_frames;
+			uint32_t n = std::min<uint32_t>(compressed_block_frames, count - uint32_t(first));
+			for(uint32_t i = 0; i < n; ++i) x[i] = frame(first + i);
+			//pick the order with the smallest residuals
+			int order = 0;
+			uint64_t best = UINT64_MAX;
+			for(int o = 0; o <= 3; ++o)
+			{
+				uint64_t sum = 0;
+				for(uint32_t i = 1; i < n; ++i)
+				{
+					int64_t r = residual(x, i, o);
+					sum += uint64_t(r < 0?-r:r);
+				}
+				if(sum < best) { best = sum; order = o; }
+			}
+			uint64_t mean = 0;
+			for(uint32_t i = 1; i < n; ++i)
+			{
+				int64_t r = residual(x, i, order);
+				//zigzag, residuals of 24 bit data fit in 32 bits
+				u[i] = uint32_t((uint64_t(r) << 1) ^ uint64_t(r >> 63));
+				mean += u[i];
+			}
+			//Rice parameter near log2 of the mean, refined by exact cost
+			if(n > 1) mean /= n - 1;
+			int estimate = 0;
+			while(estimate < 31 && (mean >> estimate) > 1) ++estimate;
+			auto cost = [&](int k)
+			{
+				uint64_t bits = 0;
+				for(uint32_t i = 1; i < n; ++i)
+				{
+					uint32_t q = u[i] >> k;
+					bits += (q < compressed_escape)?q + 1 + k:compressed_escape + 32;
+				}
+				return bits;
+			};
+			int k = estimate;
+			uint64_t k_cost = cost(k);
+			for(int candidate : {estimate - 1, estimate + 1})
+			{
+				if(candidate < 0 || candidate > 31) continue;
+				uint64_t c = cost(candidate);
+				if(c < k_cost) { k = candidate; k_cost = c; }
+			}
+
+			put_bits(uint32_t(order << 5 | k), 8);
+			put_bits(uint32_t(x[0]) & ((1u << header.bits) - 1), header.bits);
+			for(uint32_t i = 1; i < n; ++i)
+			{
+				uint32_t q = u[i] >> k;
+				if(q < compressed_escape)
+				{
+					//q ones and a zero
+					put_bits(((1u << q) - 1) << 1, int(q) + 1);
+					put_bits(u[i], k);
+				}
+				else
+				{
+					put_bits((1u << compressed_escape) - 1, compressed_escape);
+					put_bits(u[i], 32);
+				}
+			}
+			flush_bits();
+		}
+		uint32_t end = (uint32_t)out.size();
+		std::memcpy(out.data() + sizeof(CompressedHeader) + size_t(header.blocks)*sizeof(uint32_t), &end, sizeof(end));
+		out.resize(out.size() + compressed_padding, 0);
+		header.size = (uint32_t)out.size();
+		std::memcpy(out.data(), &header, sizeof(header));
+
+		std::shared_ptr<uint8_t[]> result(new uint8_t[out.size()]);
+		std::memcpy(result.get(), out.data(), out.size());
+		return result;
+	}
+
+	//Decodes frames of "block" to float, gives the same result as load_sample
+	//for Int16 or Int24, returns the number of frames decoded
+	inline uint32_t decompress_block(const uint8_t* data, uint32_t block, float* dest)
+	{
+		CompressedHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		uint32_t offset;
+		std::memcpy(&offset, data + sizeof(CompressedHeader) + size_t(block)*sizeof(uint32_t), sizeof(offset));
+		uint32_t n = std::min<uint32_t>(compressed_block_frames, header.frames - block*compressed_block_frames);
+
+		//reads ahead up to 8 bytes, covered by the padding
+		const uint8_t* src = data + offset;
+		uint64_t bit_buffer = 0;
+		int bit_count = 0;
+		auto refill = [&]
+		{
+			while(bit_count <= 56)
+			{
+				bit_buffer |= uint64_t(*src++) << (56 - bit_count);
+				bit_count += 8;
+			}
+		};
+		auto get_bits = [&](int count)->uint32_t
+		{
+			if(count == 0) return 0;
+			if(bit_count < count) refill();
+			uint32_t value = uint32_t(bit_buffer >> (64 - count));
+			bit_buffer <<= count;
+			bit_count -= count;
+			return value;
+		};
+		auto get_unary = [&]
+		{
+			uint32_t q = 0;
+			while(q < compressed_escape)
+			{
+				if(bit_count == 0) refill();
+				bool one = bit_buffer >> 63;
+				bit_buffer <<= 1;
+				--bit_count;
+				if(!one) break;
+				++q;
+			}
+			return q;
+		};
+
+		uint32_t control = get_bits(8);
+		int order = (control >> 5) & 3;
+		int k = control & 31;
+		int32_t x[compressed_block_frames];
+		int shift = 32 - int(header.bits);
+		x[0] = int32_t(get_bits(int(header.bits)) << shift) >> shift;
+		for(uint32_t i = 1; i < n; ++i)
+		{
+			uint32_t q = get_unary();
+			uint32_t u = (q < compressed_escape)?((q << k) | get_bits(k)):get_bits(32);
+			int32_t r = int32_t(u >> 1) ^ -int32_t(u & 1);
+			switch(std::min<uint32_t>(order, i))
+			{
+			case 0: x[i] = r; break;
+			case 1: x[i] = r + x[i-1]; break;
+			case 2: x[i] = r + 2*x[i-1] - x[i-2]; break;
+			default: x[i] = r + 3*x[i-1] - 3*x[i-2] + x[i-3]; break;
+			}
+		}
+		float scale = (header.bits == 24)?8388607.0f:32767.0f;
+		for(uint32_t i = 0; i < n; ++i)
+			dest[i] = (float)x[i] / scale;
+		return n;
+	}
+
+	//Number of frames in an Ogg stream, taken from the granule position of its last page,
+	//"data" holds the end of the stream, 0 if no complete page is found in it
+	inline uint64_t ogg_stream_frames(const uint8_t* data, size_t size)
+	{
+		const size_t header_size = 27;
+		for(size_t pos = size; pos-- > 0;)
+		{
+			if(size - pos < header_size || std::memcmp(data + pos, "OggS", 4) != 0 || data[pos + 4] != 0) continue;
+			//page must be complete
+			if(pos + header_size + data[pos + 26] > size) continue;
+			int64_t granule;
+			std::memcpy(&granule, data + pos + 6, sizeof(granule));
+			//-1 marks pages where no packet ends
+			if(granule >= 0) return uint64_t(granule);
+		}
+		return 0;
+	}
+
+	//Calls "body" with every index below "count" on "threads" threads including
+	//the calling one, 0 uses all hardware threads, indices are handed out in order,
+	//the first exception stops handing out indices and is rethrown after all threads finish
+	template <typename F>
+	inline void parallel_for(size_t count, unsigned threads, F&& body)
+	{
+		if(threads == 0) threads = std::thread::hardware_concurrency();
+		threads = (unsigned)std::min<size_t>(std::max(threads, 1u), std::max<size_t>(count, 1));
+
+		std::atomic<size_t> next = 0;
+		std::mutex error_mutex;
+		std::exception_ptr error;
+		auto worker = [&]
+		{
+			for(size_t i; (i = next.fetch_add(1)) < count;)
+			{
+				try
+				{
+					body(i);
+				}
+				catch(...)
+				{
+					std::lock_guard<std::mutex> error_lock(error_mutex);
+					if(!error) error = std::current_exception();
+					//stop handing out work
+					next.store(count);
+				}
+			}
+		};
+		std::vector<std::thread> workers;
+		for(unsigned i = 1; i < threads; ++i)
+			workers.emplace_back(worker);
+		worker();
+		for(auto& thread : workers)
+			thread.join();
+		if(error) std::rethrow_exception(error);
+	}
+
+	//Identifies a file by its canonical path, size and modification time,
+	//empty if the file can't be accessed
+	inline std::string file_identity(const std::string& path)
+	{
+		std::error_code error;
+		auto canonical = std::filesystem::canonical(path, error);
+		if(error) return std::string();
+		auto size = std::filesystem::file_size(canonical, error);
+		if(error) return std::string();
+		auto time = std::filesystem::last_write_time(canonical, error);
+		if(error) return std::string();
+		return canonical.string() + "|" + std::to_string(size) + "|" +
+			std::to_string(time.time_since_epoch().count());
+	}
+
+	//Decoded sample data shared between SoundFont2 instances
+	//loaded from the same file, data is freed when the last user releases it
+	class SampleCache
+	{
+	public:
+		struct Key
+		{
+			std::string file;
+			//in frames from the start of smpl chunk
+			uint64_t offset;
+			uint32_t size;
+			SampleFormat format;
+
+			bool operator<(const Key& rhs) const
+			{
+				return std::tie(file, offset, size, format) < std::tie(rhs.file, rhs.offset, rhs.size, rhs.format);
+			}
+		};
+
+	private:
+		struct Entry
+		{
+			std::mutex mutex;
+			std::weak_ptr<const uint8_t[]> data;
+		};
+		std::mutex mutex;
+		std::map<Key, std::shared_ptr<Entry>> entries;
+		size_t purge_threshold = 64;
+
+		//Drops entries whose data has been freed, called with "mutex" held
+		void purge()
+		{
+			for(auto it = entries.begin(); it != entries.end();)
+			{
+				std::unique_lock<std::mutex> entry_lock(it->second->mutex, std::try_to_lock);
+				if(entry_lock.owns_lock() && it->second->data.expired())
+				{
+					entry_lock.unlock();
+					it = entries.erase(it);
+				}
+				else ++it;
+			}
+			purge_threshold = std::max<size_t>(64, entries.size()*2);
+		}
+
+	public:
+		static SampleCache& Global()
+		{
+			static SampleCache cache;
+			return cache;
+		}
+
+		//Returns cached data or the result of "load" which is cached,
+		//concurrent requests for the same key load it only once
+		template <typename F>
+		std::shared_ptr<const uint8_t[]> Get(const Key& key, F&& load)
+		{
+			std::shared_ptr<Entry> entry;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = entries.find(key);
+				if(it == entries.end())
+				{
+					//before inserting, as the new entry has no data yet and would be purged
+					if(entries.size() + 1 >= purge_threshold) purge();
+					it = entries.emplace(key, std::make_shared<Entry>()).first;
+				}
+				entry = it->second;
+			}
+			std::lock_guard<std::mutex> entry_lock(entry->mutex);
+			if(auto data = entry->data.lock()) return data;
+			std::shared_ptr<const uint8_t[]> data = load();
+			entry->data = data;
+			return data;
+		}
+
+		//Number of buffers currently in use
+		size_t Size()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			size_t count = 0;
+			for(auto& entry : entries)
+			{
+				std::lock_guard<std::mutex> entry_lock(entry.second->mutex);
+				if(!entry.second->data.expired()) ++count;
+			}
+			return count;
+		}
+	};
+
+#ifdef SF2_IO_URING_SUPPORTED
+	//Minimal io_uring for batches of reads, set up with raw system calls,
+	//not thread-safe
+	class IoUring
+	{
+		int ring_fd = -1;
+		void* sq_ring = MAP_FAILED;
+		size_t sq_ring_size = 0;
+		void* cq_ring = MAP_FAILED;
+		size_t cq_ring_size = 0;
+		io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+		size_t sqes_size = 0;
+
+		unsigned* sq_head = nullptr;
+		unsigned* sq_tail = nullptr;
+		unsigned sq_mask = 0;
+		unsigned* sq_array = nullptr;
+		unsigned sq_entries = 0;
+		unsigned* cq_head = nullptr;
+		unsigned* cq_tail = nullptr;
+		unsigned cq_mask = 0;
+		io_uring_cqe* cqes = nullptr;
+		//queued but not yet submitted
+		unsigned pending = 0;
+		//submitted but not yet completed
+		unsigned in_flight = 0;
+
+	public:
+		//"entries" is rounded up to a power of two by the kernel
+		IoUring(unsigned entries)
+		{
+			io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+			ring_fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+			if(ring_fd < 0) return;
+			sq_ring_size = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+			cq_ring_size = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+			bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+			if(single_mmap) sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+			sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+			if(sq_ring == MAP_FAILED) { close(); return; }
+			cq_ring = single_mmap?sq_ring:mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+			if(cq_ring == MAP_FAILED) { close(); return; }
+			sqes_size = params.sq_entries*sizeof(io_uring_sqe);
+			sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+			if(sqes == MAP_FAILED) { close(); return; }
+
+			auto sq = static_cast<uint8_t*>(sq_ring);
+			sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+			sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			sq_entries = params.sq_entries;
+			auto cq = static_cast<uint8_t*>(cq_ring);
+			cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		}
+		IoUring(const IoUring&) = delete;
+		IoUring& operator=(const IoUring&) = delete;
+		~IoUring() {close();}
+
+		//Waits for reads in flight first, so that their buffers can be freed afterwards
+		void close()
+		{
+			if(ring_fd >= 0) Drain();
+			if(sqes != MAP_FAILED) munmap(sqes, sqes_size);
+			if(cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+			if(sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+			if(ring_fd >= 0) ::close(ring_fd);
+			sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+			cq_ring = sq_ring = MAP_FAILED;
+			ring_fd = -1;
+		}
+
+		bool IsValid() const {return ring_fd >= 0;}
+
+		//Number of reads that can be queued before some complete,
+		//completion queue is twice the size of submission queue, so it can't overflow
+		unsigned Space() const
+		{
+			return sq_entries - pending - in_flight;
+		}
+
+		unsigned InFlight() const {return in_flight + pending;}
+
+		//Queues a read, returns false if the queue is full
+		bool Read(int fd, void* dest, uint32_t size, uint64_t offset, uint64_t user_data)
+		{
+			if(Space() == 0) return false;
+			unsigned tail = *sq_tail;
+			unsigned index = tail & sq_mask;
+			io_uring_sqe& sqe = sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_READ;
+			sqe.fd = fd;
+			sqe.addr = reinterpret_cast<uint64_t>(dest);
+			sqe.len = size;
+			sqe.off = offset;
+			sqe.user_data = user_data;
+			sq_array[index] = index;
+			//the kernel sees the entry once the tail moves past it
+			__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+			++pending;
+			return true;
+		}
+
+		//Submits queued reads and waits for at least "wait" completions,
+		//returns false on error
+		bool Submit(unsigned wait)
+		{
+			wait = std::min(wait, in_flight + pending);
+			if(!pending && !wait) return true;
+			for(;;)
+			{
+				int result = (int)syscall(__NR_io_uring_enter, ring_fd, pending, wait, wait?IORING_ENTER_GETEVENTS:0, nullptr, 0);
+				if(result >= 0)
+				{
+					pending -= (unsigned)result;
+					in_flight += (unsigned)result;
+					return true;
+				}
+				if(errno != EINTR) return false;
+			}
+		}
+
+		//Calls "f(user_data, result)" for every completed read,
+		//result is the number of bytes read or a negated error code
+		template <typename F>
+		unsigned Reap(F&& f)
+		{
+			unsigned count = 0;
+			unsigned head = *cq_head;
+			while(head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+			{
+				io_uring_cqe& cqe = cqes[head & cq_mask];
+				uint64_t user_data = cqe.user_data;
+				int32_t result = cqe.res;
+				++head;
+				__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+				--in_flight;
+				++count;
+				f(user_data, result);
+			}
+			return count;
+		}
+
+		//Waits until no submitted read is in flight, dropping their completions,
+		//returns false if waiting failed, then reads might still write to their buffers
+		bool Drain()
+		{
+			for(;;)
+			{
+				Reap([](uint64_t, int32_t){});
+				if(in_flight == 0) return true;
+				//nothing is submitted, queued reads never reach the kernel
+				int result = (int)syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if(result < 0 && errno != EINTR) return false;
+			}
+		}
+	};
+#endif
+
+	//SoundFont2-structured RIFF
+	//I was planning to use this for editing, but...
+	struct RIFF_SoundFont2
+	{
+		//Supplemental Information
+		struct INFO_chunk
+		{
+			RIFF::RIFF::chunk* ifil;
+			//Refers to the target Sound Engine
+			RIFF::RIFF::chunk* isng;
+			//Refers to the Sound Font Bank Name
+			RIFF::RIFF::chunk* INAM;
+			//Refers to the Sound ROM Name
+			RIFF::RIFF::chunk* irom;
+			//Refers to the Sound ROM Version
+			RIFF::RIFF::chunk* iver;
+			//Refers to the Date of Creation of the Bank
+			RIFF::RIFF::chunk* ICRD;
+			//Sound Designers and Engineers for the Bank
+			RIFF::RIFF::chunk* IENG;
+			//Product for which the Bank was intended
+			RIFF::RIFF::chunk* IPRD;
+			//Contains any Copyright message
+			RIFF::RIFF::chunk* ICOP;
+			//Contains any Comments on the Bank
+			RIFF::RIFF::chunk* ICMT;
+			//The SoundFont tools used to create and alter the bank
+			RIFF::RIFF::chunk* ISFT;
+		};
+		INFO_chunk INFO;
+
+		//The Sample Binary Data
+		struct sdta_chunk
+		{
+			//The Digital Audio Samples for the upper 16 bits
+			RIFF::RIFF::chunk* smpl;
+			//The Digital Audio Samples for the lower 8 bits
+			RIFF::RIFF::chunk* sm24;
+		};
+		sdta_chunk sdta;
+
+		//The Preset, Instrument, and Sample Header data
+		struct pdta_chunk
+		{
+			//The Preset Headers
+			RIFF::RIFF::chunk* phdr;
+			//The Preset Index list
+			RIFF::RIFF::chunk* pbag;
+			//The Preset Modulator list
+			RIFF::RIFF::chunk* pmod;
+			//The Preset Generator list
+			RIFF::RIFF::chunk* pgen;
+			//The Instrument Names and Indices
+			RIFF::RIFF::chunk* inst;
+			//The Instrument Index list
+			RIFF::RIFF::chunk* ibag;
+			//The Instrument Modulator list
+			RIFF::RIFF::chunk* imod;
+			//The Instrument Generator list
+			RIFF::RIFF::chunk* igen;
+			//The Sample Headers
+			RIFF::RIFF::chunk* shdr;
+		};
+		pdta_chunk pdta;
+
+		bool structurally_unsound = false;
+
+		RIFF_SoundFont2(RIFF::RIFF* riff)
+		{
+#define cond_check(cond)\
+			{\
+				if(cond)\
+				{\
+					structurally_unsound = true;\
+					return;\
+				}\
+			}
+#define get_subchunk(chunk, list, id)\
+			{\
+				chunk.id = list->find(RIFF::constexpr_string_to_FOURCC(#id));\
+			}
+			auto& chunks = riff->chunks;
+			cond_check(chunks.empty());
+			//Check RIFF chunk, must be first
+			auto sfbk = chunks[0].get();
+			cond_check(sfbk->id != "RIFF"_FOURCC || sfbk->type != "sfbk"_FOURCC);
+			//Get INFO-list chunk
+			auto INFO_list = sfbk->find("LIST"_FOURCC, "INFO"_FOURCC);
+			//Check INFO-list chunk, must exist
+			cond_check(!INFO_list);
+			//Get INFO-list subchunks
+			get_subchunk(INFO, INFO_list, ifil);
+			get_subchunk(INFO, INFO_list, isng);
+			get_subchunk(INFO, INFO_list, INAM);
+			get_subchunk(INFO, INFO_list, irom);
+			get_subchunk(INFO, INFO_list, iver);
+			get_subchunk(INFO, INFO_list, ICRD);
+			get_subchunk(INFO, INFO_list, IENG);
+			get_subchunk(INFO, INFO_list, IPRD);
+			get_subchunk(INFO, INFO_list, ICOP);
+			get_subchunk(INFO, INFO_list, ICMT);
+			get_subchunk(INFO, INFO_list, ISFT);
+			//Check mandatory subchunks
+			cond_check(!INFO.ifil);
+
+			//Get sdta chunk
+			auto sdta_list = sfbk->find("LIST"_FOURCC, "sdta"_FOURCC);
+			//Check sdta chunk, must exist
+			cond_check(!sdta_list);
+			//Get sdta subchunks
+			get_subchunk(sdta, sdta_list, smpl);
+			get_subchunk(sdta, sdta_list, sm24);
+
+			//Get pdta chunk
+			auto pdta_list = sfbk->find("LIST"_FOURCC, "pdta"_FOURCC);
+			//Check pdta chunk, must exist
+			cond_check(!pdta_list);
+			//Get pdta subchunks
+			get_subchunk(pdta, pdta_list, phdr);
+			get_subchunk(pdta, pdta_list, pbag);
+			get_subchunk(pdta, pdta_list, pmod);
+			get_subchunk(pdta, pdta_list, pgen);
+			get_subchunk(pdta, pdta_list, inst);
+			get_subchunk(pdta, pdta_list, ibag);
+			get_subchunk(pdta, pdta_list, imod);
+			get_subchunk(pdta, pdta_list, igen);
+			get_subchunk(pdta, pdta_list, shdr);
+			//Check mandatory subchunks
+			cond_check(!sdta.smpl);
+			cond_check(!pdta.phdr || !pdta.pbag || !pdta.pmod || !pdta.pgen || !pdta.inst);
+			cond_check(!pdta.ibag || !pdta.imod || !pdta.igen || !pdta.shdr);
+
+			//Check chunk sizes
+			cond_check(pdta.phdr->size % 38);
+			cond_check(pdta.pbag->size % 4);
+			cond_check(pdta.pmod->size % 10);
+			cond_check(pdta.pgen->size % 4);
+			cond_check(pdta.inst->size % 22);
+			cond_check(pdta.ibag->size % 4);
+			cond_check(pdta.imod->size % 10);
+			cond_check(pdta.igen->size % 4);
+			cond_check(pdta.shdr->size % 46);
+
+#undef cond_check
+#undef get_subchunk
+		}
+	};
+
+	struct SoundFont2
+	{
+		struct rangesType
+		{
+			BYTE byLo;
+			BYTE byHi;
+
+			//expand
+			inline rangesType& operator+=(const rangesType& rhs)
+			{
+				byLo = std::min(byLo, rhs.byLo);
+				byHi = std::max(byHi, rhs.byHi);
+				return *this;
+			}
+			//expand
+			friend inline rangesType operator+(rangesType lhs, const rangesType& rhs)
+			{
+				lhs += rhs;
+				return lhs;
+			}
+			//intersect
+			inline rangesType& operator*=(const rangesType& rhs)
+			{
+				byLo = std::max(byLo, rhs.byLo);
+				byHi = std::min(byHi, rhs.byHi);
+				return *this;
+			}
+			//intersect
+			friend inline rangesType operator*(rangesType lhs, const rangesType& rhs)
+			{
+				lhs *= rhs;
+				return lhs;
+			}
+		};
+		typedef union
+		{
+			rangesType ranges;
+			SHORT shAmount;
+			WORD wAmount;
+		} genAmountType; 
+		typedef enum
+		{
+			monoSample = 1,
+			rightSample = 2,
+			leftSample = 4,
+			linkedSample = 8,
+			RomMonoSample = 0x8001,
+			RomRightSample = 0x8002,
+			RomLeftSample = 0x8004,
+			RomLinkedSample = 0x8008,
+			//SF3 extension, combined with the types above
+			//for samples compressed with Ogg Vorbis
+			compressedSample = 0x10
+		} SFSampleLink;
+		static bool IsSampleROM(SFSampleLink type) {return type & 0xFFF0;};
+		static bool CheckSampleLinkType(SFSampleLink type)
+		{
+			return (type >= 1 && type <= 8) || (type >= 0x8001 && type <= 0x8008);
+		};
+
+		struct SFModulator
+		{
+			WORD enumeration;
+		};
+		struct SFGenerator
+		{
+			enum class GenType : WORD
+			{
+				/*The offset, in sample data points, beyond the Start sample header parameter to the
+				first sample data point to be played for this instrument. For example, if Start were 7
+				and startAddrOffset were 2, the first sample data point played would be sample data
+				point 9. */
+				startAddrsOffset = 0,
+
+				/*The offset, in sample sample data points, beyond the End sample header parameter to
+				the last sample data point to be played for this instrument. For example, if End were
+				17 and endAddrOffset were -2, the last sample data point played would be sample
+				data point 15.*/
+				endAddrsOffset = 1,
+
+				/*The offset, in sample data points, beyond the Startloop sample header parameter to
+				the first sample data point to be repeated in the loop for this instrument. For
+				example, if Startloop were 10 and startloopAddrsOffset were -1, the first repeated
+				loop sample data point would be sample data point 9.*/
+				startloopAddrsOffset = 2,
+
+				/*The offset, in sample data points, beyond the Endloop sample header parameter to
+				the sample data point considered equivalent to the Startloop sample data point for the
+				loop for this instrument. For example, if Endloop were 15 and endloopAddrsOffset
+				were 2, sample data point 17 would be considered equivalent to the Startloop sample
+				data point, and hence sample data point 16 would effectively precede Startloop
+				during looping. */
+				endloopAddrsOffset = 3,
+
+				/*The offset, in 32768 sample data point increments beyond the Start sample header
+				parameter and the first sample data point to be played in this instrument. This
+				parameter is added to the startAddrsOffset parameter. For example, if Start were 5, 
+				startAddrsOffset were 3 and startAddrsCoarseOffset were 2, the first sample data
+				point played would be sample data point 65544. */
+				startAddrsCoarseOffset = 4,
+
+				/*This is the degree, in cents, to which a full scale excursion of the Modulation LFO
+				will influence pitch. A positive value indicates a positive LFO excursion increases
+				pitch; a negative value indicates a positive excursion decreases pitch. Pitch is always
+				modified logarithmically, that is the deviation is in cents, semitones, and octaves
+				rather than in Hz. For example, a value of 100 indicates that the pitch will first rise 1
+				semitone, then fall one semitone. */
+				modLfoToPitch = 5,
+
+				/*This is the degree, in cents, to which a full scale excursion of the Vibrato LFO will
+				influence pitch. A positive value indicates a positive LFO excursion increases pitch;
+				a negative value indicates a positive excursion decreases pitch. Pitch is always
+				modified logarithmically, that is the deviation is in cents, semitones, and octaves
+				rather than in Hz. For example, a value of 100 indicates that the pitch will first rise 1
+				semitone, then fall one semitone. */
+				vibLfoToPitch = 6,
+
+				/*This is the degree, in cents, to which a full scale excursion of the Modulation
+				Envelope will influence pitch. A positive value indicates an increase in pitch; a
+				negative value indicates a decrease in pitch. Pitch is always modified
+				logarithmically, that is the deviation is in cents, semitones, and octaves rather than in
+				Hz. For example, a value of 100 indicates that the pitch will rise 1 semitone at the
+				envelope peak. */
+				modEnvToPitch = 7,
+
+				/*This is the cutoff and resonant frequency of the lowpass filter in absolute cent units.
+				The lowpass filter is defined as a second order resonant pole pair whose pole
+				frequency in Hz is defined by the Initial Filter Cutoff parameter. When the cutoff
+				frequency exceeds 20kHz and the Q (resonance) of the filter is zero, the filter does
+				not affect the signal. */
+				initialFilterFc = 8,
+
+				/*This is the height above DC gain in centibels which the filter resonance exhibits at
+				the cutoff frequency. A value of zero or less indicates the filter is not resonant; the
+				gain at the cutoff frequency (pole angle) may be less than zero when zero is
+				specified. The filter gain at DC is also affected by this parameter such that the gain
+				at DC is reduced by half the specified gain. For example, for a value of 100, the
+				filter gain at DC would be 5 dB below unity gain, and the height of the resonant peak
+				would be 10 dB above the DC gain, or 5 dB above unity gain. Note also that if
+				initialFilterQ is set to zero or less and the cutoff frequency exceeds 20 kHz, then the
+				filter response is flat and unity gain. */
+				initialFilterQ = 9,
+
+				/*This is the degree, in cents, to which a full scale excursion of the Modulation LFO
+				will influence filter cutoff frequency. A positive number indicates a positive LFO
+				excursion increases cutoff frequency; a negative number indicates a positive
+				excursion decreases cutoff frequency. Filter cutoff frequency is always modified
+				logarithmically, that is the deviation is in cents, semitones, and octaves rather than in
+				Hz. For example, a value of 1200 indicates that the cutoff frequency will first rise 1
+				octave, then fall one octave. */
+				modLfoToFilterFc = 10,
+
+				/*This is the degree, in cents, to which a full scale excursion of the Modulation
+				Envelope will influence filter cutoff frequency. A positive number indicates an
+				increase in cutoff frequency; a negative number indicates a decrease in filter cutoff
+				frequency. Filter cutoff frequency is always modified logarithmically, that is the
+				deviation is in cents, semitones, and octaves rather than in Hz. For example, a value
+				of 1000 indicates that the cutoff frequency will rise one octave at the envelope attack
+				peak. */
+				modEnvToFilterFc = 11,
+
+				/*The offset, in 32768 sample data point increments beyond the End sample header
+				parameter and the last sample data point to be played in this instrument. This
+				parameter is added to the endAddrsOffset parameter. For example, if End were
+				65536, startAddrsOffset were -3 and startAddrsCoarseOffset were -1, the last sample
+				data point played would be sample data point 32765. */
+				endAddrsCoarseOffset = 12,
+
+				/*This is the degree, in centibels, to which a full scale excursion of the Modulation
+				LFO will influence volume. A positive number indicates a positive LFO excursion
+				increases volume; a negative number indicates a positive excursion decreases
+				volume. Volume is always modified logarithmically, that is the deviation is in
+				decibels rather than in linear amplitude. For example, a value of 100 indicates that
+				the volume will first rise ten dB, then fall ten dB. */
+				modLfoToVolume = 13,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				unused1 = 14,
+
+				/*This is the degree, in 0.1% units, to which the audio output of the note is sent to the
+				chorus effects processor. A value of 0% or less indicates no signal is sent from this
+				note; a value of 100% or more indicates the note is sent at full level. Note that this
+				parameter has no effect on the amount of this signal sent to the dry or unprocessed
+				portion of the output. For example, a value of 250 indicates that the signal is sent at
+				25% of full level (attenuation of 12 dB from full level) to the chorus effects
+				processor. */
+				chorusEffectsSend = 15,
+
+				/*This is the degree, in 0.1% units, to which the audio output of the note is sent to the
+				reverb effects processor. A value of 0% or less indicates no signal is sent from this
+				note; a value of 100% or more indicates the note is sent at full level. Note that this
+				parameter has no effect on the amount of this signal sent to the dry or unprocessed
+				portion of the output. For example, a value of 250 indicates that the signal is sent at
+				25% of full level (attenuation of 12 dB from full level) to the reverb effects
+				processor. */
+				reverbEffectsSend = 16,
+
+				/*This is the degree, in 0.1% units, to which the dry audio output of the note is
+				positioned to the left or right output. A value of -50% or less indicates the signal is
+				sent entirely to the left output and not sent to the right output; a value of +50% or
+				more indicates the note is sent entirely to the right and not sent to the left. A value of
+				zero places the signal centered between left and right. For example, a value of -250
+				indicates that the signal is sent at 75% of full level to the left output and 25% of full
+				level to the right output. */
+				pan = 17,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				unused2 = 18,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				unused3 = 19,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				unused4 = 20,
+
+				/*This is the delay time, in absolute timecents, from key on until the Modulation LFO
+				begins its upward ramp from zero value. A value of 0 indicates a 1 second delay. A
+				negative value indicates a delay less than one second and a positive value a delay
+				longer than one second. The most negative number (-32768) conventionally
+				indicates no delay. For example, a delay of 10 msec would be 1200log2(.01) = -
+				7973. */
+				delayModLFO = 21,
+
+				/*This is the frequency, in absolute cents, of the Modulation LFOs triangular period.
+				A value of zero indicates a frequency of 8.176 Hz. A negative value indicates a
+				frequency less than 8.176 Hz; a positive value a frequency greater than 8.176 Hz.
+				For example, a frequency of 10 mHz would be 1200log2(.01/8.176) = -11610. */
+				freqModLFO = 22,
+
+				/*This is the delay time, in absolute timecents, from key on until the Vibrato LFO
+				begins its upward ramp from zero value. A value of 0 indicates a 1 second delay. A
+				negative value indicates a delay less than one second; a positive value a delay longer
+				than one second. The most negative number (-32768) conventionally indicates no
+				delay. For example, a delay of 10 msec would be 1200log2(.01) = -7973. */
+				delayVibLFO = 23,
+
+				/*This is the frequency, in absolute cents, of the Vibrato LFOs triangular period. A
+				value of zero indicates a frequency of 8.176 Hz. A negative value indicates a
+				frequency less than 8.176 Hz; a positive value a frequency greater than 8.176 Hz.
+				For example, a frequency of 10 mHz would be 1200log2(.01/8.176) = -11610. */
+				freqVibLFO = 24,
+
+				/*This is the delay time, in absolute timecents, between key on and the start of the
+				attack phase of the Modulation envelope. A value of 0 indicates a 1 second delay. A
+				negative value indicates a delay less than one second; a positive value a delay longer
+				than one second. The most negative number (-32768) conventionally indicates no
+				delay. For example, a delay of 10 msec would be 1200log2(.01) = -7973. */
+				delayModEnv = 25,
+
+				/*This is the time, in absolute timecents, from the end of the Modulation Envelope
+				Delay Time until the point at which the Modulation Envelope value reaches its peak.
+				Note that the attack is convex; the curve is nominally such that when applied to a
+				decibel or semitone parameter, the result is linear in amplitude or Hz respectively. A
+				value of 0 indicates a 1 second attack time. A negative value indicates a time less
+				than one second; a positive value a time longer than one second. The most negative
+				number (-32768) conventionally indicates instantaneous attack. For example, an
+				attack time of 10 msec would be 1200log2(.01) = -7973. */
+				attackModEnv = 26,
+
+				/*This is the time, in absolute timecents, from the end of the attack phase to the entry
+				into decay phase, during which the envelope value is held at its peak. A value of 0
+				indicates a 1 second hold time. A negative value indicates a time less than one
+				second; a positive value a time longer than one second. The most negative number (-
+				32768) conventionally indicates no hold phase. For example, a hold time of 10 msec
+				would be 1200log2(.01) = -7973. */
+				holdModEnv = 27,
+
+				/*This is the time, in absolute timecents, for a 100% change in the Modulation
+				Envelope value during decay phase. For the Modulation Envelope, the decay phase
+				linearly ramps toward the sustain level. If the sustain level were zero, the
+				Modulation Envelope Decay Time would be the time spent in decay phase. A value
+				of 0 indicates a 1 second decay time for a zero-sustain level. A negative value
+				indicates a time less than one second; a positive value a time longer than one second.
+				For example, a decay time of 10 msec would be 1200log2(.01) = -7973. */
+				decayModEnv = 28,
+
+				/*This is the decrease in level, expressed in 0.1% units, to which the Modulation
+				Envelope value ramps during the decay phase. For the Modulation Envelope, the
+				sustain level is properly expressed in percent of full scale. Because the volume
+				envelope sustain level is expressed as an attenuation from full scale, the sustain level
+				is analogously expressed as a decrease from full scale. A value of 0 indicates the
+				sustain level is full level; this implies a zero duration of decay phase regardless of
+				decay time. A positive value indicates a decay to the corresponding level. Values
+				less than zero are to be interpreted as zero; values above 1000 are to be interpreted as
+				1000. For example, a sustain level which corresponds to an absolute value 40% of
+				peak would be 600. */
+				sustainModEnv = 29,
+
+				/*This is the time, in absolute timecents, for a 100% change in the Modulation
+				Envelope value during release phase. For the Modulation Envelope, the release
+				phase linearly ramps toward zero from the current level. If the current level were
+				full scale, the Modulation Envelope Release Time would be the time spent in release
+				phase until zero value were reached. A value of 0 indicates a 1 second decay time 
+				for a release from full level. A negative value indicates a time less than one second;
+				a positive value a time longer than one second. For example, a release time of 10
+				msec would be 1200log2(.01) = -7973. */
+				releaseModEnv = 30,
+
+				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
+				Modulation Envelope is decreased by increasing MIDI key number. The hold time
+				at key number 60 is always unchanged. The unit scaling is such that a value of 100
+				provides a hold time which tracks the keyboard; that is, an upward octave causes the
+				hold time to halve. For example, if the Modulation Envelope Hold Time were -7973
+				= 10 msec and the Key Number to Mod Env Hold were 50 when key number 36 was
+				played, the hold time would be 20 msec. */
+				keynumToModEnvHold = 31,
+
+				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
+				Modulation Envelope is decreased by increasing MIDI key number. The hold time
+				at key number 60 is always unchanged. The unit scaling is such that a value of 100
+				provides a hold time that tracks the keyboard; that is, an upward octave causes the
+				hold time to halve. For example, if the Modulation Envelope Hold Time were -7973
+				= 10 msec and the Key Number to Mod Env Hold were 50 when key number 36 was
+				played, the hold time would be 20 msec. */
+				keynumToModEnvDecay = 32,
+
+				/*This is the delay time, in absolute timecents, between key on and the start of the
+				attack phase of the Volume envelope. A value of 0 indicates a 1 second delay. A
+				negative value indicates a delay less than one second; a positive value a delay longer
+				than one second. The most negative number (-32768) conventionally indicates no
+				delay. For example, a delay of 10 msec would be 1200log2(.01) = -7973. */
+				delayVolEnv = 33,
+
+				/*This is the time, in absolute timecents, from the end of the Volume Envelope Delay
+				Time until the point at which the Volume Envelope value reaches its peak. Note that
+				the attack is convex; the curve is nominally such that when applied to the decibel
+				volume parameter, the result is linear in amplitude. A value of 0 indicates a 1 second
+				attack time. A negative value indicates a time less than one second; a positive value
+				a time longer than one second. The most negative number (-32768) conventionally
+				indicates instantaneous attack. For example, an attack time of 10 msec would be
+				1200log2(.01) = -7973. */
+				attackVolEnv = 34,
+
+				/*This is the time, in absolute timecents, from the end of the attack phase to the entry
+				into decay phase, during which the Volume envelope value is held at its peak. A
+				value of 0 indicates a 1 second hold time. A negative value indicates a time less than
+				one second; a positive value a time longer than one second. The most negative
+				number (-32768) conventionally indicates no hold phase. For example, a hold time
+				of 10 msec would be 1200log2(.01) = -7973. */
+				holdVolEnv = 35,
+
+				/*This is the time, in absolute timecents, for a 100% change in the Volume Envelope
+				value during decay phase. For the Volume Envelope, the decay phase linearly ramps
+				toward the sustain level, causing a constant dB change for each time unit. If the
+				sustain level were -100dB, the Volume Envelope Decay Time would be the time
+				spent in decay phase. A value of 0 indicates a 1-second decay time for a zero-sustain
+				level. A negative value indicates a time less than one second; a positive value a time
+				longer than one second. For example, a decay time of 10 msec would be
+				1200log2(.01) = -7973. */
+				decayVolEnv = 36,
+
+				/*This is the decrease in level, expressed in centibels, to which the Volume Envelope
+				value ramps during the decay phase. For the Volume Envelope, the sustain level is
+				best expressed in centibels of attenuation from full scale. A value of 0 indicates the
+				sustain level is full level; this implies a zero duration of decay phase regardless of
+				decay time. A positive value indicates a decay to the corresponding level. Values
+				less than zero are to be interpreted as zero; conventionally 1000 indicates full 
+				attenuation. For example, a sustain level which corresponds to an absolute value
+				12dB below of peak would be 120. */
+				sustainVolEnv = 37,
+
+				/*This is the time, in absolute timecents, for a 100% change in the Volume Envelope
+				value during release phase. For the Volume Envelope, the release phase linearly
+				ramps toward zero from the current level, causing a constant dB change for each
+				time unit. If the current level were full scale, the Volume Envelope Release Time
+				would be the time spent in release phase until 100dB attenuation were reached. A
+				value of 0 indicates a 1-second decay time for a release from full level. A negative
+				value indicates a time less than one second; a positive value a time longer than one
+				second. For example, a release time of 10 msec would be 1200log2(.01) = -7973. */
+				releaseVolEnv = 38,
+
+				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
+				Volume Envelope is decreased by increasing MIDI key number. The hold time at
+				key number 60 is always unchanged. The unit scaling is such that a value of 100
+				provides a hold time which tracks the keyboard; that is, an upward octave causes the
+				hold time to halve. For example, if the Volume Envelope Hold Time were -7973 =
+				10 msec and the Key Number to Vol Env Hold were 50 when key number 36 was
+				played, the hold time would be 20 msec. */
+				keynumToVolEnvHold = 39,
+
+				/*This is the degree, in timecents per KeyNumber units, to which the hold time of the
+				Volume Envelope is decreased by increasing MIDI key number. The hold time at
+				key number 60 is always unchanged. The unit scaling is such that a value of 100
+				provides a hold time that tracks the keyboard; that is, an upward octave causes the
+				hold time to halve. For example, if the Volume Envelope Hold Time were -7973 =
+				10 msec and the Key Number to Vol Env Hold were 50 when key number 36 was
+				played, the hold time would be 20 msec. */
+				keynumToVolEnvDecay = 40,
+
+				/*This is the index into the INST sub-chunk providing the instrument to be used for the
+				current preset zone. A value of zero indicates the first instrument in the list. The
+				value should never exceed two less than the size of the instrument list. The
+				instrument enumerator is the terminal generator for PGEN zones. As such, it should
+				only appear in the PGEN sub-chunk, and it must appear as the last generator
+				enumerator in all but the global preset zone. */
+				instrument = 41,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				reserved1 = 42,
+
+				/*This is the minimum and maximum MIDI key number values for which this preset
+				zone or instrument zone is active. The LS byte indicates the highest and the MS byte
+				the lowest valid key. The keyRange enumerator is optional, but when it does appear,
+				it must be the first generator in the zone generator list. */
+				keyRange = 43,
+
+				/*This is the minimum and maximum MIDI velocity values for which this preset zone
+				or instrument zone is active. The LS byte indicates the highest and the MS byte the
+				lowest valid velocity. The velRange enumerator is optional, but when it does appear,
+				it must be preceded only by keyRange in the zone generator list. */
+				velRange = 44,
+
+				/*The offset, in 32768 sample data point increments beyond the Startloop sample
+				header parameter and the first sample data point to be repeated in this instruments
+				loop. This parameter is added to the startloopAddrsOffset parameter. For example,
+				if Startloop were 5, startloopAddrsOffset were 3 and startAddrsCoarseOffset were 2,
+				the first sample data point in the loop would be sample data point 65544. */
+				startloopAddrsCoarseOffset = 45,
+
+				/*This enumerator forces the MIDI key number to effectively be interpreted as the
+				value given. This generator can only appear at the instrument level. Valid values are
+				from 0 to 127. */
+				keynum = 46,
+
+				/*This enumerator forces the MIDI velocity to effectively be interpreted as the value
+				given. This generator can only appear at the instrument level. Valid values are from
+				0 to 127. */
+				velocity = 47,
+
+				/*This is the attenuation, in centibels, by which a note is attenuated below full scale. A
+				value of zero indicates no attenuation; the note will be played at full scale. For
+				example, a value of 60 indicates the note will be played at 6 dB below full scale for
+				the note. */
+				initialAttenuation = 48,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				reserved2 = 49,
+
+				/*The offset, in 32768 sample data point increments beyond the Endloop sample
+				header parameter to the sample data point considered equivalent to the Startloop
+				sample data point for the loop for this instrument. This parameter is added to the
+				endloopAddrsOffset parameter. For example, if Endloop were 5,
+				endloopAddrsOffset were 3 and endAddrsCoarseOffset were 2, sample data point
+				65544 would be considered equivalent to the Startloop sample data point, and hence
+				sample data point 65543 would effectively precede Startloop during looping. */
+				endloopAddrsCoarseOffset = 50,
+
+				/*This is a pitch offset, in semitones, which should be applied to the note. A positive
+				value indicates the sound is reproduced at a higher pitch; a negative value indicates a
+				lower pitch. For example, a Coarse Tune value of -4 would cause the sound to be
+				reproduced four semitones flat. */
+				coarseTune = 51,
+
+				/*This is a pitch offset, in cents, which should be applied to the note. It is additive
+				with coarseTune. A positive value indicates the sound is reproduced at a higher
+				pitch; a negative value indicates a lower pitch. For example, a Fine Tuning value of -
+				5 would cause the sound to be reproduced five cents flat. */
+				fineTune = 52,
+
+				/*This is the index into the SHDR sub-chunk providing the sample to be used for the
+				current instrument zone. A value of zero indicates the first sample in the list. The
+				value should never exceed two less than the size of the sample list. The sampleID
+				enumerator is the terminal generator for IGEN zones. As such, it should only appear
+				in the IGEN sub-chunk, and it must appear as the last generator enumerator in all but
+				the global zone. */
+				sampleID = 53,
+
+				/*This enumerator indicates a value which gives a variety of Boolean flags describing
+				the sample for the current instrument zone. The sampleModes should only appear in
+				the IGEN sub-chunk, and should not appear in the global zone. The two LS bits of
+				the value indicate the type of loop in the sample: 0 indicates a sound reproduced with
+				no loop, 1 indicates a sound which loops continuously, 2 is unused but should be
+				interpreted as indicating no loop, and 3 indicates a sound which loops for the
+				duration of key depression then proceeds to play the remainder of the sample. */
+				sampleModes = 54,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				reserved3 = 55,
+
+				/*This parameter represents the degree to which MIDI key number influences pitch. A
+				value of zero indicates that MIDI key number has no effect on pitch; a value of 100
+				represents the usual tempered semitone scale. */
+				scaleTuning = 56,
+
+				/*This parameter provides the capability for a key depression in a given instrument to
+				terminate the playback of other instruments. This is particularly useful for
+				percussive instruments such as a hi-hat cymbal. An exclusive class value of zero
+				indicates no exclusive class; no special action is taken. Any other value indicates
+				that when this note is initiated, any other sounding note with the same exclusive class
+				value should be rapidly terminated. The exclusive class generator can only appear at
+				the instrument level. The scope of the exclusive class is the entire preset. In other 
+				words, any other instrument zone within the same preset holding a corresponding
+				exclusive class will be terminated. */
+				exclusiveClass = 57,
+
+				/*This parameter represents the MIDI key number at which the sample is to be played
+				back at its original sample rate. If not present, or if present with a value of -1, then
+				the sample header parameter Original Key is used in its place. If it is present in the
+				range 0-127, then the indicated key number will cause the sample to be played back
+				at its sample header Sample Rate. For example, if the sample were a recording of a
+				piano middle C (Original Key = 60) at a sample rate of 22.050 kHz, and Root Key
+				were set to 69, then playing MIDI key number 69 (A above middle C) would cause a
+				piano note of pitch middle C to be heard.*/
+				overridingRootKey = 58,
+
+				/*Unused, reserved. Should be ignored if encountered. */
+				unused5 = 59,
+
+				/*Unused, reserved. Should be ignored if encountered. Unique name provides value
+				to end of defined list. */
+				endOper = 60
+			};
+			GenType enumeration;
+
+			friend inline bool operator==(const SFGenerator& lhs, const SFGenerator& rhs)
+			{
+				return lhs.enumeration == rhs.enumeration;
+			}
+			friend inline bool operator!=(const SFGenerator& lhs, const SFGenerator& rhs)
+			{
+				return !(lhs == rhs);
+			}
+			friend inline bool operator==(const SFGenerator& lhs, const GenType& rhs)
+			{
+				return lhs.enumeration == rhs;
+			}
+			friend inline bool operator!=(const SFGenerator& lhs, const GenType& rhs)
+			{
+				return !(lhs == rhs);
+			}
+		};
+		struct SFTransform
+		{
+			WORD enumeration;
+		};
+
+		struct sfVersionTag
+		{
+			WORD wMajor;
+			WORD wMinor;
+		};
+
+		//nullptr if loaded from cache
+		RIFF::stream* stream = nullptr;
+		//Serializes access to the stream after construction,
+		//unless the stream supports positional reads
+		std::mutex stream_mutex;
+
+		//Reads "size" bytes at "pos" of the stream, thread-safe
+		size_t read_stream(size_t pos, void* dest, size_t size)
+		{
+			if(stream->has_read_at()) return stream->read_at(pos, dest, size);
+			//everything a forward-only stream has was loaded while parsing
+			if(!stream->is_seekable()) return 0;
+			std::lock_guard<std::mutex> stream_lock(stream_mutex);
+			stream->setpos(pos);
+			return stream->read(dest, size);
+		}
+		//Identity of the file, usually obtained with file_identity(),
+		//when set decoded sample data is shared through SampleCache
+		//with other instances of the same identity
+		std::string identity;
+
+		sfVersionTag ifil = {};
+		sfVersionTag iver = {};
+		std::string szSoundEngine;
+		std::string szROM;
+		std::string szName;
+		std::string szDate;
+		std::string szProduct;
+		std::string szCreator;
+		std::string szCopyright;
+		std::string szComment;
+		std::string szTools;
+
+		struct HYDRA
+		{
+			struct sfPresetHeader
+			{
+				CHAR achPresetName[20];
+				WORD wPreset;//MIDI Preset Number
+				WORD wBank;//MIDI Bank Number
+				WORD wPresetBagNdx;//index to the presets zone list
+				DWORD dwLibrary;//reserved
+				DWORD dwGenre;//reserved
+				DWORD dwMorphology;//reserved
+			};
+			//Preset header list
+			std::vector<sfPresetHeader> phdr;
+
+			struct sfPresetBag
+			{
+				WORD wGenNdx;//index to the presets zone list of generators in PGEN
+				WORD wModNdx;//index to the list of modulators in PMOD
+			};
+			//Pointers to first entries of preset zone generator and modulator lists
+			std::vector<sfPresetBag> pbag;
+
+			struct sfModList
+			{
+				//indicates the source of data for the modulator
+				SFModulator sfModSrcOper;
+				//destination of the modulator
+				SFGenerator sfModDestOper;
+				//degree to which the source modulates the destination
+				//a zero value indicates there is no fixed amount. 
+				SHORT modAmount;
+				//indicates the degree to which the source modulates the destination
+				//is to be controlled by the specified modulation source
+				SFModulator sfModAmtSrcOper;
+				//indicates that a transform of the specified type will be applied
+				//to the modulation source before application to the modulator
+				SFTransform sfModTransOper;
+			};
+			//Preset zone modulators
+			std::vector<sfModList> pmod;
+
+			struct sfGenList
+			{
+				SFGenerator sfGenOper;
+				//value to be assigned to the specified generator
+				//note that this can be of three formats. 
+				genAmountType genAmount;
+			};
+			//Preset zone generators
+			std::vector<sfGenList> pgen;
+
+			struct sfInst
+			{
+				CHAR achInstName[20];
+				//index to the instruments zone list in the IBAG sub-chunk
+				WORD wInstBagNdx;
+			};
+			//Instrument list
+			std::vector<sfInst> inst;
+
+			struct sfInstBag
+			{
+				//index to the instrument zones list of generators in the IGEN sub-chunk
+				WORD wInstGenNdx;
+				//index to the list of modulators in the IMOD sub-chunk
+				WORD wInstModNdx;
+			};
+			//Pointers to first entries of instrument zone generator and modulator lists
+			std::vector<sfInstBag> ibag;
+
+			struct sfInstModList
+			{
+				//indicates the source of data for the modulator
+				SFModulator sfModSrcOper;
+				//indicates the destination of the modulator
+				SFGenerator sfModDestOper;
+				//indicates the degree to which the source modulates the destination
+				//a zero value indicates there is no fixed amount. 
+				SHORT modAmount;
+				//indicates the degree to which the source modulates the destination
+				//is to be controlled by the specified modulation source
+				SFModulator sfModAmtSrcOper;
+				//indicates that a transform of the specified type will be applied
+				//to the modulation source before application to the modulator
+				SFTransform sfModTransOper;
+			};
+			//Instrument zone modulators
+			std::vector<sfInstModList> imod;
+
+			struct sfInstGenList
+			{
+				SFGenerator sfGenOper;
+				//value to be assigned to the specified generator
+				//note that this can be of three formats.
+				genAmountType genAmount;
+			};
+			//Instrument zone generators
+			std::vector<sfInstGenList> igen;
+
+			struct sfSample
+			{
+				CHAR achSampleName[20];
+				//index, in sample data points, from the beginning of the sample data
+				//field to the first data point of this sample. 
+				DWORD dwStart;
+				//index, in sample data points, from the beginning of the sample data
+				//field to the first of the set of 46 zero valued data points following
+				//this sample. 
+				DWORD dwEnd;
+				//index, in sample data points, from the beginning of the sample data
+				//field to the first data point in the loop of this sample. 
+				DWORD dwStartloop;
+				//index, in sample data points, from the beginning of the sample data
+				//field to the first data point following the loop of this sample.
+				//Note that this is the data point equivalent to the first loop data point,
+				//and that to produce portable artifact free loops, the eight proximal data
+				//points surrounding both the Startloop and Endloop points should be identical. 
+				DWORD dwEndloop;
+				//the sample rate, in hertz, at which this sample was acquired or to which
+				//it was most recently converted.
+				DWORD dwSampleRate;
+				//contains the MIDI key number of the recorded pitch of the sample
+				BYTE byOriginalKey;
+				//contains a pitch correction in cents that should be applied to
+				//the sample on playback.
+				//The purpose of this field is to compensate for any pitch errors during
+				//the sample recording process. The correction value is that of the correction
+				//to be applied. For example, if the sound is 4 cents sharp, a correction
+				//bringing it 4 cents flat is required; thus the value should be -4.
+				CHAR chCorrection;
+				//sample header link, accordingly indicated by sfSampleType
+				WORD wSampleLink;
+				//sample type
+				SFSampleLink sfSampleType;
+			};
+			//Samples
+			std::vector<sfSample> shdr;
+		};
+		HYDRA hydra;
+
+		size_t sample_data_offset = 0;
+		size_t sample_data_24_offset = 0;
+		//sizes of smpl and sm24 chunk data in bytes
+		size_t sample_data_size = 0;
+		size_t sample_data_24_size = 0;
+		//smpl and sm24 chunk data if it was loaded during parsing
+		const BYTE* sample_data = nullptr;
+		const BYTE* sample_data_24 = nullptr;
+
+		//Decodes a compressed SF3 sample, "data" holds "size" bytes of an Ogg Vorbis stream,
+		//writes up to "count" mono 16 bit frames to "frames", the rest stays silent,
+		//called in parallel by loading threads, returns false on failure.
+		//There's no built-in decoder, SF3 samples are silent until one is provided
+		std::function<bool(const uint8_t* data, size_t size, int16_t* frames, uint32_t count)> sample_decoder;
+
+		//Bytes of smpl chunk data at "offset", viewed in place if possible,
+		//otherwise read into "buffer", bytes beyond the chunk read as zeros
+		const BYTE* sample_bytes(size_t offset, size_t size, std::unique_ptr<BYTE[]>& buffer)
+		{
+			if(offset <= sample_data_size && size <= sample_data_size - offset)
+			{
+				if(sample_data) return sample_data + offset;
+				if(auto view = stream->view(sample_data_offset + offset, size))
+					return static_cast<const BYTE*>(view);
+			}
+			buffer = std::make_unique<BYTE[]>(size);
+			if(offset < sample_data_size)
+				read_stream(sample_data_offset + offset, buffer.get(), std::min(size, sample_data_size - offset));
+			return buffer.get();
+		}
+
+		//Number of frames of the compressed SF3 sample at "offset" of smpl, 0 if unknown
+		uint32_t encoded_frames(size_t offset, size_t size)
+		{
+			//a page is at most 65307 bytes long, but the last one is usually much shorter
+			for(size_t tail : {size_t(4096), size_t(65307)})
+			{
+				tail = std::min(tail, size);
+				std::unique_ptr<BYTE[]> buffer;
+				auto data = sample_bytes(offset + size - tail, tail, buffer);
+				if(uint64_t frames = ogg_stream_frames(data, tail))
+					return (uint32_t)std::min<uint64_t>(frames, UINT32_MAX);
+				if(tail == size) break;
+			}
+			return 0;
+		}
+
+		//In-memory format of samples loaded from now on,
+		//compact formats halve memory and bandwidth used by voices
+		//at the cost of converting frames while rendering,
+		//Int24 falls back to Int16 if the file has no sm24 chunk,
+		//Compressed is lossless and renders the same as Int16 or Int24
+		SampleFormat sample_format = SampleFormat::Float;
+		//16 bit samples are played straight from smpl chunk data in memory,
+		//usually a RIFF::mapped_file, instead of being loaded into own buffers,
+		//they render the same as Int16 and don't count towards sample memory,
+		//banks with a sm24 chunk are mapped only if sample_format is Int16
+		bool map_samples = false;
+
+		struct Sample
+		{
+			std::string name;
+
+			uint32_t loop_start;
+			uint32_t loop_end;
+
+			uint32_t sample_rate;
+			uint8_t original_key;
+			int8_t correction;
+
+			//in frames from the start of smpl, in bytes for compressed SF3 samples
+			uint32_t data_stream_offset;
+			//size of the Ogg Vorbis stream of a compressed SF3 sample in bytes, 0 for PCM samples
+			uint32_t encoded_size = 0;
+			//frames encoded in "format", might be shared with other instances
+			std::shared_ptr<const uint8_t[]> data;
+			SampleFormat format = SampleFormat::Float;
+			uint32_t size;
+
+			SFSampleLink sample_type;
+			Sample* linked_sample;
+
+			//Set once data is fully loaded, safe to check from any thread
+			std::atomic<bool> loaded = false;
+			//Held while data is being loaded
+			std::mutex load_mutex;
+
+			bool IsLoaded() const
+			{
+				return loaded.load(std::memory_order_acquire);
+			}
+
+			//Number of voices and channel presets using the sample,
+			//the sample can only be evicted while it's zero
+			std::atomic<uint32_t> pins = 0;
+			//Set in "pins" while the sample is being evicted
+			static constexpr uint32_t evicting = 0x80000000u;
+			//Time of last use, for eviction in LRU order
+			std::atomic<uint64_t> last_used = 0;
+
+			//Lock-free unless the sample is being evicted at the moment,
+			//in which case it waits for the eviction to finish,
+			//pinning doesn't load data
+			void Pin(SoundFont2& sf2)
+			{
+				last_used.store(sf2.sample_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+				if(pins.fetch_add(1, std::memory_order_acq_rel) & evicting)
+					std::lock_guard<std::mutex> wait_lock(load_mutex);
+			}
+
+			void Unpin(SoundFont2& sf2)
+			{
+				last_used.store(sf2.sample_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+				pins.fetch_sub(1, std::memory_order_release);
+			}
+
+			//Memory used by sample data in bytes
+			size_t MemoryUsage() const
+			{
+				if(mapped) return 0;
+				if(format == SampleFormat::Compressed)
+					return compressed_size(data.get()) + compressed_size(loop_data.get());
+				return (size_t(resident_size) + loop_data_size) * sample_format_size(format);
+			}
+
+			//Frees data unless the sample is pinned or busy loading,
+			//returns the number of bytes freed
+			size_t evict()
+			{
+				std::unique_lock<std::mutex> load_lock(load_mutex, std::try_to_lock);
+				if(!load_lock.owns_lock() || !IsLoaded()) return 0;
+				uint32_t expected = 0;
+				if(!pins.compare_exchange_strong(expected, evicting, std::memory_order_acq_rel)) return 0;
+				size_t freed = MemoryUsage();
+				loaded.store(false, std::memory_order_release);
+				data = nullptr;
+				loop_data = nullptr;
+				loop_data_size = 0;
+				pins.fetch_sub(evicting, std::memory_order_release);
+				return freed;
+			}
+
+			//Number of frames in data counting from the start of the sample,
+			//less than size if the rest is streamed from disk
+			uint32_t resident_size = 0;
+			//Loop region of a streamed sample kept in memory,
+			//covers frames [loop_data_start, loop_data_start+loop_data_size)
+			std::shared_ptr<const uint8_t[]> loop_data;
+			uint32_t loop_data_start = 0;
+			uint32_t loop_data_size = 0;
+			//data points into smpl chunk data owned by the stream or the parser
+			bool mapped = false;
+
+			//Asks the OS to read pages of mapped data ahead of playback
+			void prefetch() const
+			{
+			#ifdef RIFF_MMAP_SUPPORTED
+				if(!mapped) return;
+				static const uintptr_t page_size = uintptr_t(sysconf(_SC_PAGESIZE));
+				uintptr_t begin = uintptr_t(data.get()) & ~(page_size - 1);
+				uintptr_t end = uintptr_t(data.get()) + size_t(size)*sizeof(int16_t);
+				madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+			#endif
+			}
+
+			//Sample data read ahead of loading, covers frames [0, frames)
+			struct RawFrames
+			{
+				const int16_t* data16 = nullptr;
+				//nullptr if the file has no sm24 chunk
+				const uint8_t* data24 = nullptr;
+				uint32_t frames = 0;
+			};
+
+			//Frames from the start of the sample that loading reads
+			uint32_t load_extent(const SoundFont2& sf2) const
+			{
+				if(encoded_size || !sf2.streaming.enabled || size <= sf2.streaming.head_frames) return size;
+				uint32_t extent = sf2.streaming.head_frames;
+				if(loop_start < loop_end && loop_end < size && loop_end >= extent) extent = loop_end + 1;
+				return extent;
+			}
+
+			//Reads "count" frames starting at "first" and stores them in "dest_format",
+			//frames are taken from "raw" if it covers them
+			void read_frames(SoundFont2& sf2, uint32_t first, uint32_t count, SampleFormat dest_format, uint8_t* dest, const RawFrames* raw = nullptr)
+			{
+				if(encoded_size)
+				{
+					//compressed samples are decoded as a whole
+					auto decoded = std::make_unique<int16_t[]>(size);
+					std::unique_ptr<BYTE[]> buffer;
+					auto encoded = sf2.sample_bytes(data_stream_offset, encoded_size, buffer);
+					if(!sf2.sample_decoder || !sf2.sample_decoder(encoded, encoded_size, decoded.get(), size))
+						std::fill(decoded.get(), decoded.get() + size, int16_t(0));
+					store_samples(dest, dest_format, decoded.get() + first, nullptr, count);
+					return;
+				}
+				if(raw && first <= raw->frames && count <= raw->frames - first)
+				{
+					store_samples(dest, dest_format, raw->data16 + first, raw->data24?raw->data24 + first:nullptr, count);
+					return;
+				}
+				size_t offset = size_t(data_stream_offset) + first;
+				//sample data is used in place if it's already loaded or the stream
+				//resides in memory, otherwise it's read into temporary buffers
+				std::unique_ptr<int16_t[]> buffer16;
+				auto data16 = static_cast<const int16_t*>(sf2.sample_data?
+					sf2.sample_data+offset*sizeof(int16_t):
+					sf2.stream->view(
+						sf2.sample_data_offset+offset*sizeof(int16_t),
+						count*sizeof(int16_t)
+					));
+				if(!data16)
+				{
+					buffer16 = std::make_unique<int16_t[]>(count);
+					//read 16 bit samples
+					sf2.read_stream(sf2.sample_data_offset+offset*sizeof(int16_t), buffer16.get(), count*sizeof(int16_t));
+					data16 = buffer16.get();
+				}
+				std::unique_ptr<uint8_t[]> buffer24;
+				const uint8_t* data24 = nullptr;
+				if(sf2.sample_data_24_offset)
+				{
+					data24 = static_cast<const uint8_t*>(sf2.sample_data_24?
+						sf2.sample_data_24+offset:
+						sf2.stream->view(
+							sf2.sample_data_24_offset+offset,
+							count
+						));
+					if(!data24)
+					{
+						buffer24 = std::make_unique<uint8_t[]>(count);
+						//read 8 bit of 24 bit complementary additional sample data
+						sf2.read_stream(sf2.sample_data_24_offset+offset, buffer24.get(), count);
+						data24 = buffer24.get();
+					}
+				}
+				store_samples(dest, dest_format, data16, data24, count);
+			}
+
+			//Reads frames in sample's format into a new buffer,
+			//or gets them from the shared cache if the file is identified
+			std::shared_ptr<const uint8_t[]> load_frames(SoundFont2& sf2, uint32_t first, uint32_t count, const RawFrames* raw = nullptr)
+			{
+				auto load = [&]
+				{
+					if(format == SampleFormat::Compressed)
+					{
+						SampleFormat pcm_format = sf2.sample_data_24_offset?SampleFormat::Int24:SampleFormat::Int16;
+						auto pcm = std::make_unique<uint8_t[]>(size_t(count)*sample_format_size(pcm_format));
+						read_frames(sf2, first, count, pcm_format, pcm.get(), raw);
+						auto compressed = compress_samples(pcm.get(), pcm_format, count);
+						//the size is known only now, so it's moved into the arena afterwards
+						size_t bytes = compressed_size(compressed.get());
+						if(void* mem = sf2.sample_arena?sf2.sample_arena->allocate(bytes):nullptr)
+						{
+							std::memcpy(mem, compressed.get(), bytes);
+							return std::shared_ptr<const uint8_t[]>(sf2.sample_arena, static_cast<const uint8_t*>(mem));
+						}
+						return compressed;
+					}
+					auto buffer = sf2.allocate_sample_memory(size_t(count)*sample_format_size(format));
+					read_frames(sf2, first, count, format, buffer.get(), raw);
+					return std::shared_ptr<const uint8_t[]>(std::move(buffer));
+				};
+				if(sf2.identity.empty()) return load();
+				//byte offsets of compressed samples are kept apart from frame offsets
+				uint64_t offset = uint64_t(data_stream_offset) + first;
+				if(encoded_size) offset |= uint64_t(1) << 63;
+				return SampleCache::Global().Get(
+					SampleCache::Key{sf2.identity, offset, count, format},
+					load
+				);
+			}
+
+			//Thread-safe, does nothing if data is already loaded
+			//and waits if it's being loaded by another thread,
+			//evicts other samples if sample memory budget is exceeded
+			void load_data(SoundFont2& sf2)
+			{
+				if(IsLoaded()) return;
+				{
+					std::lock_guard<std::mutex> load_lock(load_mutex);
+					if(IsLoaded()) return;
+					load_data_locked(sf2);
+				}
+				sf2.TrimSampleMemory();
+			}
+
+			//"raw" is used instead of reading the stream if it's provided,
+			//it must cover load_extent() frames
+			void load_data_locked(SoundFont2& sf2, const RawFrames* raw = nullptr)
+			{
+				SF2_DEBUG_OUTPUT((std::string("Loading sample data \"") + name + "\"...\n").c_str());
+				format = sf2.sample_format;
+				if(format == SampleFormat::Int24 && !sf2.sample_data_24_offset)
+					format = SampleFormat::Int16;
+				resident_size = size;
+				loop_data_size = 0;
+				mapped = false;
+				if(sf2.map_samples && !encoded_size && (format == SampleFormat::Int16 || !sf2.sample_data_24_offset))
+				{
+					size_t offset = size_t(data_stream_offset)*sizeof(int16_t);
+					size_t bytes = size_t(size)*sizeof(int16_t);
+					const BYTE* view = nullptr;
+					if(sf2.sample_data)
+						view = (offset + bytes <= sf2.sample_data_size)?sf2.sample_data + offset:nullptr;
+					else if(sf2.stream)
+						view = static_cast<const BYTE*>(sf2.stream->view(sf2.sample_data_offset + offset, bytes));
+					if(view)
+					{
+						//no owner, the data lives as long as the stream
+						format = SampleFormat::Int16;
+						loop_data = nullptr;
+						data = std::shared_ptr<const uint8_t[]>(std::shared_ptr<const uint8_t[]>(), view);
+						mapped = true;
+						last_used.store(sf2.sample_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+						loaded.store(true, std::memory_order_release);
+						return;
+					}
+				}
+				//compressed samples can't be read from the middle, so they stay fully resident
+				if(sf2.streaming.enabled && size > sf2.streaming.head_frames && !encoded_size)
+				{
+					//keep only the beginning of the sample and its loop in memory,
+					//the rest is streamed by voices
+					resident_size = sf2.streaming.head_frames;
+					if(loop_start < loop_end && loop_end < size && loop_end >= resident_size)
+					{
+						//include the point following the loop for interpolation
+						loop_data_start = std::max(loop_start, resident_size);
+						loop_data_size = loop_end + 1 - loop_data_start;
+						loop_data = load_frames(sf2, loop_data_start, loop_data_size, raw);
+					}
+				}
+				data = load_frames(sf2, 0, resident_size, raw);
+				last_used.store(sf2.sample_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+				sf2.sample_memory_usage.fetch_add(MemoryUsage(), std::memory_order_relaxed);
+				loaded.store(true, std::memory_order_release);
+
+				//test
+				//save RAW
+				/*std::ofstream outfile ("wave.raw",std::ofstream::binary);
+				outfile.write((char*)data, sizeof(float)*size);
+				outfile.close();*/
+			}
+		};
+		std::vector<std::unique_ptr<Sample>> samples;
+
+		//Sample memory residency
+		std::atomic<size_t> sample_memory_budget = 0;
+		std::atomic<size_t> sample_memory_usage = 0;
+		std::atomic<uint64_t> sample_clock = 1;
+		//Held by the thread evicting samples
+		std::mutex trim_mutex;
+
+		//Limits memory used by sample data in bytes, 0 means no limit,
+		//least recently used samples are evicted once it's exceeded,
+		//samples used by voices or current presets of channels are never evicted,
+		//so the limit is exceeded if they alone don't fit
+		void SetSampleMemoryBudget(size_t bytes)
+		{
+			sample_memory_budget.store(bytes);
+			TrimSampleMemory();
+		}
+
+		size_t GetSampleMemoryUsage() const
+		{
+			return sample_memory_usage.load();
+		}
+
+		//Evicts unused samples in LRU order until usage fits the budget,
+		//happens after loading samples and changing presets,
+		//samples released by voices are evicted on the next call
+		void TrimSampleMemory()
+		{
+			size_t budget = sample_memory_budget.load();
+			if(budget == 0 || sample_memory_usage.load() <= budget) return;
+			//evicted samples couldn't be loaded again
+			if(!stream) return;
+			std::unique_lock<std::mutex> trim_lock(trim_mutex, std::try_to_lock);
+			//another thread is already at it
+			if(!trim_lock.owns_lock()) return;
+
+			std::vector<std::pair<uint64_t, Sample*>> candidates;
+			for(auto& sample : samples)
+			{
+				//evicting mapped samples frees nothing
+				if(sample->IsLoaded() && !sample->mapped && sample->pins.load(std::memory_order_relaxed) == 0)
+					candidates.emplace_back(sample->last_used.load(std::memory_order_relaxed), sample.get());
+			}
+			std::sort(candidates.begin(), candidates.end());
+			for(auto& candidate : candidates)
+			{
+				if(sample_memory_usage.load() <= budget) break;
+				sample_memory_usage.fetch_sub(candidate.second->evict());
+			}
+		}
+
+		//Region holding sample data, see CreateSampleArena
+		std::shared_ptr<PageArena> sample_arena;
+
+		//Places sample data loaded from now on in a single region of memory,
+		//optionally backed by huge pages, locked and prefaulted, so that voices
+		//don't run into page faults and TLB misses,
+		//"bytes" of 0 sizes it to hold all samples of the bank in sample_format,
+		//samples that don't fit are allocated as usual and evicted samples
+		//don't give their memory back to the region,
+		//must be called before samples are loaded, returns false if the region couldn't be reserved
+		bool CreateSampleArena(size_t bytes = 0, const PageArena::Options& options = PageArena::Options())
+		{
+			if(bytes == 0)
+			{
+				SampleFormat format = sample_format;
+				//compressed data is usually smaller than PCM
+				if(format == SampleFormat::Compressed || format == SampleFormat::Int24)
+					format = sample_data_24_offset?SampleFormat::Int24:SampleFormat::Int16;
+				for(auto& sample : samples)
+				{
+					//head and loop of streamed samples are two 64 byte aligned allocations
+					bytes += size_t(sample->load_extent(*this))*sample_format_size(format) + 128;
+				}
+			}
+			auto arena = std::make_shared<PageArena>(bytes, options);
+			if(!arena->data()) return false;
+			sample_arena = std::move(arena);
+			return true;
+		}
+
+		//Takes memory for sample data from the arena while there's space left in it
+		std::shared_ptr<uint8_t[]> allocate_sample_memory(size_t bytes)
+		{
+			if(sample_arena)
+			{
+				if(void* mem = sample_arena->allocate(bytes))
+					return std::shared_ptr<uint8_t[]>(sample_arena, static_cast<uint8_t*>(mem));
+			}
+			return std::shared_ptr<uint8_t[]>(new uint8_t[bytes]);
+		}
+
+		//Disk streaming of large samples
+		struct StreamingOptions
+		{
+			bool enabled = false;
+			//frames kept in memory from the start of every sample,
+			//loops are kept in memory as well
+			uint32_t head_frames = 32768;
+			//frames buffered ahead by every streaming voice, rounded up to a power of two
+			uint32_t ring_frames = 65536;
+			//frames read from the stream at once
+			uint32_t block_frames = 8192;
+			//maximum number of simultaneously streaming voices,
+			//voices beyond that play only what's resident
+			uint32_t max_streams = 64;
+		};
+		StreamingOptions streaming;
+
+		//Ring buffer of a streaming voice, filled by the disk thread
+		struct VoiceStream
+		{
+			enum class State : int
+			{
+				Free = 0,
+				Claimed = 1,
+				Active = 2,
+				Releasing = 3
+			};
+			std::atomic<State> state = State::Free;
+			Sample* sample = nullptr;
+			std::unique_ptr<float[]> ring;
+			uint32_t ring_size = 0;
+			//frames [read_frame, write_frame) are available in the ring,
+			//read_frame and seek_gen are written by the voice,
+			//write_frame and ack_gen are written by the disk thread
+			std::atomic<uint32_t> read_frame = 0;
+			std::atomic<uint32_t> write_frame = 0;
+			//voice increments seek_gen after moving read_frame out of the buffered range,
+			//disk thread discards the buffer and acknowledges by copying it to ack_gen
+			std::atomic<uint32_t> seek_gen = 0;
+			std::atomic<uint32_t> ack_gen = 0;
+
+			//Called by the voice, returns 0 when data isn't buffered yet
+			float Get(uint32_t pos)
+			{
+				uint32_t gen = seek_gen.load(std::memory_order_relaxed);
+				if(ack_gen.load(std::memory_order_acquire) != gen) return 0.0f;
+				uint32_t r = read_frame.load(std::memory_order_relaxed);
+				uint32_t w = write_frame.load(std::memory_order_acquire);
+				if(pos >= r && pos < w)
+					return ring[pos & (ring_size-1)];
+				if(pos < r)
+				{
+					//jumped back, refill from the new position
+					read_frame.store(pos, std::memory_order_relaxed);
+					seek_gen.store(gen + 1, std::memory_order_release);
+				}
+				//underrun
+				return 0.0f;
+			}
+
+			//Called by the voice as playback advances,
+			//frames before "pos" are no longer needed
+			void Consume(uint32_t pos)
+			{
+				if(ack_gen.load(std::memory_order_relaxed) != seek_gen.load(std::memory_order_relaxed)) return;
+				if(pos > read_frame.load(std::memory_order_relaxed))
+					read_frame.store(pos, std::memory_order_release);
+			}
+		};
+
+		//Background thread filling ring buffers of streaming voices
+		struct DiskStreamer
+		{
+			SoundFont2* sf;
+			std::vector<std::unique_ptr<VoiceStream>> streams;
+			std::atomic<bool> quit = false;
+			std::thread thread;
+
+			DiskStreamer(SoundFont2* sf): sf(sf)
+			{
+				uint32_t ring_size = 1;
+				while(ring_size < sf->streaming.ring_frames) ring_size <<= 1;
+				streams.resize(sf->streaming.max_streams);
+				for(auto& vs : streams)
+				{
+					vs = std::make_unique<VoiceStream>();
+					vs->ring_size = ring_size;
+					vs->ring = std::make_unique<float[]>(ring_size);
+				}
+				thread = std::thread([this]{Run();});
+			}
+
+			~DiskStreamer()
+			{
+				quit.store(true);
+				thread.join();
+			}
+
+			//Lock-free, safe to call from the audio thread,
+			//returns nullptr if all streams are in use
+			VoiceStream* Acquire(Sample* sample, uint32_t first_frame)
+			{
+				for(auto& vs : streams)
+				{
+					auto expected = VoiceStream::State::Free;
+					if(vs->state.compare_exchange_strong(expected, VoiceStream::State::Claimed, std::memory_order_acquire))
+					{
+						vs->sample = sample;
+						vs->read_frame.store(first_frame, std::memory_order_relaxed);
+						vs->write_frame.store(first_frame, std::memory_order_relaxed);
+						vs->seek_gen.store(0, std::memory_order_relaxed);
+						vs->ack_gen.store(0, std::memory_order_relaxed);
+						vs->state.store(VoiceStream::State::Active, std::memory_order_release);
+						return vs.get();
+					}
+				}
+				return nullptr;
+			}
+
+			//The stream is returned to the pool by the disk thread,
+			//once it's guaranteed not to be written to anymore
+			void Release(VoiceStream* vs)
+			{
+				vs->state.store(VoiceStream::State::Releasing, std::memory_order_release);
+			}
+
+			//Returns true if any data was read
+			bool Fill(VoiceStream& vs)
+			{
+				uint32_t gen = vs.seek_gen.load(std::memory_order_acquire);
+				if(vs.ack_gen.load(std::memory_order_relaxed) != gen)
+				{
+					//drop buffered data and continue from the requested position
+					vs.write_frame.store(vs.read_frame.load(std::memory_order_acquire), std::memory_order_relaxed);
+					vs.ack_gen.store(gen, std::memory_order_release);
+				}
+				uint32_t r = vs.read_frame.load(std::memory_order_acquire);
+				uint32_t w = vs.write_frame.load(std::memory_order_relaxed);
+				//voice might have skipped past buffered data
+				if(w < r) w = r;
+				if(w >= vs.sample->size) return false;
+				uint32_t count = std::min({
+					vs.ring_size - (w - r),
+					sf->streaming.block_frames,
+					vs.sample->size - w
+				});
+				if(count == 0) return false;
+				//split at the end of the ring
+				uint32_t pos = w & (vs.ring_size-1);
+				uint32_t count_first = std::min(count, vs.ring_size - pos);
+				vs.sample->read_frames(*sf, w, count_first, SampleFormat::Float, reinterpret_cast<uint8_t*>(&vs.ring[pos]));
+				if(count_first < count)
+					vs.sample->read_frames(*sf, w + count_first, count - count_first, SampleFormat::Float, reinterpret_cast<uint8_t*>(&vs.ring[0]));
+				vs.write_frame.store(w + count, std::memory_order_release);
+				return true;
+			}
+
+			void Run()
+			{
+				while(!quit.load())
+				{
+					bool busy = false;
+					for(auto& vs : streams)
+					{
+						switch(vs->state.load(std::memory_order_acquire))
+						{
+						case VoiceStream::State::Active:
+							busy |= Fill(*vs);
+							break;
+						case VoiceStream::State::Releasing:
+							vs->sample = nullptr;
+							vs->state.store(VoiceStream::State::Free, std::memory_order_release);
+							break;
+						default:
+							break;
+						}
+					}
+					if(!busy)
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			}
+		};
+
+		//Should be called before samples are loaded,
+		//samples that are already loaded stay fully resident,
+		//fails if a voice is still streaming, as its stream would be freed,
+		//must not be called while notes are started on another thread
+		bool EnableStreaming(const StreamingOptions& options)
+		{
+			if(disk_streamer)
+			{
+				for(auto& vs : disk_streamer->streams)
+				{
+					auto state = vs->state.load(std::memory_order_acquire);
+					if(state == VoiceStream::State::Claimed || state == VoiceStream::State::Active)
+						return false;
+				}
+			}
+			disk_streamer = nullptr;
+			streaming = options;
+			streaming.enabled = true;
+			disk_streamer = std::make_unique<DiskStreamer>(this);
+			return true;
+		}
+
+		struct LFO
+		{
+			int16_t delay = -12000;
+			int16_t frequency = 0;
+
+			LFO& operator+=(const LFO& rhs)
+			{
+				delay += rhs.delay;
+				frequency += rhs.frequency;
+				return *this;
+			}
+
+			friend LFO operator+(LFO lhs, const LFO& rhs)
+			{
+				lhs += rhs;
+				return lhs;
+			}
+		};
+		struct Envelope
+		{
+			int16_t attack = 0;
+			int16_t decay = 0;
+			int16_t sustain = 0;
+			int16_t release = 0;
+			int16_t hold = 0;
+			int16_t delay = 0;
+
+			int16_t keynumToHold = 0;
+			int16_t keynumToDecay = 0;
+
+			void SetToDefault()
+			{
+				attack = -12000;
+				decay = -12000;
+				release = -12000;
+				hold = -12000;
+				delay = -12000;
+			}
+
+			Envelope& operator+=(const Envelope& rhs)
+			{
+				attack += rhs.attack;
+				decay += rhs.decay;
+				sustain += rhs.sustain;
+				release += rhs.release;
+				hold += rhs.hold;
+				delay += rhs.delay;
+				keynumToHold += rhs.keynumToHold;
+				keynumToDecay += rhs.keynumToDecay;
+				return *this;
+			}
+
+			friend Envelope operator+(Envelope lhs, const Envelope& rhs)
+			{
+				lhs += rhs;
+				return lhs;
+			}
+		};
+		enum class LoopMode
+		{
+			None = 0,
+			Continuous = 1,
+			Sustain = 2
+		};
+
+		struct Instrument
+		{
+			std::string name;
+
+			//Also known as Split
+			//used for different key and velocity ranges
+			struct Zone
+			{
+				Sample* sample = nullptr;
+				int32_t start_offset = 0;
+				int32_t end_offset = 0;
+				int32_t loop_start_offset = 0;
+				int32_t loop_end_offset = 0;
+				int16_t filter_freq = 13500;
+				float filter_q = 0.0f;
+				int16_t chorus_send = 0;
+				int16_t reverb_send = 0;
+				float scale_tuning = 1.0f;
+				int16_t root_key = -1;
+				uint8_t key_low = 0, key_high = 127;
+				uint8_t vel_low = 0, vel_high = 127;
+				int16_t keynum = -1;
+				int16_t velocity = -1;
+				int32_t tune = 0;
+				uint16_t exclusive_class = 0;
+				float pan = 0.0f;
+				float attenuation = 0.0f;
+				LoopMode loop_mode = LoopMode::None;
+
+				LFO modLFO;
+				int16_t modLFO_to_pitch = 0;
+				int16_t modLFO_to_filter_fc = 0;
+				int16_t modLFO_to_volume = 0;
+				LFO vibLFO;
+				int16_t vibLFO_to_pitch = 0;
+
+				Envelope modEnv;
+				int16_t modEnv_to_pitch = 0;
+				int16_t modEnv_to_filter_fc = 0;
+				Envelope volEnv;
+			};
+			//Zone* global_zone = nullptr;
+			//stored contiguously in zone_arena
+			ArenaSpan<Zone> splits;
+		};
+		std::vector<std::unique_ptr<Instrument>> instruments;
+
+		struct Preset
+		{
+			std::string name;
+			//MIDI Preset Number
+			uint16_t num;
+
+			//Also known as Layer
+			//used to specify list of layered instruments of a preset
+			//does not contain default generators
+			struct Zone
+			{
+				Instrument* instrument = nullptr;
+				int16_t filter_freq = 0;
+				float filter_q = 0.0f;
+				int16_t chorus_send = 0;
+				int16_t reverb_send = 0;
+				float scale_tuning = 0.0f;
+				uint8_t key_low = 0, key_high = 127;
+				uint8_t vel_low = 0, vel_high = 127;
+				int32_t tune = 0;
+				float pan = 0.0f;
+				float attenuation = 0.0f;
+
+				LFO modLFO = {0,0};
+				int16_t modLFO_to_pitch = 0;
+				int16_t modLFO_to_filter_fc = 0;
+				int16_t modLFO_to_volume = 0;
+				LFO vibLFO = {0,0};
+				int16_t vibLFO_to_pitch = 0;
+
+				Envelope modEnv;
+				int16_t modEnv_to_pitch = 0;
+				int16_t modEnv_to_filter_fc = 0;
+				Envelope volEnv;
+			};
+			//Zone* global_zone = nullptr;
+			//stored contiguously in zone_arena
+			ArenaSpan<Zone> layers;
+		};
+		struct Bank
+		{
+			uint16_t num;//MIDI Bank Number
+			std::vector<std::unique_ptr<Preset>> presets;
+		};
+		std::vector<std::unique_ptr<Bank>> banks;
+		//Storage of all instrument and preset zones
+		Arena zone_arena;
+
+		struct BiQuadLowpass
+		{
+			float inv_Q;
+			float a0;
+			float a1;
+			float b1;
+			float b2;
+			float z1 = 0;
+			float z2 = 0;
+			bool active;
+
+			inline void set_Q(float Q)
+			{
+				inv_Q = 1.0f / Q;
+			}
+
+			inline void set_frequency(float Fc)
+			{
+				float K = std::tan(M_PI * Fc);
+				float KK = K * K;
+				float norm = 1.0f / (1.0f + K * inv_Q + KK);
+				a0 = KK * norm;
+				a1 = 2.0f * a0;
+				b1 = 2.0f * (KK - 1) * norm;
+				b2 = (1.0f - K * inv_Q + KK) * norm;
+			}
+
+			inline float process(float in)
+			{
+				float out = in * a0 + z1;
+				z1 = in * a1 + z2 - b1 * out;
+				z2 = in * a0 - b2 * out;
+				return out;
+			}
+		};
+
+		struct Voice
+		{
+			Instrument::Zone* zone = nullptr;
+
+			Sample* sample = nullptr;
+			double sample_pos = 0;
+			uint32_t sample_end_pos = 0;
+			//Streamed part of the sample, nullptr if the sample is resident
+			VoiceStream* stream = nullptr;
+
+			bool hold = false;
+			uint32_t loop_start = 0;
+			uint32_t loop_end = 0;
+
+			float pan_factor_l = 0.0f, pan_factor_r = 0.0f;
+			//float src_freq_factor = 0.0f;
+			float freq = 0.0f;
+			float gain = 0.0f;
+			float filter_freq = 0.0f;
+			float filter_q = 0.0f;
+			float modenv_to_filter_freq = 0.0f;
+			float modenv_to_pitch = 0.0f;
+
+			uint8_t key = 0;
+
+			enum class EnvPhase : int
+			{
+				Delay = 0,
+				Attack = 1,
+				Hold = 2,
+				Decay = 3,
+				Sustain = 4,
+				Release = 5,
+				End = 6
+			};
+
+			template <bool is_decibels = true>
+			struct Env
+			{
+				float
+					delay,
+					attack,
+					hold,
+					decay,
+					sustain,
+					release;
+
+				float keynumToHold = 1.0f;
+				float keynumToDecay = 1.0f;
+
+				double slope_factor;
+				EnvPhase phase = EnvPhase::Delay;
+				double time = 0;
+				float value = 0;
+
+				Env()
+				{
+
+				}
+				Env(const Envelope& env, const Envelope& env2, uint8_t key)
+				{
+					if constexpr(is_decibels) value = -96.0f;
+
+					Envelope tmp_envelope = env+env2;
+					//setup volume envelope
+					delay = timecents_to_seconds(tmp_envelope.delay);
+					attack = timecents_to_seconds(tmp_envelope.attack);
+					hold = timecents_to_seconds(tmp_envelope.hold);
+					hold *= timecents_to_seconds(tmp_envelope.keynumToHold*(60-key));
+					decay = timecents_to_seconds(tmp_envelope.decay);
+					decay *= timecents_to_seconds(tmp_envelope.keynumToDecay*(60-key));
+					release = timecents_to_seconds(tmp_envelope.release);
+					if constexpr(is_decibels)
+						sustain = tmp_envelope.sustain*0.1f;//this one is decibels
+					else
+						sustain = 1.0f-tmp_envelope.sustain*0.001f;//this one is 0.1 units, expressed as percents
+					slope_factor = 1.0f/delay;
+				}
+
+				//ADSR envelope operates in decibels
+				float Get(float delta_time)
+				{
+					switch(phase)
+					{
+					case EnvPhase::Delay:
+					{
+						//wait before fading in
+						time += delta_time;
+						if(time >= delay)
+						{
+							//go to the next phase
+							time -= delay;
+							phase = EnvPhase::Attack;
+							slope_factor = 1.0f/attack;				
+						}
+						if constexpr(is_decibels)
+							return -96.0f;
+						else
+							return 0.0f;
+						break;
+					}
+					case EnvPhase::Attack:
+					{
+						float val;
+						if constexpr(is_decibels)
+							val = gain_to_decibels(time * slope_factor);
+						else
+							val = time * slope_factor;
+						value = val;
+
+						time += delta_time;
+						if(time >= attack)
+						{
+							//go to the next phase
+							time -= attack;
+							phase = EnvPhase::Hold;
+							slope_factor = 1.0f/hold;
+						}
+						return val;
+					}
+					case EnvPhase::Hold:
+					{
+						//stay at maximum level for some time
+						if constexpr(is_decibels)
+							value = 0.0f;
+						else
+							value = 1.0f;
+
+						time += delta_time;
+						if(time >= hold)
+						{
+							//go to the next phase
+							time -= hold;
+							phase = EnvPhase::Decay;
+							slope_factor = 1.0f/decay;
+						}
+						if constexpr(is_decibels)
+							return 0.0f;
+						else
+							return 1.0f;
+					}
+					case EnvPhase::Decay:
+					{
+						//fade from maximum to sustain level
+						float val;
+						if constexpr(is_decibels)
+							val = -sustain * time * slope_factor;
+						else
+							val = fast_lerp(1.0f, sustain, time * slope_factor);
+						value = val;
+						time += delta_time;
+						if(time >= decay)
+						{
+							//go to the next phase
+							time -= decay;
+							phase = EnvPhase::Sustain;
+						}
+						return value;
+					}
+					case EnvPhase::Sustain:
+					{
+						//wait for note off
+						if constexpr(is_decibels)
+							return -sustain;
+						else
+							return sustain;
+					}
+					case EnvPhase::Release:
+					{
+						//fade out linearly
+						float val;
+						if constexpr(is_decibels)
+							val = value + (time * slope_factor) * (-96.0f - value);
+						else
+							val = fast_lerp(value, 0.0f, time * slope_factor);
+						time += delta_time;
+						if(time >= release)
+						{
+							//go to the next phase
+							time -= release;
+							phase = EnvPhase::End;
+						}
+						return val;
+					}
+					default:
+					{
+						//finished or error
+						if constexpr(is_decibels)
+							return -96.0f;
+						else
+							return 0.0f;
+					}
+					}
+
+					//unreachable code
+					/*if constexpr(is_decibels)
+						return -96.0f;
+					else
+						return 0.0f;*/
+				}
+
+				void Release()
+				{
+					slope_factor = 1.0f/release;
+					phase = Voice::EnvPhase::Release;
+					time = 0.0f;
+				}
+			};
+			Env<true> volenv;
+			Env<false> modenv;
+			BiQuadLowpass lowpass;
+
+			struct VoiceLFO
+			{
+				float time;
+				float freq;
+				float delay;
+
+				VoiceLFO()
+				{
+				}
+
+				VoiceLFO(LFO& lfo, LFO& lfo2)
+				{
+					LFO tmp_lfo = lfo+lfo2;
+					time = 0.0f;
+					freq = 8.176f*cents_to_hertz(tmp_lfo.frequency);
+					delay = timecents_to_seconds(tmp_lfo.delay);
+				}
+
+				float Get(float delta_time)
+				{
+					//triangle wave
+					time += delta_time;
+					return (time < delay)?0.0f:std::abs(std::fmod(4.0f*freq*(time-delay)+3.0f, 4.0f)-2.0f)-1.0f;
+				}
+			};
+			VoiceLFO modLFO;
+			float modLFO_to_pitch = 0;
+			float modLFO_to_filter_fc = 0;
+			float modLFO_to_volume = 0;
+			VoiceLFO vibLFO;
+			float vibLFO_to_pitch = 0;
+
+			//Note Off
+			void Release()
+			{
+				hold = false;
+			}
+
+			//Decoded blocks of compressed sample data
+			struct DecodedBlock
+			{
+				const uint8_t* data = nullptr;
+				uint32_t block = 0;
+				float frames[compressed_block_frames];
+			};
+			//two blocks cover interpolation across block boundaries and loop points,
+			//allocated on the first render of a compressed sample so that voices
+			//of other formats stay small, freed by Free()
+			DecodedBlock* decoded = nullptr;
+			//most recently used block
+			uint8_t decoded_last = 0;
+
+			template <SampleFormat format>
+			inline float LoadFrame(const uint8_t* data, uint32_t index)
+			{
+				if constexpr(format == SampleFormat::Compressed)
+				{
+					uint32_t block = index / compressed_block_frames;
+					uint32_t offset = index % compressed_block_frames;
+					auto& last = decoded[decoded_last];
+					if(last.data == data && last.block == block)
+						return last.frames[offset];
+					decoded_last ^= 1;
+					auto& other = decoded[decoded_last];
+					if(other.data != data || other.block != block)
+					{
+						decompress_block(data, block, other.frames);
+						other.data = data;
+						other.block = block;
+					}
+					return other.frames[offset];
+				}
+				else
+					return load_sample<format>(data, index);
+			}
+
+			template <SampleFormat format>
+			inline float GetFrame(uint32_t pos)
+			{
+				if(pos < sample->resident_size)
+					return LoadFrame<format>(sample->data.get(), pos);
+				if(pos - sample->loop_data_start < sample->loop_data_size)
+					return LoadFrame<format>(sample->loop_data.get(), pos - sample->loop_data_start);
+				return stream?stream->Get(pos):0.0f;
+			}
+
+			//Must be called before the voice is discarded,
+			//releases the stream and unpins the sample
+			void Free(SoundFont2& sf)
+			{
+				if(stream)
+				{
+					sf.disk_streamer->Release(stream);
+					stream = nullptr;
+				}
+				if(sample)
+				{
+					sample->Unpin(sf);
+					sample = nullptr;
+				}
+				delete[] decoded;
+				decoded = nullptr;
+			}
+
+			void Render(float* output_L, float* output_R, uint32_t size, float sample_rate)
+			{
+				//pick the kernel once per block, not per frame
+				switch(sample->format)
+				{
+				case SampleFormat::Int16:
+					Render<SampleFormat::Int16>(output_L, output_R, size, sample_rate);
+					break;
+				case SampleFormat::Int24:
+					Render<SampleFormat::Int24>(output_L, output_R, size, sample_rate);
+					break;
+				case SampleFormat::Half:
+					Render<SampleFormat::Half>(output_L, output_R, size, sample_rate);
+					break;
+				case SampleFormat::BFloat16:
+					Render<SampleFormat::BFloat16>(output_L, output_R, size, sample_rate);
+					break;
+				case SampleFormat::Compressed:
+					if(!decoded)
+					{
+						decoded = new DecodedBlock[2];
+						decoded_last = 0;
+					}
+					Render<SampleFormat::Compressed>(output_L, output_R, size, sample_rate);
+					break;
+				default:
+					Render<SampleFormat::Float>(output_L, output_R, size, sample_rate);
+					break;
+				}
+			}
+
+			template <SampleFormat format>
+			void Render(float* output_L, float* output_R, uint32_t size, float sample_rate)
+			{
+				//Wavetable oscillator implementation
+				//TODO: optimize
+
+				//inverse of sample rate (which is also delta time)
+				double sample_rate_inv = 1.0f/sample_rate;
+
+				//calculate sample data playback step
+				//float step = sample->sample_rate/(source_frequency*sample_rate)*frequency;
+				//double step = (src_freq_factor*freq)/sample_rate;
+				double step = freq/sample_rate;
+				double step_ = step;
+				//time, in seconds, specifying duration of a sample
+				double delta_time = sample_rate_inv;
+				for(uint32_t i = 0; i < size && sample_pos < sample->size; ++i)
+				{
+					//truncate floating point position to integer
+					//effectively removing fractional part
+					uint32_t pos = sample_pos;
+					bool is_looping = ((hold && zone->loop_mode != LoopMode::None) || zone->loop_mode == LoopMode::Continuous);
+					//get position next to the current or wrapped around if out of loop bounds
+					uint32_t pos_next = (pos >= loop_end && is_looping || pos + 1 >= sample->size)?((is_looping)?loop_start:pos):(pos + 1);
+					//get interpolation factor by subtracting truncated position from original,
+					//resulting value is the fractional part of the position
+					float lerp_factor = sample_pos - float(pos);
+					//get interpolated value between two adjacent sample points
+					float val = fast_lerp(GetFrame<format>(pos), GetFrame<format>(pos_next), lerp_factor);
+					if(stream) stream->Consume(pos);
+					if(pos > sample->size) printf("pos out of range!\n");
+					if(pos_next > sample->size) printf("pos_next out of range!\n");
+					if(sample_pos >= sample->size)
+					{
+						printf("out of range: %f\n", val);
+					}
+					//increment sample position using pitch based step value
+					sample_pos += step;
+					if(sample_pos >= loop_end && is_looping)
+						sample_pos -= (loop_end - loop_start);
+
+					auto tmp_state = volenv.phase;
+					float volenv_gain = decibels_to_gain(volenv.Get(delta_time));
+					float modenv_gain = modenv.Get(delta_time);
+					//prematurely end inaudible voice (optimization)
+					//TODO: add an option to disable
+					if(volenv_gain < 0.002f && volenv.phase == Voice::EnvPhase::Release)
+						volenv.phase = Voice::EnvPhase::End;
+					//release volume envelope
+					if(static_cast<int>(volenv.phase) < static_cast<int>(Voice::EnvPhase::Release) && !hold)
+					{
+						//immediately jump to the release phase after a note off
+						volenv.Release();
+					}
+					//release modulation envelope
+					if(static_cast<int>(modenv.phase) < static_cast<int>(Voice::EnvPhase::Release) && !hold)
+					{
+						//immediately jump to the release phase after a note off
+						modenv.Release();
+					}
+					val *= gain * volenv_gain;
+					float viblfo_val;
+					if(vibLFO_to_pitch)
+						viblfo_val = vibLFO.Get(delta_time);
+					float modlfo_val;
+					if(modLFO_to_pitch || modLFO_to_filter_fc || modLFO_to_volume)
+						modlfo_val = modLFO.Get(delta_time);
+					float filter_freq_new = filter_freq;
+					if(modenv_to_filter_freq || modLFO_to_filter_fc)
+					{
+						if(modenv_to_filter_freq)
+							filter_freq_new *= cents_to_hertz(modenv_gain*modenv_to_filter_freq);
+						if(modLFO_to_filter_fc)
+							filter_freq_new *= cents_to_hertz(modlfo_val*modLFO_to_filter_fc);
+						//lowpass.active = !(filter_freq_new > sample_rate*0.45f || filter_q == 0.0f);
+					}
+					if(lowpass.active)
+					{			
+						//Spec says 20kHz is the limit but it causes clicks,
+						//so a multiple of sample rate is used instead, to avoid biquad filter instability
+						//I don't exclude the possibility that maybe I misunderstood something though
+						/*if(filter_freq_new > sample_rate * 0.45f)
+						{
+							filter_freq_new = sample_rate*0.45f;
+						}*/if(filter_freq_new > sample_rate * 0.4977f)
+						{
+							filter_freq_new = sample_rate*0.4977f;
+						}
+						if(filter_freq_new != filter_freq)
+						{
+							//lowpass.set_frequency(filter_freq_new/sample_rate);
+							lowpass.set_frequency(filter_freq_new*sample_rate_inv);
+						}
+						val = lowpass.process(val);
+					}
+					float adjusted_pitch = 1.0f;
+					if(modenv_to_pitch || vibLFO_to_pitch || modLFO_to_pitch)
+					{
+						if(modenv_to_pitch)
+							adjusted_pitch *= cents_to_hertz(modenv_gain*modenv_to_pitch);
+						if(vibLFO_to_pitch)
+							adjusted_pitch *= cents_to_hertz(vibLFO_to_pitch*viblfo_val);
+						if(modLFO_to_pitch)
+							adjusted_pitch *= cents_to_hertz(modLFO_to_pitch*modlfo_val);
+						//step = (src_freq_factor*freq*adjusted_pitch)/sample_rate;
+						step = step_*adjusted_pitch;
+					}
+					if(modLFO_to_volume)
+					{
+						val *= decibels_to_gain(modlfo_val*modLFO_to_volume);
+					}
+					//val = volenv_gain;
+					//val = modenv_gain;
+					/*if(modLFO_to_pitch || modLFO_to_filter_fc || modLFO_to_volume)
+					val = modlfo_val;
+					else val = 0;*/
+
+					//add value to the outputs with appropriate panning factors applied
+					output_L[i] += val * pan_factor_l;
+					output_R[i] += val * pan_factor_r;
+				}
+
+				//test
+				//save RAW
+				/*std::ofstream outfile ("wave.raw",std::ofstream::binary);
+				outfile.write((char*)sample->data, sizeof(float)*sample->size);
+				outfile.close();*/
+			}
+
+			bool IsDone()
+			{
+				return (sample_pos >= sample->size && !hold) || volenv.phase == Voice::EnvPhase::End;
+			}
+		};
+
+		//Loads all samples used by a preset,
+		//mapped samples are prefetched
+		void LoadPresetSamples(Preset* preset)
+		{
+			for(auto& layer : preset->layers)
+			{
+				for(auto& split : layer.instrument->splits)
+				{
+					if(!split.sample->IsLoaded())
+					{
+						split.sample->load_data(*this);
+					}
+					split.sample->prefetch();
+				}
+			}
+		}
+
+		//Keeps samples of a preset from being evicted
+		void PinPresetSamples(Preset* preset)
+		{
+			if(!preset) return;
+			for(auto& layer : preset->layers)
+			{
+				for(auto& split : layer.instrument->splits)
+					split.sample->Pin(*this);
+			}
+		}
+
+		void UnpinPresetSamples(Preset* preset)
+		{
+			if(!preset) return;
+			for(auto& layer : preset->layers)
+			{
+				for(auto& split : layer.instrument->splits)
+					split.sample->Unpin(*this);
+			}
+		}
+
+		bool IsPresetLoaded(Preset* preset)
+		{
+			for(auto& layer : preset->layers)
+			{
+				for(auto& split : layer.instrument->splits)
+				{
+					if(!split.sample->IsLoaded()) return false;
+				}
+			}
+			return true;
+		}
+
+		//Merging of neighbouring sample reads in batched loads
+		struct ReadCoalescingOptions
+		{
+			//samples whose data lies at most this many bytes of smpl apart are read at once
+			size_t max_gap = 256 << 10;
+			//bytes of smpl read at once, 0 reads every sample separately
+			size_t max_size = 4 << 20;
+		};
+		ReadCoalescingOptions read_coalescing;
+
+		//Samples loaded from a single read of smpl and a single read of sm24
+		struct SampleRun
+		{
+			//in file order
+			std::vector<Sample*> samples;
+			//frames of smpl covering load_extent() of every sample
+			uint32_t first = 0;
+			uint32_t frames = 0;
+		};
+
+		//Groups samples into runs in file order following read_coalescing,
+		//a sample larger than max_size gets a run of its own,
+		//compressed SF3 samples are left out, they are decoded on their own
+		std::vector<SampleRun> PlanSampleRuns(std::vector<Sample*> list) const
+		{
+			list.erase(std::remove_if(list.begin(), list.end(), [](Sample* sample){ return sample->encoded_size != 0; }), list.end());
+			std::sort(list.begin(), list.end(), [](Sample* a, Sample* b){ return a->data_stream_offset < b->data_stream_offset; });
+			list.erase(std::unique(list.begin(), list.end()), list.end());
+			uint64_t max_gap = read_coalescing.max_gap/sizeof(int16_t);
+			uint64_t max_frames = read_coalescing.max_size/sizeof(int16_t);
+			std::vector<SampleRun> runs;
+			for(auto sample : list)
+			{
+				uint64_t first = sample->data_stream_offset;
+				uint64_t end = first + sample->load_extent(*this);
+				if(!runs.empty())
+				{
+					SampleRun& run = runs.back();
+					uint64_t run_end = uint64_t(run.first) + run.frames;
+					if(first <= run_end + max_gap && std::max(end, run_end) - run.first <= max_frames)
+					{
+						run.samples.push_back(sample);
+						run.frames = uint32_t(std::max(end, run_end) - run.first);
+						continue;
+					}
+				}
+				runs.push_back({{sample}, sample->data_stream_offset, uint32_t(end - first)});
+			}
+			return runs;
+		}
+
+		//Frames of a run belonging to one of its samples
+		Sample::RawFrames run_frames(const SampleRun& run, Sample* sample, const uint8_t* data16, const uint8_t* data24) const
+		{
+			uint32_t offset = sample->data_stream_offset - run.first;
+			Sample::RawFrames raw;
+			raw.data16 = reinterpret_cast<const int16_t*>(data16) + offset;
+			raw.data24 = data24?data24 + offset:nullptr;
+			raw.frames = sample->load_extent(*this);
+			return raw;
+		}
+
+		//Reads the data of a run at once and loads its samples from it,
+		//waits for samples being loaded by other threads
+		void load_run(const SampleRun& run)
+		{
+			std::vector<Sample*> loading;
+			std::vector<std::unique_lock<std::mutex>> load_locks;
+			std::vector<Sample*> busy;
+			for(auto sample : run.samples)
+			{
+				std::unique_lock<std::mutex> load_lock(sample->load_mutex, std::try_to_lock);
+				if(!load_lock.owns_lock())
+				{
+					busy.push_back(sample);
+					continue;
+				}
+				if(sample->IsLoaded()) continue;
+				loading.push_back(sample);
+				load_locks.push_back(std::move(load_lock));
+			}
+			if(!loading.empty())
+			{
+				size_t size16 = size_t(run.frames)*sizeof(int16_t);
+				size_t size24 = sample_data_24_offset?run.frames:0;
+				std::unique_ptr<uint8_t[]> buffer(new uint8_t[size16 + size24]);
+				//data past the end of the chunks reads as silence
+				size_t count = read_stream(sample_data_offset + size_t(run.first)*sizeof(int16_t), buffer.get(), size16);
+				std::memset(buffer.get() + count, 0, size16 - count);
+				if(size24)
+				{
+					count = read_stream(sample_data_24_offset + run.first, buffer.get() + size16, size24);
+					std::memset(buffer.get() + size16 + count, 0, size24 - count);
+				}
+				for(size_t i = 0; i < loading.size(); ++i)
+				{
+					auto raw = run_frames(run, loading[i], buffer.get(), size24?buffer.get() + size16:nullptr);
+					loading[i]->load_data_locked(*this, &raw);
+					load_locks[i].unlock();
+				}
+				TrimSampleMemory();
+			}
+			for(auto sample : busy)
+				sample->load_data(*this);
+		}
+
+		//Loads and converts samples in parallel using "threads" threads
+		//including the calling one, 0 uses all hardware threads,
+		//sample data that isn't in memory is read in runs of neighbouring samples
+		void LoadSamples(const std::vector<Sample*>& list, unsigned threads = 0)
+		{
+			std::vector<Sample*> pending;
+			for(auto sample : list)
+			{
+				if(!sample->IsLoaded()) pending.push_back(sample);
+			}
+			//the same sample can be listed more than once, load_data handles that
+			std::vector<SampleRun> runs;
+			bool coalesce = stream && !sample_data && read_coalescing.max_size &&
+				!stream->view(sample_data_offset, sample_data_size);
+			if(coalesce)
+			{
+				//runs are read in file order, so that reads stay sequential,
+				//compressed samples are decoded first, as they take the longest
+				runs = PlanSampleRuns(pending);
+				pending.erase(std::remove_if(pending.begin(), pending.end(), [](Sample* sample){ return sample->encoded_size == 0; }), pending.end());
+			}
+			//largest first, so that threads run out of work at about the same time
+			std::sort(pending.begin(), pending.end(), [](Sample* a, Sample* b){ return a->size > b->size; });
+			parallel_for(pending.size() + runs.size(), threads, [&](size_t i)
+			{
+				if(i < pending.size()) pending[i]->load_data(*this);
+				else load_run(runs[i - pending.size()]);
+			});
+		}
+
+		//Loads samples of all given presets in parallel
+		void LoadPresetSamples(const std::vector<Preset*>& list, unsigned threads = 0)
+		{
+			std::vector<Sample*> used;
+			for(auto preset : list)
+			{
+				for(auto& layer : preset->layers)
+				{
+					for(auto& split : layer.instrument->splits)
+						used.push_back(split.sample);
+				}
+			}
+			std::sort(used.begin(), used.end());
+			used.erase(std::unique(used.begin(), used.end()), used.end());
+			LoadSamples(used, threads);
+		}
+
+		//Loads every sample in the bank in parallel
+		void LoadAllSamples(unsigned threads = 0)
+		{
+			std::vector<Sample*> all;
+			all.reserve(samples.size());
+			for(auto& sample : samples)
+				all.push_back(sample.get());
+			LoadSamples(all, threads);
+		}
+
+		//Loads samples with batches of io_uring reads of "fd", the file the bank was parsed from,
+		//samples are converted as soon as their reads complete while other reads are in flight,
+		//"max_bytes" limits raw sample data buffered at once,
+		//falls back to LoadSamples if io_uring can't be used, returns whether it was used
+		bool LoadSamplesIoUring(const std::vector<Sample*>& list, int fd, unsigned queue_depth = 64, size_t max_bytes = 64 << 20)
+		{
+		#ifdef SF2_IO_URING_SUPPORTED
+			//nothing to read if sample data is already in memory
+			//or the bank has no source stream, as when loaded from a cache
+			if(!stream || sample_data || stream->view(sample_data_offset, sample_data_size))
+			{
+				LoadSamples(list);
+				return false;
+			}
+			std::vector<Sample*> pending;
+			for(auto sample : list)
+			{
+				if(!sample->IsLoaded()) pending.push_back(sample);
+			}
+			//neighbouring samples share reads
+			auto runs = PlanSampleRuns(pending);
+			std::vector<Sample*> encoded;
+			std::copy_if(pending.begin(), pending.end(), std::back_inserter(encoded), [](Sample* sample){ return sample->encoded_size != 0; });
+
+			struct Job
+			{
+				const SampleRun* run = nullptr;
+				std::vector<Sample*> loading;
+				std::vector<std::unique_lock<std::mutex>> load_locks;
+				std::unique_ptr<uint8_t[]> buffer;
+				size_t size16 = 0;
+				size_t buffer_size = 0;
+				unsigned reads_left = 0;
+			};
+			struct Read
+			{
+				size_t job;
+				uint8_t* dest;
+				uint32_t size;
+				uint64_t offset;
+			};
+			std::vector<Job> jobs;
+			jobs.reserve(runs.size());
+			std::vector<Read> reads;
+			//reads waiting for space in the submission queue
+			std::deque<size_t> queued;
+			//samples loaded by other threads at the moment
+			std::vector<Sample*> busy;
+			size_t buffered = 0;
+			const uint32_t max_read = 1 << 20;
+			//declared after buffers, so that it's closed first, which waits for reads in flight
+			IoUring ring(queue_depth);
+			if(!ring.IsValid())
+			{
+				LoadSamples(list);
+				return false;
+			}
+
+			auto finish = [&](Job& job)
+			{
+				for(size_t i = 0; i < job.loading.size(); ++i)
+				{
+					auto raw = run_frames(*job.run, job.loading[i], job.buffer.get(),
+						job.buffer_size > job.size16?job.buffer.get() + job.size16:nullptr);
+					job.loading[i]->load_data_locked(*this, &raw);
+					job.load_locks[i].unlock();
+				}
+				job.buffer.reset();
+				buffered -= job.buffer_size;
+			};
+			auto add_reads = [&](size_t job, uint8_t* dest, size_t size, uint64_t offset)
+			{
+				for(size_t done = 0; done < size;)
+				{
+					uint32_t count = (uint32_t)std::min<size_t>(size - done, max_read);
+					queued.push_back(reads.size());
+					reads.push_back({job, dest + done, count, offset + done});
+					++jobs[job].reads_left;
+					done += count;
+				}
+			};
+
+			bool failed = false;
+			size_t next = 0;
+			for(;;)
+			{
+				//start loading runs while their data fits
+				while(next < runs.size())
+				{
+					const SampleRun& run = runs[next];
+					size_t size16 = size_t(run.frames)*sizeof(int16_t);
+					size_t size24 = sample_data_24_offset?run.frames:0;
+					if(buffered && buffered + size16 + size24 > max_bytes) break;
+					++next;
+					Job job;
+					job.run = &run;
+					for(auto sample : run.samples)
+					{
+						std::unique_lock<std::mutex> load_lock(sample->load_mutex, std::try_to_lock);
+						if(!load_lock.owns_lock())
+						{
+							busy.push_back(sample);
+							continue;
+						}
+						if(sample->IsLoaded()) continue;
+						job.loading.push_back(sample);
+						job.load_locks.push_back(std::move(load_lock));
+					}
+					if(job.loading.empty()) continue;
+					job.buffer = std::make_unique<uint8_t[]>(size16 + size24);
+					job.size16 = size16;
+					job.buffer_size = size16 + size24;
+					buffered += job.buffer_size;
+					jobs.push_back(std::move(job));
+					add_reads(jobs.size()-1, jobs.back().buffer.get(), size16, sample_data_offset + uint64_t(run.first)*sizeof(int16_t));
+					if(size24)
+						add_reads(jobs.size()-1, jobs.back().buffer.get() + size16, size24, sample_data_24_offset + uint64_t(run.first));
+					if(jobs.back().reads_left == 0) finish(jobs.back());
+				}
+				while(!queued.empty() && ring.Space())
+				{
+					Read& read = reads[queued.front()];
+					ring.Read(fd, read.dest, read.size, read.offset, queued.front());
+					queued.pop_front();
+				}
+				if(ring.InFlight() == 0) break;
+				if(!ring.Submit(1))
+				{
+					failed = true;
+					break;
+				}
+				ring.Reap([&](uint64_t index, int32_t result)
+				{
+					Read& read = reads[index];
+					if(result == -EINTR || result == -EAGAIN || (result > 0 && uint32_t(result) < read.size))
+					{
+						//try again with the rest
+						if(result > 0)
+						{
+							read.dest += result;
+							read.size -= result;
+							read.offset += result;
+						}
+						queued.push_back(index);
+						return;
+					}
+					if(result < 0)
+					{
+						//unsupported operation or error, a plain read gets the same data or fails the same way
+						size_t count = read_stream(read.offset, read.dest, read.size);
+						std::memset(read.dest + count, 0, read.size - count);
+					}
+					else if(result == 0)
+					{
+						//end of file
+						std::memset(read.dest, 0, read.size);
+					}
+					Job& job = jobs[read.job];
+					if(--job.reads_left == 0) finish(job);
+				});
+			}
+			if(failed)
+			{
+				//reads in flight still write to job buffers, which are leaked
+				//rather than freed under them if they can't be waited for
+				if(!ring.Drain())
+				{
+					for(auto& job : jobs)
+						job.buffer.release();
+				}
+				ring.close();
+				for(auto& job : jobs)
+				{
+					for(auto& load_lock : job.load_locks)
+					{
+						if(load_lock.owns_lock()) load_lock.unlock();
+					}
+				}
+				LoadSamples(pending);
+			}
+			for(auto sample : busy)
+				sample->load_data(*this);
+			LoadSamples(encoded);
+			TrimSampleMemory();
+			return !failed;
+		#else
+			(void)fd; (void)queue_depth; (void)max_bytes;
+			LoadSamples(list);
+			return false;
+		#endif
+		}
+
+		//Background thread loading preset samples in order of requests
+		struct SampleLoader
+		{
+			struct Request
+			{
+				Preset* preset = nullptr;
+				std::atomic<bool> done = false;
+				//set before "done" if loading threw, e.g. out of memory or from sample_decoder
+				bool failed = false;
+				std::mutex mutex;
+				std::condition_variable cv;
+
+				bool IsDone() const
+				{
+					return done.load(std::memory_order_acquire);
+				}
+
+				//Returns false if the request isn't done within timeout
+				bool Wait(std::chrono::microseconds timeout)
+				{
+					if(IsDone()) return true;
+					std::unique_lock<std::mutex> lock(mutex);
+					return cv.wait_for(lock, timeout, [this]{return IsDone();});
+				}
+			};
+
+			SoundFont2* sf;
+			std::mutex mutex;
+			std::condition_variable cv;
+			std::deque<std::shared_ptr<Request>> queue;
+			bool quit = false;
+			std::thread thread;
+
+			SampleLoader(SoundFont2* sf): sf(sf)
+			{
+				thread = std::thread([this]{Run();});
+			}
+
+			~SampleLoader()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					quit = true;
+				}
+				cv.notify_one();
+				thread.join();
+			}
+
+			std::shared_ptr<Request> Enqueue(Preset* preset)
+			{
+				auto request = std::make_shared<Request>();
+				request->preset = preset;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					queue.push_back(request);
+				}
+				cv.notify_one();
+				return request;
+			}
+
+			void Run()
+			{
+				while(true)
+				{
+					std::shared_ptr<Request> request;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						cv.wait(lock, [this]{return quit || !queue.empty();});
+						if(quit) return;
+						request = std::move(queue.front());
+						queue.pop_front();
+					}
+					//an exception can't leave the thread, and the request must finish anyway
+					try
+					{
+						sf->LoadPresetSamples(request->preset);
+					}
+					catch(...)
+					{
+						request->failed = true;
+					}
+					{
+						std::lock_guard<std::mutex> lock(request->mutex);
+						request->done.store(true, std::memory_order_release);
+					}
+					request->cv.notify_all();
+				}
+			}
+		};
+
+		//Started on first asynchronous request
+		SampleLoader& GetSampleLoader()
+		{
+			std::call_once(sample_loader_once, [this]{sample_loader = std::make_unique<SampleLoader>(this);});
+			return *sample_loader;
+		}
+
+		//What happens to notes played while a preset is being loaded asynchronously
+		enum class PendingNotePolicy
+		{
+			//notes are dropped
+			Silence = 0,
+			//NoteOn waits for the preset up to a deadline, then the note is dropped
+			Wait = 1
+		};
+
+		struct Channel
+		{
+			DynamicPool<Voice> voices = DynamicPool<Voice>(64, 64);
+			std::vector<bool> key_states;
+			Bank* bank = nullptr;
+			Preset* preset = nullptr;
+			SoundFont2* sf = nullptr;
+			bool sustain = false;
+
+			//When enabled, SetPreset doesn't block on sample loading,
+			//the current preset keeps playing until the new one is loaded
+			bool async_loading = false;
+			PendingNotePolicy pending_note_policy = PendingNotePolicy::Silence;
+			std::chrono::microseconds pending_note_deadline = std::chrono::milliseconds(5);
+			//Preset waiting for its samples
+			std::shared_ptr<SampleLoader::Request> pending_request;
+			Bank* pending_bank = nullptr;
+
+			Channel()
+			{
+				key_states.resize(255, false);
+			}
+
+			~Channel()
+			{
+				//for(auto v : voices) delete v;
+				Panic();
+				if(sf)
+				{
+					sf->UnpinPresetSamples(preset);
+					if(pending_request) sf->UnpinPresetSamples(pending_request->preset);
+					sf->TrimSampleMemory();
+				}
+			}
+
+			void SetPreset(size_t presetno, size_t bankno = 0)
+			{
+				if(!sf) return;
+				if(sf->banks.empty()) return;
+
+				Bank* old_bank = bank;
+				Preset* old_preset = preset;
+
+				//find bank by number
+				Bank* target_bank = nullptr;
+				for(auto& b : sf->banks)
+				{
+					if(b->num == bankno)
+					{
+						target_bank = b.get();
+						break;
+					}
+				}
+				if(!target_bank) goto fallback_bank_zero;
+
+				//try to find a matching preset in requested bank
+				for(auto& p : target_bank->presets)
+				{
+					if(p->num == presetno)
+					{
+						bank = target_bank;
+						preset = p.get();
+						goto load_samples_proc;
+					}
+				}
+				//fallback to default bank 0
+				//exception: percussion bank 128
+				if(target_bank->num == 128)
+				{
+					if(!target_bank->presets.empty())
+					{
+						preset = target_bank->presets[0].get();
+						goto load_samples_proc;
+					}
+				}
+			fallback_bank_zero:
+				for(auto& p : sf->banks[0]->presets)
+				{
+					if(p->num == presetno)
+					{
+						bank = sf->banks[0].get();
+						preset = p.get();
+						goto load_samples_proc;
+					}
+				}
+
+			load_samples_proc:
+				//load samples
+				if(preset)
+				{
+					//samples of current and pending presets are pinned
+					sf->PinPresetSamples(preset);
+					//a newer request replaces the pending one
+					if(pending_request) sf->UnpinPresetSamples(pending_request->preset);
+					pending_request = nullptr;
+					if(async_loading && !sf->IsPresetLoaded(preset))
+					{
+						//keep the current preset until the new one is loaded
+						pending_bank = bank;
+						pending_request = sf->GetSampleLoader().Enqueue(preset);
+						bank = old_bank;
+						preset = old_preset;
+						return;
+					}
+					sf->UnpinPresetSamples(old_preset);
+					sf->LoadPresetSamples(preset);
+					//samples of the old preset might not fit anymore
+					sf->TrimSampleMemory();
+					return;
+				}
+				//failsafe
+				//on the second thought.. no failsafe
+			}
+
+			bool IsPresetPending()
+			{
+				return pending_request != nullptr;
+			}
+
+			//Switches to the pending preset if its samples are loaded,
+			//drops it and keeps the current one if loading failed,
+			//returns false if it's still loading
+			bool UpdatePendingPreset()
+			{
+				if(!pending_request) return true;
+				if(!pending_request->IsDone()) return false;
+				if(pending_request->failed)
+				{
+					sf->UnpinPresetSamples(pending_request->preset);
+					pending_bank = nullptr;
+					pending_request = nullptr;
+					return true;
+				}
+				sf->UnpinPresetSamples(preset);
+				bank = pending_bank;
+				preset = pending_request->preset;
+				pending_request = nullptr;
+				return true;
+			}
+
+			void NoteOn(uint8_t key, uint8_t velocity, float sample_rate)
+			{
+				if(!UpdatePendingPreset())
+				{
+					if(pending_note_policy == PendingNotePolicy::Silence)
+						return;
+					if(!pending_request->Wait(pending_note_deadline))
+						return;
+					UpdatePendingPreset();
+				}
+				if(!preset || !sf) return;
+
+				key_states[key] = true;
+
+				size_t size = voices.size();
+				sf->GenerateVoices(preset, key, velocity, sample_rate, voices);
+
+				//release exclusive voices
+				for(auto nv = voices.begin()+size; nv != voices.end(); ++nv)
+				{
+					if(nv->zone->exclusive_class != 0)
+					{
+						for(auto v = voices.begin(); v != voices.begin()+size; ++v)
+						{
+							if(v->zone->exclusive_class == nv->zone->exclusive_class)
+							{
+								v->Release();
+								//extinguish fast
+								v->volenv.value = v->volenv.Get(0.0f);
+								v->volenv.time = 0.0f;
+								v->volenv.release = 0.001f;
+							}
+						}
+					}
+				}
+			}
+
+			void NoteOff(uint8_t key)
+			{
+				key_states[key] = false;
+				if(!sustain)
+				{
+					for(auto& v : voices)
+					{
+						if(v.key == key)
+						{
+							v.Release();
+						}
+					}
+				}
+			}
+
+			void SetSustain(bool enable)
+			{
+				sustain = enable;
+				if(!enable)
+				{
+					//go through all recorded key states
+					for(size_t key = 0; key < key_states.size(); ++key)
+					{
+						//check if key is not held
+						if(!key_states[key])
+						{
+							//release all voices with that key
+							for(size_t i = 0; i < voices.size(); i++)
+							{
+								if(voices[i].key == key)
+								{
+									voices[i].Release();
+								}
+							}
+						}
+					}
+				}
+			}
+
+			void Render(float* output_L, float* output_R, uint32_t size, float sample_rate)
+			{
+				UpdatePendingPreset();
+				for(size_t i = 0; i < voices.size();)
+				{
+					auto& v = voices[i];
+					v.Render(output_L, output_R, size, sample_rate);
+					if(v.IsDone())
+					{
+						//delete v;
+						v.Free(*sf);
+						voices.erase(voices.begin() + i);
+					}
+					else ++i;
+				}
+			}
+
+			void Panic()
+			{
+				//for(auto v : voices) delete v;
+				if(sf) for(auto& v : voices) v.Free(*sf);
+				voices.clear();
+			}
+		};
+
+		//Note On
+		void GenerateVoices(Preset* preset, uint8_t key, uint8_t velocity, float sample_rate, DynamicPool<Voice>& container)
+		{
+			for(auto& layer : preset->layers)
+			{
+				//check if passes by key and velocity
+				if(key < layer.key_low || layer.key_high < key ||
+				   velocity < layer.vel_low || layer.vel_high < velocity)
+					continue;
+				for(auto& split : layer.instrument->splits)
+				{
+					//check if passes by key and velocity
+					if(key < split.key_low || split.key_high < key ||
+					   velocity < split.vel_low || split.vel_high < velocity)
+						continue;
+					//check if sample isn't ROM (because it's not supported)
+					if(IsSampleROM(split.sample->sample_type)) continue;
+
+					uint8_t tmp_vel = velocity;
+					uint8_t tmp_key = key;
+					//override velocity
+					if(split.velocity != -1)
+						tmp_vel = split.velocity;
+					//override key
+					if(split.keynum != -1)
+						tmp_key = split.keynum;
+
+					//get sample
+					Sample* sample_first = split.sample;
+					Sample* sample = sample_first;
+					float pan = 0.0f;//mono
+
+				create_voice:
+					{
+						//create new voice
+						container.emplace_back();
+						auto voice = &container.back();
+						voice->key = tmp_key;
+						voice->sample = sample;
+						sample->Pin(*this);
+						voice->zone = &split;
+						voice->stream = nullptr;
+						if(sample->resident_size < sample->size && disk_streamer)
+						{
+							//start streaming right after the resident part
+							voice->stream = disk_streamer->Acquire(
+								sample,
+								std::max<uint32_t>(sample->resident_size, std::max(split.start_offset, 0))
+							);
+						}
+						voice->hold = true;
+
+						//sample points
+						voice->sample_pos = split.start_offset;
+						voice->sample_end_pos = sample->size + split.end_offset;
+
+						//loop points
+						voice->loop_start = sample->loop_start + split.loop_start_offset;
+						voice->loop_end = sample->loop_end + split.loop_end_offset;
+
+						//add preset and instrument envelope value generators together
+						voice->volenv = Voice::Env<true>(layer.volEnv, split.volEnv, key);
+						voice->modenv = Voice::Env<false>(layer.modEnv, split.modEnv, key);
+						//setup lowpass filter
+						//8.176f - MIDI key 0 frequency used to convert "absolute pitch cents" to Hz
+						voice->filter_q = (layer.filter_q+split.filter_q);
+						voice->filter_freq = 8.176f*cents_to_hertz(layer.filter_freq+split.filter_freq);
+						voice->modenv_to_filter_freq = layer.modEnv_to_filter_fc+split.modEnv_to_filter_fc;
+						voice->lowpass.active = !(voice->filter_freq > 20000.0f && voice->filter_q < 0.0f && voice->modenv_to_filter_freq != 0.0f);
+						if(voice->lowpass.active)
+						{
+							voice->lowpass.set_Q(decibels_to_gain(voice->filter_q));
+							voice->lowpass.set_frequency(voice->filter_freq/sample_rate);
+						}
+						voice->modenv_to_pitch = layer.modEnv_to_pitch+split.modEnv_to_pitch;
+
+						voice->modLFO = Voice::VoiceLFO(layer.modLFO, split.modLFO);
+						voice->modLFO_to_filter_fc = layer.modLFO_to_filter_fc + split.modLFO_to_filter_fc;
+						voice->modLFO_to_pitch = layer.modLFO_to_pitch + split.modLFO_to_pitch;
+						voice->modLFO_to_volume = (layer.modLFO_to_volume + split.modLFO_to_volume)/10.0f;
+						voice->vibLFO = Voice::VoiceLFO(layer.modLFO, split.modLFO);
+						voice->vibLFO_to_pitch = layer.vibLFO_to_pitch + split.vibLFO_to_pitch;
+
+						//Calculate gain
+						//Factor of 0.4 is for compatibility, many soundfonts expect this behaviour...
+						//Even though it's against the specification, apparently that's how some
+						//E-MU synthesizers are designed as well, which leaves many questions.
+						//TODO: add an option to disable this behaviour
+						voice->gain = decibels_to_gain(-(layer.attenuation + split.attenuation)*0.4);
+						//linear velocity curve
+						voice->gain *= float(tmp_vel) / 127.0f;
+
+						//get pan on per sample basis
+						switch(sample->sample_type)
+						{
+						case SFSampleLink::monoSample: pan = 0.0f; break;
+						case SFSampleLink::leftSample: pan = -0.5f; break;
+						case SFSampleLink::rightSample: pan = 0.5f; break;
+						case SFSampleLink::linkedSample: pan = 0.0f; break;
+						//ROM samples are skipped and the SF3 compressed flag is cleared when loading
+						default: pan = 0.0f; break;
+						}
+						//calculate panning factors
+						constant_power_pan(
+							voice->pan_factor_l,
+							voice->pan_factor_r,
+							clamp_panning(pan + layer.pan + split.pan)
+						);
+
+						//printf("pitch correction: %f\n", sample->correction);
+
+						//calculate pitch factors
+						float root_key_cents = ((split.root_key == -1)?sample->original_key:split.root_key)*100.0f;
+						float note_cents = tmp_key*100.0f + split.tune + layer.tune;
+						float src_freq_factor = sample->sample_rate/cents_to_hertz(root_key_cents);
+						voice->freq = src_freq_factor*cents_to_hertz(root_key_cents + (note_cents - root_key_cents)*(split.scale_tuning+layer.scale_tuning));
+						if(sample->correction)
+						{
+							voice->freq *= cents_to_hertz(sample->correction);
+						}
+
+						//Check for next linked sample if sample type isn't mono.
+						//Since SoundFont 2.4 doesn't yet define circular linking,
+						//all we have to do is just handle one more sample for stereo
+						//but we'll go ahead and try to loop all of them.
+						if(split.sample->sample_type != SFSampleLink::monoSample)
+						{
+							//check for full circle
+							if(sample->linked_sample == sample_first || !sample->linked_sample)
+							{
+								//the circle is now complete
+								continue;
+							}
+
+							//get next sample
+							sample = sample->linked_sample;
+							//start over
+							goto create_voice;
+						}
+					}
+				}
+			}
+		}
+
+		//Empty soundfont, filled by LoadCache
+		SoundFont2() = default;
+
+		//"s" may be a forward-only stream, e.g. a pipe read with RIFF::forward_reader,
+		//if "riff" was parsed from it with RIFF::RIFF::load_policy::all(),
+		//sample data is then played from the loaded chunks and the stream isn't read again,
+		//instruments and presets are translated on "threads" threads, 0 uses all hardware threads
+		SoundFont2(RIFF::RIFF* riff, RIFF::stream* s, unsigned threads = 0)
+		{
+#define read_zstr(chunk, string, max_len)\
+			{\
+				if(chunk && chunk->get_data())\
+				{\
+					auto str = (const char*)chunk->get_data();\
+					string.assign(str, std::find(str, str + std::min<size_t>(chunk->size, max_len), 0));\
+				}\
+				else if(chunk && s->is_seekable())\
+				{\
+					/*read at once rather than char by char*/\
+					std::vector<char> str(std::min<size_t>(chunk->size, max_len));\
+					s->setpos(chunk->data_offset);\
+					str.resize(s->read(str.data(), str.size()));\
+					string.assign(str.begin(), std::find(str.begin(), str.end(), 0));\
+				}\
+			}
+#define read_versiontag(chunk, tag)\
+			{\
+				if(chunk && chunk->get_data() && chunk->size >= 4)\
+				{\
+					std::memcpy(&tag.wMajor, chunk->get_data(), sizeof(WORD));\
+					std::memcpy(&tag.wMinor, chunk->get_data() + sizeof(WORD), sizeof(WORD));\
+				}\
+				else if(chunk && s->is_seekable())\
+				{\
+					s->setpos(chunk->data_offset);\
+					s->read(&tag.wMajor, sizeof(WORD));\
+					s->read(&tag.wMinor, sizeof(WORD));\
+				}\
+			}
+#define read_field(field)\
+			{\
+				std::memcpy(&field, src, sizeof(field));\
+				src += sizeof(field);\
+			}
+#define read_records(chunk, records, record_size)\
+			{\
+				static_assert(sizeof(records[0]) == record_size, "record layout must match the file");\
+				records.resize(chunk->size/record_size);\
+				if(!records.empty())\
+					std::memcpy(records.data(), get_chunk_data(chunk), records.size()*record_size);\
+			}
+
+			RIFF_SoundFont2 sf2(riff);
+
+			SF2_DEBUG_OUTPUT("Reading file info...\n");
+			read_versiontag(sf2.INFO.ifil, ifil);
+			//check version
+			if(ifil.wMajor != 2)
+			{
+				//not supported
+				//TODO: reject the file
+			}
+			read_zstr(sf2.INFO.isng, szSoundEngine, 256);
+			read_zstr(sf2.INFO.INAM, szName, 256);
+			read_zstr(sf2.INFO.irom, szROM, 256);
+			read_versiontag(sf2.INFO.iver, iver);
+			read_zstr(sf2.INFO.ICRD, szDate, 256);
+			read_zstr(sf2.INFO.IENG, szCreator, 256);
+			read_zstr(sf2.INFO.IPRD, szProduct, 256);
+			read_zstr(sf2.INFO.ICOP, szCopyright, 256);
+			read_zstr(sf2.INFO.ICMT, szComment, 65536);
+			read_zstr(sf2.INFO.ISFT, szTools, 256);
+
+			SF2_DEBUG_OUTPUT("Storing sample data offsets...\n");
+			//Get sample data offsets of smpl and sm24 subchunks of sdta-list chunk
+			sample_data_offset = sf2.sdta.smpl->data_offset;
+			sample_data_size = sf2.sdta.smpl->size;
+			if(sf2.sdta.sm24)
+			{
+				sample_data_24_offset = sf2.sdta.sm24->data_offset;
+				sample_data_24_size = sf2.sdta.sm24->size;
+			}
+			else
+				sample_data_24_offset = 0;
+			//Sample data loaded during parsing is used instead of reading it again
+			sample_data = sf2.sdta.smpl->get_data();
+			sample_data_24 = sf2.sdta.sm24?sf2.sdta.sm24->get_data():nullptr;
+
+			//The HYDRA Data Structure 
+			//========================================================================
+			SF2_DEBUG_OUTPUT("Reading HYDRA data...\n");
+			//Each sub-chunk is read at once, or used in place if it's already in memory.
+			//SoundFont data is little-endian just like the host, so records whose layout
+			//matches the file are copied in bulk and the rest are decoded field by field.
+			std::vector<BYTE> chunk_buffer;
+			auto get_chunk_data = [&](RIFF::RIFF::chunk* c)->const BYTE*
+			{
+				if(auto data = c->get_data())
+					return data;
+				if(auto data = s->view(c->data_offset, c->size))
+					return static_cast<const BYTE*>(data);
+				chunk_buffer.assign(c->size, 0);
+				if(s->is_seekable())
+				{
+					s->setpos(c->data_offset);
+					s->read(chunk_buffer.data(), c->size);
+				}
+				return chunk_buffer.data();
+			};
+			const BYTE* src = nullptr;
+			//The PHDR sub-chunk is a required sub-chunk listing all
+			//presets within the SoundFont compatible file
+			src = get_chunk_data(sf2.pdta.phdr);
+			hydra.phdr.resize(sf2.pdta.phdr->size/38);
+			for(auto& preset : hydra.phdr)
+			{
+				read_field(preset.achPresetName);
+				//null-terminate preset name
+				//but why do I have to do this anyway? Standard says I should reject it!
+				preset.achPresetName[19] = 0;
+				read_field(preset.wPreset);
+				read_field(preset.wBank);
+				read_field(preset.wPresetBagNdx);
+				read_field(preset.dwLibrary);
+				read_field(preset.dwGenre);
+				read_field(preset.dwMorphology);
+			}
+			//The PBAG sub-chunk is a required sub-chunk listing all
+			//preset zones within the SoundFont compatible file.
+			//
+			/*If a preset has more than one zone, the first zone may be a global zone.
+			A global zone is determined by the fact that the last
+			generator in the list is not an Instrument generator.
+			All generator lists must contain at least one generator with one
+			exception - if a global zone exists for which there are
+			no generators but only modulators. The modulator lists can contain
+			zero or more modulators. */
+			read_records(sf2.pdta.pbag, hydra.pbag, 4);
+			//The PMOD sub-chunk is a required sub-chunk listing all
+			//preset zone modulators within the SoundFont compatible file.
+			//
+			/*Modulators in the PMOD sub-chunk act as additively
+			relative modulators with respect to those in the IMOD sub-chunk.
+			In other words, a PMOD modulator can increase or
+			decrease the amount of an IMOD modulator. */
+			read_records(sf2.pdta.pmod, hydra.pmod, 10);
+			//The PGEN chunk is a required chunk containing a list
+			//of preset zone generators for each preset zone within the SoundFont
+			//compatible file.
+			//
+			/*The preset zones wGenNdx points to the first generator
+			for that preset zone. Unless the zone is a global zone, the last
+			generator in the list is an Instrument generator,
+			whose value is a pointer to the instrument associated with that zone.
+			If a key range generator exists for the preset zone,
+			it is always the first generator in the list for that preset zone.
+			If a velocity range generator exists for the preset zone,
+			it will only be preceded by a key range generator. If any generators follow an
+			Instrument generator, they will be ignored.
+
+			A generator is defined by its sfGenOper.
+			All generators within a zone must have a unique sfGenOper enumerator.
+			If a second generator is encountered with the same sfGenOper enumerator
+			as a previous generator with the same zone, the first
+			generator will be ignored.
+
+			Generators in the PGEN sub-chunk are applied relative to generators
+			in the IGEN sub-chunk in an additive manner.
+			In other words, PGEN generators increase or decrease the value
+			of an IGEN generator. */
+			read_records(sf2.pdta.pgen, hydra.pgen, 4);
+			//The inst sub-chunk is a required sub-chunk listing all
+			//instruments within the SoundFont compatible file.
+			read_records(sf2.pdta.inst, hydra.inst, 22);
+			for(auto& instrument : hydra.inst)
+			{
+				//null-terminate instrument name
+				//you think it's funny not to terminate a string, soundfont editing software?
+				instrument.achInstName[19] = 0;
+			}
+			//The IBAG sub-chunk is a required sub-chunk listing all
+			//instrument zones within the SoundFont compatible file. 
+			//
+			/*The first zone in a given instrument is located at that
+			instruments wInstBagNdx. The number of zones in the instrument is
+			determined by the difference between the next instruments wInstBagNdx
+			and the current wInstBagNdx.
+
+			If an instrument has more than one zone, the first zone may be a global zone.
+			A global zone is determined by the fact that the last generator in the list
+			is not a sampleID generator. All generator lists must contain at least
+			one generator with one exception - if a global zone exists for which there
+			are no generators but only modulators. The modulator lists can contain
+			zero or more modulators. */
+			read_records(sf2.pdta.ibag, hydra.ibag, 4);
+			//The IMOD sub-chunk is a required sub-chunk listing all
+			//instrument zone modulators within the SoundFont compatible file.
+			//
+			/*The zones wInstModNdx points to the first modulator for that zone,
+			and the number of modulators present for a zone is determined
+			by the difference between the next higher zones wInstModNdx
+			and the current zones wModNdx.
+			A difference of zero indicates there are no modulators in this zone.
+
+			Modulators in the IMOD sub-chunk are absolute.
+			This means that an IMOD modulator replaces, rather than adds to, a
+			default modulator. However the effect of a modulator on a generator
+			is additive, IE the output of a modulator adds to a generator value. */
+			read_records(sf2.pdta.imod, hydra.imod, 10);
+			//The IGEN chunk is a required chunk containing a list of zone generators
+			//for each instrument zone within the SoundFont compatible file.
+			//
+			/*The zones wInstGenNdx points to the first generator for that zone.
+			Unless the zone is a global zone, the last generator in the list is
+			a sampleID generator, whose value is a pointer to the sample associated
+			with that zone. If a key range generator exists for the zone, it is always
+			the first generator in the list for that zone. If a velocity range generator
+			exists for the zone, it will only be preceded by a key range generator.
+			If any generators follow a sampleID generator, they will be ignored.
+
+			Generators in the IGEN sub-chunk are absolute in nature.
+			This means that an IGEN generator replaces, rather than adds to,
+			the default value for the generator. */
+			read_records(sf2.pdta.igen, hydra.igen, 4);
+			//The SHDR chunk is a required sub-chunk listing all samples within the smpl
+			//sub-chunk and any referenced ROM samples.
+			//
+			/*The values of dwStart, dwEnd, dwStartloop, and dwEndloop must all be within
+			the range of the sample data field included in the SoundFont compatible bank
+			or referenced in the sound ROM. Also, to allow a variety of hardware platforms
+			to be able to reproduce the data, the samples have a minimum length of 48 data
+			points, a minimum loop size of 32 data points and a minimum of 8 valid points
+			prior to dwStartloop and after dwEndloop.
+			Thus dwStart must be less than dwStartloop-7, dwStartloop must be less than
+			dwEndloop-31, and dwEndloop must be less than dwEnd-7.
+			If these constraints are not met, the sound may optionally not be played
+			if the hardware cannot support artifact-free playback for the parameters given.
+
+			Sample rate values of greater than 50000 or less than 400 may not be reproducible
+			by some hardware platforms and should be avoided. A value of zero is illegal.
+			If an illegal or impractical value is encountered, the nearest practical value
+			should be used.
+
+			If sfSampleType indicates a mono sample, then wSampleLink is undefined and
+			its value should be conventionally zero, but will be ignored regardless of value.
+			If sfSampleType indicates a left or right sample, then wSampleLink is the sample
+			header index of the associated right or left stereo sample respectively.
+			Both samples should be played entirely syncrhonously, with their pitch controlled
+			by the right samples generators. All non-pitch generators should apply as normal;
+			in particular the panning of the individual samples to left and right should
+			be accomplished via the pan generator.
+			Left-right pairs should always be found within the same instrument.
+			Note also that no instrument should be designed in which it is possible to
+			activate more than one instance of a particular stereo pair. The linked sample
+			type is not currently fully defined in the SoundFont 2 specification,
+			but will ultimately support a circularly linked list of samples using 
+			wSampleLink. Note that this enumeration is two bytes in length. */
+			src = get_chunk_data(sf2.pdta.shdr);
+			hydra.shdr.resize(sf2.pdta.shdr->size/46);
+			for(auto& sample : hydra.shdr)
+			{
+				read_field(sample.achSampleName);
+				//null-terminate sample name
+				//unfortunately, some soundfonts don't do that!
+				sample.achSampleName[19] = 0;
+				read_field(sample.dwStart);
+				read_field(sample.dwEnd);
+				read_field(sample.dwStartloop);
+				read_field(sample.dwEndloop);
+				read_field(sample.dwSampleRate);
+				read_field(sample.byOriginalKey);
+				read_field(sample.chCorrection);
+				read_field(sample.wSampleLink);
+				WORD sample_type;
+				read_field(sample_type);
+				sample.sfSampleType = static_cast<SFSampleLink>(sample_type);
+			}
+
+#undef read_zstr
+#undef read_versiontag
+#undef read_field
+#undef read_records
+
+			//save stream
+			stream = s;
+
+			//Translate HYDRA structure data
+			//========================================================================
+			SF2_DEBUG_OUTPUT("Parsing HYDRA data...\n");
+			SF2_DEBUG_OUTPUT("Scanning banks...\n");
+			//Scan banks
+			for(size_t i = 0; i < hydra.phdr.size(); ++i)
+			{
+				//check for already listed ones
+				for(auto& b : banks)
+				{
+					if(b->num == hydra.phdr[i].wBank)
+					{
+						//already exists, skip
+						goto next_preset;
+					}
+				}
+				//not listed yet, add to the list
+				banks.emplace_back(std::make_unique<Bank>());
+				banks.back()->num = hydra.phdr[i].wBank;
+			next_preset:{}
+			}
+
+			//Load samples
+			SF2_DEBUG_OUTPUT("Loading samples...\n");
+			samples.resize(hydra.shdr.size()-1);
+			for(auto& sample : samples) sample = std::make_unique<Sample>();
+
+			{
+				size_t i = 0;
+				for(auto sample = &hydra.shdr[i]; sample != &hydra.shdr.back(); ++i, sample = &hydra.shdr[i])
+				{
+					samples[i]->name = (const char*)sample->achSampleName;
+					samples[i]->sample_rate = sample->dwSampleRate;
+					//need to subtract stream offset from loop points
+					//to get them to be local to the data buffer pointer
+					samples[i]->loop_start = sample->dwStartloop - sample->dwStart;
+					samples[i]->loop_end = sample->dwEndloop - sample->dwStart;
+					samples[i]->original_key = sample->byOriginalKey;
+					samples[i]->correction = sample->chCorrection;
+					samples[i]->sample_type = sample->sfSampleType;
+					//SF3 samples compressed with Ogg Vorbis have start and end in bytes of smpl
+					//and loop points relative to the sample
+					bool encoded = samples[i]->sample_type & SFSampleLink::compressedSample;
+					if(encoded)
+					{
+						samples[i]->sample_type = static_cast<SFSampleLink>(samples[i]->sample_type & ~SFSampleLink::compressedSample);
+						samples[i]->loop_start = sample->dwStartloop;
+						samples[i]->loop_end = sample->dwEndloop;
+					}
+					//check sfSampleType and try to fix
+					if(!CheckSampleLinkType(samples[i]->sample_type))
+					{
+						samples[i]->sample_type = SFSampleLink::monoSample;
+					}
+					if(samples[i]->sample_type != SFSampleLink::monoSample)
+						samples[i]->linked_sample = samples[sample->wSampleLink].get();
+					else samples[i]->linked_sample = nullptr;
+					//Don't load sample data but prepare it for on demand streaming
+					//or manually requested loading
+					samples[i]->data_stream_offset = sample->dwStart;
+					samples[i]->size = sample->dwEnd/* + 46*/ - sample->dwStart;
+					samples[i]->data = nullptr;
+					if(encoded)
+					{
+						//the length is only known from the stream itself
+						samples[i]->encoded_size = samples[i]->size;
+						samples[i]->size = encoded_frames(sample->dwStart, samples[i]->encoded_size);
+					}
+
+					//test load
+					//samples[i]->load_data(*this, s);
+				}
+			}
+
+			//translating an item is cheap, a thread only pays off with enough of them
+			auto translation_threads = [&](size_t count)->unsigned
+			{
+				unsigned available = threads?threads:std::thread::hardware_concurrency();
+				return (unsigned)std::max<size_t>(std::min<size_t>(available, count/64), 1);
+			};
+
+			//Load instruments
+			SF2_DEBUG_OUTPUT("Loading instruments...\n");
+			instruments.resize(hydra.inst.size()-1);
+			//all zones fit into a single block
+			zone_arena.reserve(
+				sizeof(Instrument::Zone)*hydra.ibag.size()+alignof(Instrument::Zone)+
+				sizeof(Preset::Zone)*hydra.pbag.size()+alignof(Preset::Zone)
+			);
+			//zones are collected here in parallel, then moved to the arena in order,
+			//so that the layout doesn't depend on the order of translation
+			std::vector<std::vector<Instrument::Zone>> instrument_splits(instruments.size());
+			{
+				auto translate = [&](size_t i)
+				{
+					auto inst = &hydra.inst[i];
+					auto& splits = instrument_splits[i];
+					instruments[i] = std::make_unique<Instrument>();
+					instruments[i]->name = (const char*)hydra.inst[i].achInstName;
+					{
+						std::optional<Instrument::Zone> global_zone;
+
+						size_t j = inst->wInstBagNdx;
+						//first zone of the next instrument marks the end of the current
+						//instrument zone list
+						auto iz_end = &hydra.ibag[hydra.inst[i+1].wInstBagNdx];
+						//for each instrument zone
+						for(auto iz = &hydra.ibag[j]; iz != iz_end; ++j, iz = &hydra.ibag[j])
+						{							
+							Instrument::Zone split;
+							//Only instrument generators have default values
+							split.modEnv.SetToDefault();
+							split.volEnv.SetToDefault();
+
+							/*Points below (until noted) apply to Value Generators ONLY. */
+							/*
+							A generator in a global instrument zone that is identical to a default
+							generator supersedes or replaces the default generator. 
+							*/
+							if(global_zone)
+							{
+								//split.CopyValueGenerators(*global_zone);
+								split = *global_zone;
+							}
+
+							size_t k = iz->wInstGenNdx;
+							auto igen_end = &hydra.igen[hydra.ibag[j+1].wInstGenNdx];
+							//for each generator
+							for(auto ig = &hydra.igen[k]; ig != igen_end; ++k, ig = &hydra.igen[k])
+							{
+								/*
+								A generator in a local instrument zone that is identical to a default
+								generator or to a generator in a global instrument zone supersedes or
+								replaces that generator. 
+								*/
+								switch(ig->sfGenOper.enumeration)
+								{
+								case SFGenerator::GenType::sampleID:
+								{
+									split.sample =	samples[ig->genAmount.wAmount].get();
+									break;
+								}
+								case SFGenerator::GenType::startAddrsOffset:
+								{
+									split.start_offset += ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::startAddrsCoarseOffset:
+								{
+									split.start_offset += ig->genAmount.shAmount*32768;
+									break;
+								}
+								case SFGenerator::GenType::endAddrsOffset:
+								{
+									split.end_offset += ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::endAddrsCoarseOffset:
+								{
+									split.end_offset += ig->genAmount.shAmount*32768;
+									break;
+								}
+								case SFGenerator::GenType::startloopAddrsOffset:
+								{
+									split.loop_start_offset += ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::startloopAddrsCoarseOffset:
+								{
+									split.loop_start_offset += ig->genAmount.shAmount*32768;
+									break;
+								}
+								case SFGenerator::GenType::endloopAddrsOffset:
+								{
+									split.loop_end_offset += ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::endloopAddrsCoarseOffset:
+								{
+									split.loop_end_offset += ig->genAmount.shAmount*32768;
+									break;
+								}
+								case SFGenerator::GenType::modLfoToPitch:
+								{
+									split.modLFO_to_pitch = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::vibLfoToPitch:
+								{
+									split.vibLFO_to_pitch = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::modEnvToPitch:
+								{
+									split.modEnv_to_pitch = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::initialFilterFc:
+								{
+									split.filter_freq = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::initialFilterQ:
+								{
+									split.filter_q = ig->genAmount.shAmount / 10.0f;
+									break;
+								}
+								case SFGenerator::GenType::modLfoToFilterFc:
+								{
+									split.modLFO_to_filter_fc = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::modEnvToFilterFc:
+								{
+									split.modEnv_to_filter_fc = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::modLfoToVolume:
+								{
+									split.modLFO_to_volume = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::chorusEffectsSend:
+								{
+									split.chorus_send = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::reverbEffectsSend:
+								{
+									split.reverb_send = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::pan:
+								{
+									split.pan = float(ig->genAmount.shAmount)/1000.0f;
+									break;
+								}
+								case SFGenerator::GenType::delayModLFO:
+								{
+									split.modLFO.delay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::freqModLFO:
+								{
+									split.modLFO.frequency = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::delayVibLFO:
+								{
+									split.vibLFO.delay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::freqVibLFO:
+								{
+									split.vibLFO.frequency = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::delayModEnv:
+								{
+									split.modEnv.delay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::attackModEnv:
+								{
+									split.modEnv.attack = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::holdModEnv:
+								{
+									split.modEnv.hold = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::decayModEnv:
+								{
+									split.modEnv.decay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::sustainModEnv:
+								{
+									split.modEnv.sustain = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::releaseModEnv:
+								{
+									split.modEnv.release = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::keynumToModEnvHold:
+								{
+									split.modEnv.keynumToHold = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::keynumToModEnvDecay:
+								{
+									split.modEnv.keynumToDecay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::delayVolEnv:
+								{
+									split.volEnv.delay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::attackVolEnv:
+								{
+									split.volEnv.attack = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::holdVolEnv:
+								{
+									split.volEnv.hold = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::decayVolEnv:
+								{
+									split.volEnv.decay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::sustainVolEnv:
+								{
+									split.volEnv.sustain = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::releaseVolEnv:
+								{
+									split.volEnv.release = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::keynumToVolEnvHold:
+								{
+									split.volEnv.keynumToHold = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::keynumToVolEnvDecay:
+								{
+									split.volEnv.keynumToDecay = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::keyRange:
+								{
+									split.key_low = ig->genAmount.ranges.byLo;
+									split.key_high = ig->genAmount.ranges.byHi;
+									break;
+								}
+								case SFGenerator::GenType::velRange:
+								{
+									split.vel_low = ig->genAmount.ranges.byLo;
+									split.vel_high = ig->genAmount.ranges.byHi;
+									break;
+								}
+								case SFGenerator::GenType::keynum:
+								{
+									split.keynum = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::velocity:
+								{
+									split.velocity = ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::initialAttenuation:
+								{
+									split.attenuation = float(ig->genAmount.shAmount)/10.0f;
+									break;
+								}
+								case SFGenerator::GenType::coarseTune:
+								{
+									split.tune += ig->genAmount.shAmount*100;
+									break;
+								}
+								case SFGenerator::GenType::fineTune:
+								{
+									split.tune += ig->genAmount.shAmount;
+									break;
+								}
+								case SFGenerator::GenType::sampleModes:
+								{
+									switch(ig->genAmount.wAmount & 3)
+									{
+									case 0: split.loop_mode = LoopMode::None; break;
+									case 1: split.loop_mode = LoopMode::Continuous; break;
+									case 2: split.loop_mode = LoopMode::None; break;
+									case 3: split.loop_mode = LoopMode::Sustain; break;
+									}
+									break;
+								}
+								case SFGenerator::GenType::scaleTuning:
+								{
+									//[0;1] range
+									split.scale_tuning = float(ig->genAmount.shAmount)/100.0f;
+									break;
+								}
+								case SFGenerator::GenType::exclusiveClass:
+								{
+									split.exclusive_class = ig->genAmount.wAmount;
+									break;
+								}
+								case SFGenerator::GenType::overridingRootKey:
+								{
+									split.root_key = ig->genAmount.shAmount;
+									break;
+								}
+								}
+							}
+							//if last generator is not a sampleID generator
+							if(split.sample == nullptr)
+							{
+								//also must be more than one zone for a global one to exist
+								//and it also must be first zone in the list
+								if(j == inst->wInstBagNdx && (hydra.inst[i+1].wInstBagNdx - inst->wInstBagNdx) > 1)
+								{
+									//global zone detected
+									//instruments[i]->global_zone = split;
+									global_zone = split;
+								} else goto discard_zone;
+							} else splits.push_back(split);
+
+							continue;
+						discard_zone:
+							{
+								if(!splits.empty()) splits.pop_back();
+							}
+							global_zone.reset();
+						}
+					}
+				};
+				parallel_for(instruments.size(), translation_threads(instruments.size()), translate);
+				for(size_t i = 0; i < instruments.size(); ++i)
+					instruments[i]->splits = zone_arena.copy<Instrument::Zone>(instrument_splits[i].begin(), instrument_splits[i].end());
+			}
+
+			//Load presets
+			SF2_DEBUG_OUTPUT("Loading presets...\n");
+			//zones are collected here in parallel, then moved to the arena in order
+			size_t preset_count = hydra.phdr.size()-1;
+			std::vector<std::unique_ptr<Preset>> presets(preset_count);
+			std::vector<std::vector<Preset::Zone>> preset_layers(preset_count);
+			parallel_for(preset_count, translation_threads(preset_count), [&](size_t i)
+			{
+				auto& p = presets[i];
+				auto& layers = preset_layers[i];
+				p = std::make_unique<Preset>();
+				p->name = (const char*)hydra.phdr[i].achPresetName;
+				p->num = hydra.phdr[i].wPreset;
+
+				//a global zone is a first zone and may only exist if
+				//there is more than one zone for a given preset
+				//Preset::Zone* global_zone = nullptr;
+				auto global_zone_begin = hydra.pgen.begin();
+				auto global_zone_end = global_zone_begin;
+
+				if((hydra.phdr[i+1].wPresetBagNdx - hydra.phdr[i].wPresetBagNdx) > 1)
+				{
+					//Get first zone of the preset
+					auto zone = &hydra.pbag[hydra.phdr[i].wPresetBagNdx];
+					//Get first generator of the next zone to acts as an end of the current list.
+					//For this to work, there exists a dummy terminator zone in the end of the
+					//PGEN chunk just so we can iterate all of them using this method.
+					auto pgen_end = hydra.pgen.begin()+hydra.pbag[hydra.phdr[i].wPresetBagNdx+1].wGenNdx;
+					//if zone isn't empty
+					if(pgen_end != hydra.pgen.begin())
+					{
+						//if last generator isn't an instrument generator
+						if((pgen_end - 1)->sfGenOper != SFGenerator::GenType::instrument)
+						{
+							//store global zone iterators
+							global_zone_begin = hydra.pgen.begin()+zone->wGenNdx;
+							global_zone_end = pgen_end;
+						}
+					}
+				}
+
+				{
+					size_t j = hydra.phdr[i].wPresetBagNdx;
+					//first zone of the next preset marks the end of the current
+					//preset zone list
+					auto pz_end = &hydra.pbag[hydra.phdr[i+1].wPresetBagNdx];
+					//for each preset zone
+					for(auto pz = &hydra.pbag[j]; pz != pz_end; ++j, pz = &hydra.pbag[j])
+					{
+						//check if zone isn't empty
+						if(hydra.pgen.begin()+pz->wGenNdx == hydra.pgen.begin()+hydra.pbag[j+1].wGenNdx)
+						{
+							//discard zone
+							continue;
+						}
+						//check if last generator isn't an instrument generator
+						if((hydra.pgen.begin()+hydra.pbag[j+1].wGenNdx - 1)->sfGenOper != SFGenerator::GenType::instrument)
+						{
+							//discard zone
+							continue;
+						}
+
+						/*Points below (until noted) apply to Value Generators ONLY. */
+						/*
+						A generator in a local preset zone that is identical to a generator in
+						a global preset zone supersedes or replaces that generator in the global
+						preset zone. That generator then has its effects added to the destination-summing
+						node of all zones in the given instrument.
+						*/
+
+						std::vector<HYDRA::sfGenList*> generators;
+						//copy zone generators and supersede identical globals with locals
+						{							
+							//collect all generators from the global zone
+							for(auto pg = global_zone_begin; pg != global_zone_end; ++pg)
+							{
+								generators.push_back(&*pg);
+							}
+
+							//for each generator of the current preset zone
+							for(auto pg = hydra.pgen.begin()+pz->wGenNdx; pg != hydra.pgen.begin()+hydra.pbag[j+1].wGenNdx; ++pg)
+							{
+								//try to find identical generator
+								for(auto gen = generators.begin(); gen != generators.end(); ++gen)
+								{
+									if((*gen)->sfGenOper == pg->sfGenOper)
+									{
+										//replace global generator with local
+										*gen = &*pg;
+										goto pg_next_generator;
+									}
+								}
+								//generator is unique, has its effect added
+								generators.push_back(&*pg);
+							pg_next_generator:{}
+							}
+						}
+						//Get the zone instrument
+						//Instrument* instrument = instruments[(*(hydra.pgen.begin()+hydra.pbag[j+1].wGenNdx - 1))->genAmount.wAmount];
+						//Initialize preset zone with instrument's zone
+						//*layer = instrument->splits;
+						//TODO: possibly precompute (combine with preset zones) splits for each preset
+
+						//check if no generators exist for this zone
+						if(generators.empty()) continue;
+
+						Preset::Zone layer;
+
+						//for each generator
+						for(auto pg = generators.begin(); pg != generators.end(); ++pg)
+						{
+							switch((*pg)->sfGenOper.enumeration)
+							{
+							case SFGenerator::GenType::instrument:
+							{
+								layer.instrument = instruments[(*pg)->genAmount.wAmount].get();
+								break;
+							}
+							case SFGenerator::GenType::modLfoToPitch:
+							{
+								layer.modLFO_to_pitch = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::vibLfoToPitch:
+							{
+								layer.vibLFO_to_pitch = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::modEnvToPitch:
+							{
+								layer.modEnv_to_pitch = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::initialFilterFc:
+							{
+								layer.filter_freq = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::initialFilterQ:
+							{
+								layer.filter_q = (*pg)->genAmount.shAmount / 10.0f;
+								break;
+							}
+							case SFGenerator::GenType::modLfoToFilterFc:
+							{
+								layer.modLFO_to_filter_fc = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::modEnvToFilterFc:
+							{
+								layer.modEnv_to_filter_fc = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::modLfoToVolume:
+							{
+								layer.modLFO_to_volume = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::chorusEffectsSend:
+							{
+								layer.chorus_send = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::reverbEffectsSend:
+							{
+								layer.reverb_send = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::pan:
+							{
+								layer.pan = float((*pg)->genAmount.shAmount)/1000.0f;
+								break;
+							}
+							case SFGenerator::GenType::delayModLFO:
+							{
+								layer.modLFO.delay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::freqModLFO:
+							{
+								layer.modLFO.frequency = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::delayVibLFO:
+							{
+								layer.vibLFO.delay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::freqVibLFO:
+							{
+								layer.vibLFO.frequency = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::delayModEnv:
+							{
+								layer.modEnv.delay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::attackModEnv:
+							{
+								layer.modEnv.attack = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::holdModEnv:
+							{
+								layer.modEnv.hold = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::decayModEnv:
+							{
+								layer.modEnv.decay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::sustainModEnv:
+							{
+								layer.modEnv.sustain = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::releaseModEnv:
+							{
+								layer.modEnv.release = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::keynumToModEnvHold:
+							{
+								layer.modEnv.keynumToHold = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::keynumToModEnvDecay:
+							{
+								layer.modEnv.keynumToDecay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::delayVolEnv:
+							{
+								layer.volEnv.delay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::attackVolEnv:
+							{
+								layer.volEnv.attack = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::holdVolEnv:
+							{
+								layer.volEnv.hold = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::decayVolEnv:
+							{
+								layer.volEnv.decay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::sustainVolEnv:
+							{
+								layer.volEnv.sustain = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::releaseVolEnv:
+							{
+								layer.volEnv.release = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::keynumToVolEnvHold:
+							{
+								layer.volEnv.keynumToHold = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::keynumToVolEnvDecay:
+							{
+								layer.volEnv.keynumToDecay = (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::keyRange:
+							{
+								layer.key_low = (*pg)->genAmount.ranges.byLo;
+								layer.key_high = (*pg)->genAmount.ranges.byHi;
+								break;
+							}
+							case SFGenerator::GenType::velRange:
+							{
+								layer.vel_low = (*pg)->genAmount.ranges.byLo;
+								layer.vel_high = (*pg)->genAmount.ranges.byHi;
+								break;
+							}
+							case SFGenerator::GenType::initialAttenuation:
+							{
+								layer.attenuation = float((*pg)->genAmount.shAmount)/10.0f;
+								break;
+							}
+							case SFGenerator::GenType::coarseTune:
+							{
+								layer.tune += (*pg)->genAmount.shAmount*100;
+								break;
+							}
+							case SFGenerator::GenType::fineTune:
+							{
+								layer.tune += (*pg)->genAmount.shAmount;
+								break;
+							}
+							case SFGenerator::GenType::scaleTuning:
+							{
+								//[0;1] range
+								layer.scale_tuning = float((*pg)->genAmount.shAmount)/100.0f;
+								break;
+							}
+							}
+						}
+						//add layer to the list
+						layers.push_back(layer);
+					}
+				}
+			});
+			for(size_t i = 0; i < preset_count; ++i)
+			{
+				auto& p = presets[i];
+				p->layers = zone_arena.copy<Preset::Zone>(preset_layers[i].begin(), preset_layers[i].end());
+
+				//find bank
+				for(auto& bank : banks)
+				{
+					if(bank->num == hydra.phdr[i].wBank)
+					{
+						//add preset to the bank
+						bank->presets.emplace_back(std::move(p));
+						break;
+					}
+				}
+			}
+
+
+			SF2_DEBUG_OUTPUT("Sorting banks...\n");
+			//Sort banks
+			std::sort(
+				banks.begin(),
+				banks.end(),
+				[](auto&& a, auto&& b) { return a->num < b->num; });
+			SF2_DEBUG_OUTPUT("Sorting presets...\n");
+			//Sort presets
+			for(auto& bank : banks)
+			{
+				std::sort(
+					bank->presets.begin(),
+					bank->presets.end(),
+					[](auto&& a, auto&& b) { return a->num < b->num; });
+			}
+
+		}
+
+		//Catalog scan
+		//========================================================================
+		//Summary of a soundfont, made by reading only INFO, PHDR and SHDR chunks
+		struct Catalog
+		{
+			sfVersionTag ifil = {};
+			sfVersionTag iver = {};
+			std::string szSoundEngine;
+			std::string szROM;
+			std::string szName;
+			std::string szDate;
+			std::string szProduct;
+			std::string szCreator;
+			std::string szCopyright;
+			std::string szComment;
+			std::string szTools;
+
+			struct Entry
+			{
+				//MIDI Bank Number
+				uint16_t bank;
+				//MIDI Preset Number
+				uint16_t num;
+				std::string name;
+			};
+			//sorted by bank and preset number
+			std::vector<Entry> presets;
+			size_t sample_count = 0;
+			//size of sample data of all non-ROM samples, sm24 data included,
+			//compressed samples of SF3 banks count with their encoded size
+			uint64_t sample_bytes = 0;
+		};
+
+		//Reads the catalog of a soundfont without translating presets and instruments
+		//or touching sample data, returns false if the file isn't a SoundFont2
+		static bool Scan(RIFF::stream& s, Catalog& catalog)
+		{
+			RIFF::RIFF riff;
+			//chunk tree only, the few chunks needed are read below
+			riff.parse(s, RIFF::RIFF::load_policy::none());
+			return Scan(riff, s, catalog);
+		}
+
+		static bool Scan(RIFF::RIFF& riff, RIFF::stream& s, Catalog& catalog)
+		{
+			RIFF_SoundFont2 sf2(&riff);
+			if(sf2.structurally_unsound) return false;
+
+			std::vector<BYTE> buffer;
+			auto get_chunk_data = [&](RIFF::RIFF::chunk* c, size_t max_size = SIZE_MAX)->const BYTE*
+			{
+				size_t size = std::min<size_t>(c->size, max_size);
+				if(auto data = c->get_data())
+					return data;
+				if(auto data = s.view(c->data_offset, size))
+					return static_cast<const BYTE*>(data);
+				buffer.assign(size, 0);
+				if(s.is_seekable())
+				{
+					s.setpos(c->data_offset);
+					s.read(buffer.data(), size);
+				}
+				return buffer.data();
+			};
+			auto read_zstr = [&](RIFF::RIFF::chunk* c, std::string& str, size_t max_len)
+			{
+				if(!c) return;
+				size_t size = std::min<size_t>(c->size, max_len);
+				auto data = (const char*)get_chunk_data(c, size);
+				str.assign(data, std::find(data, data + size, 0));
+			};
+			auto read_versiontag = [&](RIFF::RIFF::chunk* c, sfVersionTag& tag)
+			{
+				if(!c || c->size < 4) return;
+				auto data = get_chunk_data(c, 4);
+				std::memcpy(&tag.wMajor, data, sizeof(WORD));
+				std::memcpy(&tag.wMinor, data + sizeof(WORD), sizeof(WORD));
+			};
+
+			read_versiontag(sf2.INFO.ifil, catalog.ifil);
+			read_zstr(sf2.INFO.isng, catalog.szSoundEngine, 256);
+			read_zstr(sf2.INFO.INAM, catalog.szName, 256);
+			read_zstr(sf2.INFO.irom, catalog.szROM, 256);
+			read_versiontag(sf2.INFO.iver, catalog.iver);
+			read_zstr(sf2.INFO.ICRD, catalog.szDate, 256);
+			read_zstr(sf2.INFO.IENG, catalog.szCreator, 256);
+			read_zstr(sf2.INFO.IPRD, catalog.szProduct, 256);
+			read_zstr(sf2.INFO.ICOP, catalog.szCopyright, 256);
+			read_zstr(sf2.INFO.ICMT, catalog.szComment, 65536);
+			read_zstr(sf2.INFO.ISFT, catalog.szTools, 256);
+
+			//last records are terminators
+			catalog.presets.clear();
+			size_t preset_count = sf2.pdta.phdr->size/38;
+			if(preset_count > 1)
+			{
+				auto src = get_chunk_data(sf2.pdta.phdr);
+				catalog.presets.resize(preset_count - 1);
+				for(auto& entry : catalog.presets)
+				{
+					//achPresetName, wPreset, wBank
+					auto name = (const char*)src;
+					entry.name.assign(name, std::find(name, name + 20, 0));
+					std::memcpy(&entry.num, src + 20, sizeof(WORD));
+					std::memcpy(&entry.bank, src + 22, sizeof(WORD));
+					src += 38;
+				}
+				std::sort(
+					catalog.presets.begin(),
+					catalog.presets.end(),
+					[](auto&& a, auto&& b) { return (a.bank != b.bank)?(a.bank < b.bank):(a.num < b.num); });
+			}
+
+			catalog.sample_count = 0;
+			catalog.sample_bytes = 0;
+			size_t sample_count = sf2.pdta.shdr->size/46;
+			if(sample_count > 1)
+			{
+				size_t frame_size = sf2.sdta.sm24?3:2;
+				auto src = get_chunk_data(sf2.pdta.shdr);
+				for(size_t i = 0; i < sample_count - 1; ++i, src += 46)
+				{
+					//dwStart, dwEnd, sfSampleType
+					DWORD start, end;
+					WORD type;
+					std::memcpy(&start, src + 20, sizeof(DWORD));
+					std::memcpy(&end, src + 24, sizeof(DWORD));
+					std::memcpy(&type, src + 44, sizeof(WORD));
+					++catalog.sample_count;
+					//offsets of compressed samples are in bytes
+					bool encoded = type & SFSampleLink::compressedSample;
+					if(IsSampleROM((SFSampleLink)(type & ~SFSampleLink::compressedSample)) || end <= start) continue;
+					catalog.sample_bytes += uint64_t(end - start) * (encoded?1:frame_size);
+				}
+			}
+			return true;
+		}
+
+		//Precompiled bank cache
+		//========================================================================
+		//Translated banks, presets, instruments and converted sample data
+		//are stored the way they are in memory, pointers replaced by indices.
+		//Sections are aligned, so a mapped cache file is used in place
+		//and sample data needs neither reading nor conversion.
+		struct CacheString
+		{
+			uint32_t offset = 0;
+			uint32_t size = 0;
+		};
+		struct CacheHeader
+		{
+			char magic[8];
+			uint32_t version;
+			//byte order and layout of structures stored as is,
+			//cache is rejected if they don't match the program
+			uint32_t byte_order;
+			uint32_t inst_zone_size;
+			uint32_t preset_zone_size;
+			uint32_t sample_format;
+			uint32_t sample_count;
+			uint32_t instrument_count;
+			uint32_t inst_zone_count;
+			uint32_t preset_count;
+			uint32_t preset_zone_count;
+			sfVersionTag ifil;
+			sfVersionTag iver;
+			//identity of the source file
+			CacheString source;
+			//szSoundEngine, szName, szROM, szDate, szCreator,
+			//szProduct, szCopyright, szComment, szTools
+			CacheString info[9];
+			uint64_t strings_offset;
+			uint64_t strings_size;
+			uint64_t samples_offset;
+			uint64_t instruments_offset;
+			uint64_t inst_zones_offset;
+			uint64_t presets_offset;
+			uint64_t preset_zones_offset;
+			uint64_t data_offset;
+			uint64_t data_size;
+			//covers the header with checksums zeroed and everything before data_offset
+			uint64_t meta_checksum;
+			//covers [data_offset, data_offset+data_size)
+			uint64_t data_checksum;
+		};
+		struct CacheSample
+		{
+			CacheString name;
+			uint32_t loop_start;
+			uint32_t loop_end;
+			uint32_t sample_rate;
+			uint8_t original_key;
+			int8_t correction;
+			uint16_t sample_type;
+			//index of the linked sample, UINT32_MAX if there's none
+			uint32_t linked_sample;
+			uint32_t data_stream_offset;
+			uint32_t size;
+			//relative to data_offset
+			uint64_t data;
+		};
+		struct CacheInstrument
+		{
+			CacheString name;
+			uint32_t first_zone;
+			uint32_t zone_count;
+		};
+		struct CachePreset
+		{
+			CacheString name;
+			uint16_t num;
+			uint16_t bank;
+			uint32_t first_zone;
+			uint32_t zone_count;
+		};
+		//checksum of the header continues into the following data word by word
+		static_assert(sizeof(CacheHeader) % 8 == 0, "header size must be a multiple of 8");
+		static constexpr uint32_t cache_version = 1;
+		static constexpr uint32_t cache_byte_order = 0x01020304;
+
+		//FNV-1a over 64 bit words
+		static uint64_t cache_checksum(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+		{
+			auto bytes = static_cast<const uint8_t*>(data);
+			size_t i = 0;
+			for(; i + 8 <= size; i += 8)
+			{
+				uint64_t word;
+				std::memcpy(&word, bytes + i, sizeof(word));
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+			for(; i < size; ++i)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			return hash;
+		}
+
+		//Writes translated data and all samples converted to "sample_format",
+		//samples are read from the stream if they aren't fully loaded,
+		//fails for Compressed format, the cache stores frames of fixed size
+		bool SaveCache(const char* path)
+		{
+			if(sample_format == SampleFormat::Compressed) return false;
+			static_assert(std::is_trivially_copyable<Instrument::Zone>::value, "zones are stored as is");
+			static_assert(std::is_trivially_copyable<Preset::Zone>::value, "zones are stored as is");
+			auto align = [](uint64_t value, uint64_t alignment){ return (value + alignment - 1) / alignment * alignment; };
+
+			std::string strings;
+			auto add_string = [&](const std::string& str)
+			{
+				CacheString result;
+				result.offset = (uint32_t)strings.size();
+				result.size = (uint32_t)str.size();
+				strings += str;
+				return result;
+			};
+			//pointers are stored as indices, looked up once rather than searched for each zone
+			std::unordered_map<const Sample*, uint32_t> sample_indices;
+			for(size_t i = 0; i < samples.size(); ++i)
+				sample_indices.emplace(samples[i].get(), (uint32_t)i);
+			std::unordered_map<const Instrument*, uint32_t> instrument_indices;
+			for(size_t i = 0; i < instruments.size(); ++i)
+				instrument_indices.emplace(instruments[i].get(), (uint32_t)i);
+			auto sample_index = [&](const Sample* sample)
+			{
+				auto it = sample_indices.find(sample);
+				return (it != sample_indices.end())?it->second:UINT32_MAX;
+			};
+
+			CacheHeader header = {};
+			std::memcpy(header.magic, "SF2HPPBC", sizeof(header.magic));
+			header.version = cache_version;
+			header.byte_order = cache_byte_order;
+			header.inst_zone_size = sizeof(Instrument::Zone);
+			header.preset_zone_size = sizeof(Preset::Zone);
+			header.sample_format = (uint32_t)sample_format;
+			header.ifil = ifil;
+			header.iver = iver;
+			header.source = add_string(identity);
+			const std::string* info[9] = {
+				&szSoundEngine, &szName, &szROM, &szDate, &szCreator,
+				&szProduct, &szCopyright, &szComment, &szTools
+			};
+			for(int i = 0; i < 9; ++i)
+				header.info[i] = add_string(*info[i]);
+
+			size_t frame_size = sample_format_size(sample_format);
+			std::vector<CacheSample> cache_samples(samples.size());
+			uint64_t data_size = 0;
+			for(size_t i = 0; i < samples.size(); ++i)
+			{
+				auto& sample = *samples[i];
+				auto& cs = cache_samples[i];
+				cs.name = add_string(sample.name);
+				cs.loop_start = sample.loop_start;
+				cs.loop_end = sample.loop_end;
+				cs.sample_rate = sample.sample_rate;
+				cs.original_key = sample.original_key;
+				cs.correction = sample.correction;
+				cs.sample_type = (uint16_t)sample.sample_type;
+				cs.linked_sample = sample.linked_sample?sample_index(sample.linked_sample):UINT32_MAX;
+				cs.data_stream_offset = sample.data_stream_offset;
+				cs.size = sample.size;
+				data_size = align(data_size, 64);
+				cs.data = data_size;
+				data_size += uint64_t(sample.size) * frame_size;
+			}
+
+			std::vector<CacheInstrument> cache_instruments(instruments.size());
+			std::vector<Instrument::Zone> inst_zones;
+			for(size_t i = 0; i < instruments.size(); ++i)
+			{
+				cache_instruments[i].name = add_string(instruments[i]->name);
+				cache_instruments[i].first_zone = (uint32_t)inst_zones.size();
+				cache_instruments[i].zone_count = (uint32_t)instruments[i]->splits.size();
+				for(auto& split : instruments[i]->splits)
+				{
+					inst_zones.push_back(split);
+					inst_zones.back().sample = reinterpret_cast<Sample*>(uintptr_t(sample_index(split.sample)));
+				}
+			}
+
+			std::vector<CachePreset> cache_presets;
+			std::vector<Preset::Zone> preset_zones;
+			for(auto& bank : banks)
+			{
+				for(auto& preset : bank->presets)
+				{
+					CachePreset cp;
+					cp.name = add_string(preset->name);
+					cp.num = preset->num;
+					cp.bank = bank->num;
+					cp.first_zone = (uint32_t)preset_zones.size();
+					cp.zone_count = (uint32_t)preset->layers.size();
+					cache_presets.push_back(cp);
+					for(auto& layer : preset->layers)
+					{
+						//unknown instruments get an out of range index, which is rejected on load
+						auto it = instrument_indices.find(layer.instrument);
+						size_t index = (it != instrument_indices.end())?it->second:instruments.size();
+						preset_zones.push_back(layer);
+						preset_zones.back().instrument = reinterpret_cast<Instrument*>(uintptr_t(index));
+					}
+				}
+			}
+
+			header.sample_count = (uint32_t)cache_samples.size();
+			header.instrument_count = (uint32_t)cache_instruments.size();
+			header.inst_zone_count = (uint32_t)inst_zones.size();
+			header.preset_count = (uint32_t)cache_presets.size();
+			header.preset_zone_count = (uint32_t)preset_zones.size();
+
+			//lay out metadata sections
+			std::vector<BYTE> meta;
+			auto add_section = [&](const void* data, size_t size, size_t alignment)
+			{
+				uint64_t offset = align(meta.size(), alignment);
+				meta.resize(offset + size);
+				if(size) std::memcpy(meta.data() + offset, data, size);
+				return offset;
+			};
+			meta.resize(sizeof(CacheHeader));
+			header.strings_offset = add_section(strings.data(), strings.size(), 8);
+			header.strings_size = strings.size();
+			header.samples_offset = add_section(cache_samples.data(), cache_samples.size()*sizeof(CacheSample), alignof(CacheSample));
+			header.instruments_offset = add_section(cache_instruments.data(), cache_instruments.size()*sizeof(CacheInstrument), alignof(CacheInstrument));
+			header.inst_zones_offset = add_section(inst_zones.data(), inst_zones.size()*sizeof(Instrument::Zone), 64);
+			header.presets_offset = add_section(cache_presets.data(), cache_presets.size()*sizeof(CachePreset), alignof(CachePreset));
+			header.preset_zones_offset = add_section(preset_zones.data(), preset_zones.size()*sizeof(Preset::Zone), 64);
+			//page aligned, so that sample data can be mapped
+			header.data_offset = align(meta.size(), 4096);
+			header.data_size = data_size;
+			meta.resize(header.data_offset, 0);
+
+			std::ofstream file(path, std::ios::binary);
+			if(!file) return false;
+			file.write((const char*)meta.data(), meta.size());
+
+			//write sample data
+			std::vector<BYTE> buffer;
+			uint64_t written = 0;
+			uint64_t data_checksum = cache_checksum(nullptr, 0);
+			for(size_t i = 0; i < samples.size(); ++i)
+			{
+				auto& sample = *samples[i];
+				auto& cs = cache_samples[i];
+				if(written < cs.data)
+				{
+					buffer.assign(cs.data - written, 0);
+					file.write((const char*)buffer.data(), buffer.size());
+					data_checksum = cache_checksum(buffer.data(), buffer.size(), data_checksum);
+					written = cs.data;
+				}
+				size_t bytes = size_t(sample.size) * frame_size;
+				const BYTE* data = nullptr;
+				if(sample.IsLoaded() && sample.format == sample_format && sample.resident_size == sample.size)
+					data = sample.data.get();
+				else if(stream)
+				{
+					buffer.resize(bytes);
+					sample.read_frames(*this, 0, sample.size, sample_format, buffer.data());
+					data = buffer.data();
+				}
+				else return false;
+				file.write((const char*)data, bytes);
+				data_checksum = cache_checksum(data, bytes, data_checksum);
+				written += bytes;
+			}
+
+			//checksums are zero while metadata checksum is computed
+			std::memcpy(meta.data(), &header, sizeof(header));
+			header.meta_checksum = cache_checksum(meta.data(), meta.size());
+			header.data_checksum = data_checksum;
+			file.seekp(0);
+			file.write((const char*)&header, sizeof(header));
+			return bool(file);
+		}
+
+		//Loads a cache written by SaveCache, returns nullptr if it can't be used,
+		//"source" is checked against the identity of the file the cache was made of
+		//unless it's empty, sample data is only verified if "verify_data" is set
+		//since it requires reading all of it
+		static std::unique_ptr<SoundFont2> LoadCache(const char* path, const std::string& source = std::string(), bool verify_data = false)
+		{
+			//the storage stays alive while sample data is referenced
+			std::shared_ptr<const void> storage;
+			const BYTE* base = nullptr;
+			size_t size = 0;
+		#ifdef RIFF_MMAP_SUPPORTED
+			{
+				auto file = std::make_shared<RIFF::mapped_file>();
+				if(!file->open(path)) return nullptr;
+				base = file->reader.data;
+				size = file->reader.size;
+				storage = file;
+			}
+		#else
+			{
+				std::ifstream file(path, std::ios::binary | std::ios::ate);
+				if(!file) return nullptr;
+				auto buffer = std::make_shared<std::vector<BYTE>>(size_t(file.tellg()));
+				file.seekg(0);
+				file.read((char*)buffer->data(), buffer->size());
+				if(!file) return nullptr;
+				base = buffer->data();
+				size = buffer->size();
+				storage = buffer;
+			}
+		#endif
+			if(size < sizeof(CacheHeader)) return nullptr;
+			CacheHeader header;
+			std::memcpy(&header, base, sizeof(header));
+			if(std::memcmp(header.magic, "SF2HPPBC", sizeof(header.magic)) != 0 ||
+			   header.version != cache_version ||
+			   header.byte_order != cache_byte_order ||
+			   header.inst_zone_size != sizeof(Instrument::Zone) ||
+			   header.preset_zone_size != sizeof(Preset::Zone) ||
+			   header.sample_format > (uint32_t)SampleFormat::BFloat16 ||
+			   header.data_offset > size || header.data_size > size - header.data_offset)
+				return nullptr;
+			//check metadata
+			{
+				CacheHeader zeroed = header;
+				zeroed.meta_checksum = 0;
+				zeroed.data_checksum = 0;
+				uint64_t checksum = cache_checksum(&zeroed, sizeof(zeroed));
+				checksum = cache_checksum(base + sizeof(CacheHeader), header.data_offset - sizeof(CacheHeader), checksum);
+				if(checksum != header.meta_checksum) return nullptr;
+			}
+			if(verify_data && cache_checksum(base + header.data_offset, header.data_size) != header.data_checksum)
+				return nullptr;
+
+			auto section_fits = [&](uint64_t offset, uint64_t count, size_t element_size)
+			{
+				return offset <= header.data_offset && count <= (header.data_offset - offset) / element_size;
+			};
+			if(!section_fits(header.strings_offset, header.strings_size, 1) ||
+			   !section_fits(header.samples_offset, header.sample_count, sizeof(CacheSample)) ||
+			   !section_fits(header.instruments_offset, header.instrument_count, sizeof(CacheInstrument)) ||
+			   !section_fits(header.inst_zones_offset, header.inst_zone_count, sizeof(Instrument::Zone)) ||
+			   !section_fits(header.presets_offset, header.preset_count, sizeof(CachePreset)) ||
+			   !section_fits(header.preset_zones_offset, header.preset_zone_count, sizeof(Preset::Zone)))
+				return nullptr;
+			const char* strings = (const char*)base + header.strings_offset;
+			bool strings_valid = true;
+			auto get_string = [&](const CacheString& str)
+			{
+				if(str.offset > header.strings_size || str.size > header.strings_size - str.offset)
+				{
+					strings_valid = false;
+					return std::string();
+				}
+				return std::string(strings + str.offset, str.size);
+			};
+			if(!source.empty() && get_string(header.source) != source) return nullptr;
+
+			auto sf = std::make_unique<SoundFont2>();
+			sf->ifil = header.ifil;
+			sf->iver = header.iver;
+			std::string* info[9] = {
+				&sf->szSoundEngine, &sf->szName, &sf->szROM, &sf->szDate, &sf->szCreator,
+				&sf->szProduct, &sf->szCopyright, &sf->szComment, &sf->szTools
+			};
+			for(int i = 0; i < 9; ++i)
+				*info[i] = get_string(header.info[i]);
+			sf->identity = get_string(header.source);
+			sf->sample_format = (SampleFormat)header.sample_format;
+			size_t frame_size = sample_format_size(sf->sample_format);
+
+			//samples point into the cache
+			std::vector<CacheSample> cache_samples(header.sample_count);
+			if(!cache_samples.empty())
+				std::memcpy(cache_samples.data(), base + header.samples_offset, cache_samples.size()*sizeof(CacheSample));
+			sf->samples.resize(cache_samples.size());
+			for(auto& sample : sf->samples) sample = std::make_unique<Sample>();
+			for(size_t i = 0; i < cache_samples.size(); ++i)
+			{
+				auto& cs = cache_samples[i];
+				auto& sample = *sf->samples[i];
+				if(cs.data > header.data_size || uint64_t(cs.size)*frame_size > header.data_size - cs.data ||
+				   (cs.linked_sample != UINT32_MAX && cs.linked_sample >= cache_samples.size()))
+					return nullptr;
+				sample.name = get_string(cs.name);
+				sample.loop_start = cs.loop_start;
+				sample.loop_end = cs.loop_end;
+				sample.sample_rate = cs.sample_rate;
+				sample.original_key = cs.original_key;
+				sample.correction = cs.correction;
+				sample.sample_type = (SFSampleLink)cs.sample_type;
+				sample.linked_sample = (cs.linked_sample != UINT32_MAX)?sf->samples[cs.linked_sample].get():nullptr;
+				sample.data_stream_offset = cs.data_stream_offset;
+				sample.size = cs.size;
+				sample.format = sf->sample_format;
+				sample.resident_size = cs.size;
+				sample.data = std::shared_ptr<const uint8_t[]>(storage, base + header.data_offset + cs.data);
+				sample.loaded.store(true, std::memory_order_release);
+			}
+
+			//zones are copied into the arena and their pointers fixed up
+			sf->zone_arena.reserve(
+				sizeof(Instrument::Zone)*header.inst_zone_count+alignof(Instrument::Zone)+
+				sizeof(Preset::Zone)*header.preset_zone_count+alignof(Preset::Zone)
+			);
+			auto inst_zones = sf->zone_arena.create<Instrument::Zone>(header.inst_zone_count);
+			if(!inst_zones.empty())
+				std::memcpy(inst_zones.data(), base + header.inst_zones_offset, inst_zones.size()*sizeof(Instrument::Zone));
+			for(auto& zone : inst_zones)
+			{
+				uintptr_t index = reinterpret_cast<uintptr_t>(zone.sample);
+				if(index >= sf->samples.size()) return nullptr;
+				zone.sample = sf->samples[index].get();
+			}
+			std::vector<CacheInstrument> cache_instruments(header.instrument_count);
+			if(!cache_instruments.empty())
+				std::memcpy(cache_instruments.data(), base + header.instruments_offset, cache_instruments.size()*sizeof(CacheInstrument));
+			sf->instruments.resize(cache_instruments.size());
+			for(size_t i = 0; i < cache_instruments.size(); ++i)
+			{
+				auto& ci = cache_instruments[i];
+				if(ci.first_zone > inst_zones.size() || ci.zone_count > inst_zones.size() - ci.first_zone)
+					return nullptr;
+				sf->instruments[i] = std::make_unique<Instrument>();
+				sf->instruments[i]->name = get_string(ci.name);
+				sf->instruments[i]->splits = ArenaSpan<Instrument::Zone>(inst_zones.data() + ci.first_zone, ci.zone_count);
+			}
+
+			auto preset_zones = sf->zone_arena.create<Preset::Zone>(header.preset_zone_count);
+			if(!preset_zones.empty())
+				std::memcpy(preset_zones.data(), base + header.preset_zones_offset, preset_zones.size()*sizeof(Preset::Zone));
+			for(auto& zone : preset_zones)
+			{
+				uintptr_t index = reinterpret_cast<uintptr_t>(zone.instrument);
+				if(index >= sf->instruments.size()) return nullptr;
+				zone.instrument = sf->instruments[index].get();
+			}
+			std::vector<CachePreset> cache_presets(header.preset_count);
+			if(!cache_presets.empty())
+				std::memcpy(cache_presets.data(), base + header.presets_offset, cache_presets.size()*sizeof(CachePreset));
+			//presets are stored grouped by bank, in the order of banks,
+			//a new bank starts wherever the bank number changes
+			for(auto& cp : cache_presets)
+			{
+				if(cp.first_zone > preset_zones.size() || cp.zone_count > preset_zones.size() - cp.first_zone)
+					return nullptr;
+				if(sf->banks.empty() || sf->banks.back()->num != cp.bank)
+				{
+					sf->banks.emplace_back(std::make_unique<Bank>());
+					sf->banks.back()->num = cp.bank;
+				}
+				auto p = std::make_unique<Preset>();
+				p->name = get_string(cp.name);
+				p->num = cp.num;
+				p->layers = ArenaSpan<Preset::Zone>(preset_zones.data() + cp.first_zone, cp.zone_count);
+				sf->banks.back()->presets.emplace_back(std::move(p));
+			}
+			if(!strings_valid) return nullptr;
+			return sf;
+		}
+
+		//SoundFont2 writer
+		//========================================================================
+		//Writes a SoundFont2 file with all presets
+		bool Write(const char* path)
+		{
+			return Write(path, [](WORD, WORD){ return true; });
+		}
+
+		//Writes a SoundFont2 file with presets for which select(bank, preset) returns true,
+		//only the instruments and samples they reference are written,
+		//modulators and generators are copied verbatim with indexes remapped.
+		//Works on HYDRA data, so it fails for instances loaded from a cache,
+		//fails for SF3 banks as well, their samples aren't PCM
+		template <typename F>
+		bool Write(const char* path, F&& select)
+		{
+			if(hydra.phdr.empty() || hydra.pbag.empty() || hydra.inst.empty() ||
+				hydra.ibag.empty() || hydra.shdr.empty()) return false;
+			if(!sample_data && !stream) return false;
+			for(auto& sample : samples)
+			{
+				if(sample->encoded_size) return false;
+			}
+			const size_t no_index = SIZE_MAX;
+			//the last record of each list is the terminal one
+			size_t phdr_count = hydra.phdr.size()-1;
+			size_t inst_count = hydra.inst.size()-1;
+			size_t shdr_count = hydra.shdr.size()-1;
+			auto bag_range = [](size_t first, size_t last, size_t size)
+			{
+				last = std::min(last, size);
+				return std::make_pair(std::min(first, last), last);
+			};
+
+			//select presets and collect referenced instruments
+			using GenType = SFGenerator::GenType;
+			std::vector<size_t> preset_list;
+			std::vector<size_t> inst_map(inst_count, no_index);
+			for(size_t i = 0; i < phdr_count; ++i)
+			{
+				if(!select(hydra.phdr[i].wBank, hydra.phdr[i].wPreset)) continue;
+				preset_list.push_back(i);
+				auto bags = bag_range(hydra.phdr[i].wPresetBagNdx, hydra.phdr[i+1].wPresetBagNdx, hydra.pbag.size()-1);
+				for(size_t b = bags.first; b < bags.second; ++b)
+				{
+					auto gens = bag_range(hydra.pbag[b].wGenNdx, hydra.pbag[b+1].wGenNdx, hydra.pgen.size());
+					for(size_t g = gens.first; g < gens.second; ++g)
+					{
+						auto& gen = hydra.pgen[g];
+						if(gen.sfGenOper.enumeration == GenType::instrument && gen.genAmount.wAmount < inst_count)
+							inst_map[gen.genAmount.wAmount] = 0;
+					}
+				}
+			}
+			//collect referenced samples, stereo links included
+			std::vector<size_t> sample_map(shdr_count, no_index);
+			for(size_t i = 0; i < inst_count; ++i)
+			{
+				if(inst_map[i] == no_index) continue;
+				auto bags = bag_range(hydra.inst[i].wInstBagNdx, hydra.inst[i+1].wInstBagNdx, hydra.ibag.size()-1);
+				for(size_t b = bags.first; b < bags.second; ++b)
+				{
+					auto gens = bag_range(hydra.ibag[b].wInstGenNdx, hydra.ibag[b+1].wInstGenNdx, hydra.igen.size());
+					for(size_t g = gens.first; g < gens.second; ++g)
+					{
+						auto& gen = hydra.igen[g];
+						if(gen.sfGenOper.enumeration == GenType::sampleID && gen.genAmount.wAmount < shdr_count)
+							sample_map[gen.genAmount.wAmount] = 0;
+					}
+				}
+			}
+			for(bool added = true; added;)
+			{
+				added = false;
+				for(size_t i = 0; i < shdr_count; ++i)
+				{
+					auto& sample = hydra.shdr[i];
+					if(sample_map[i] == no_index || (sample.sfSampleType & 0x7FFF) == monoSample) continue;
+					if(sample.wSampleLink < shdr_count && sample_map[sample.wSampleLink] == no_index)
+					{
+						sample_map[sample.wSampleLink] = 0;
+						added = true;
+					}
+				}
+			}
+			//assign new indexes in original order
+			auto renumber = [](std::vector<size_t>& map)
+			{
+				size_t count = 0;
+				for(auto& index : map)
+				{
+					if(index != no_index) index = count++;
+				}
+				return count;
+			};
+			renumber(inst_map);
+			renumber(sample_map);
+
+			//rebuild HYDRA
+			HYDRA out;
+			//generator lists up to and including the terminal generator,
+			//generators referencing something that isn't written are dropped
+			auto copy_gens = [&](auto& dest, auto& src, size_t first, size_t last, GenType terminal, const std::vector<size_t>& map)
+			{
+				for(size_t g = first; g < last; ++g)
+				{
+					auto gen = src[g];
+					if(gen.sfGenOper.enumeration == terminal)
+					{
+						if(gen.genAmount.wAmount >= map.size() || map[gen.genAmount.wAmount] == no_index) continue;
+						gen.genAmount.wAmount = (WORD)map[gen.genAmount.wAmount];
+						dest.push_back(gen);
+						break;
+					}
+					dest.push_back(gen);
+				}
+			};
+			for(size_t i : preset_list)
+			{
+				auto header = hydra.phdr[i];
+				header.wPresetBagNdx = (WORD)out.pbag.size();
+				out.phdr.push_back(header);
+				auto bags = bag_range(hydra.phdr[i].wPresetBagNdx, hydra.phdr[i+1].wPresetBagNdx, hydra.pbag.size()-1);
+				for(size_t b = bags.first; b < bags.second; ++b)
+				{
+					out.pbag.push_back({(WORD)out.pgen.size(), (WORD)out.pmod.size()});
+					auto gens = bag_range(hydra.pbag[b].wGenNdx, hydra.pbag[b+1].wGenNdx, hydra.pgen.size());
+					copy_gens(out.pgen, hydra.pgen, gens.first, gens.second, GenType::instrument, inst_map);
+					auto mods = bag_range(hydra.pbag[b].wModNdx, hydra.pbag[b+1].wModNdx, hydra.pmod.size());
+					out.pmod.insert(out.pmod.end(), hydra.pmod.begin() + mods.first, hydra.pmod.begin() + mods.second);
+				}
+			}
+			for(size_t i = 0; i < inst_count; ++i)
+			{
+				if(inst_map[i] == no_index) continue;
+				auto header = hydra.inst[i];
+				header.wInstBagNdx = (WORD)out.ibag.size();
+				out.inst.push_back(header);
+				auto bags = bag_range(hydra.inst[i].wInstBagNdx, hydra.inst[i+1].wInstBagNdx, hydra.ibag.size()-1);
+				for(size_t b = bags.first; b < bags.second; ++b)
+				{
+					out.ibag.push_back({(WORD)out.igen.size(), (WORD)out.imod.size()});
+					auto gens = bag_range(hydra.ibag[b].wInstGenNdx, hydra.ibag[b+1].wInstGenNdx, hydra.igen.size());
+					copy_gens(out.igen, hydra.igen, gens.first, gens.second, GenType::sampleID, sample_map);
+					auto mods = bag_range(hydra.ibag[b].wInstModNdx, hydra.ibag[b+1].wInstModNdx, hydra.imod.size());
+					out.imod.insert(out.imod.end(), hydra.imod.begin() + mods.first, hydra.imod.begin() + mods.second);
+				}
+			}
+			//samples are packed in original order, each followed by 46 zero data points
+			struct Range { size_t first, count; };
+			std::vector<Range> ranges;
+			size_t frame_count = 0;
+			size_t source_frames = sample_data_size/sizeof(int16_t);
+			for(size_t i = 0; i < shdr_count; ++i)
+			{
+				if(sample_map[i] == no_index) continue;
+				auto header = hydra.shdr[i];
+				if((header.sfSampleType & 0x7FFF) == monoSample) header.wSampleLink = 0;
+				else if(header.wSampleLink < shdr_count && sample_map[header.wSampleLink] != no_index)
+					header.wSampleLink = (WORD)sample_map[header.wSampleLink];
+				else
+				{
+					header.wSampleLink = 0;
+					header.sfSampleType = static_cast<SFSampleLink>((header.sfSampleType & 0x8000) | monoSample);
+				}
+				//ROM samples have no data in the file
+				if(!(header.sfSampleType & 0x8000))
+				{
+					size_t first = std::min<size_t>(header.dwStart, source_frames);
+					size_t last = std::min<size_t>(std::max(header.dwEnd, header.dwStart), source_frames);
+					ranges.push_back({first, last - first});
+					DWORD start = (DWORD)frame_count;
+					header.dwEnd = start + DWORD(last - first);
+					header.dwStartloop = header.dwStartloop - header.dwStart + start;
+					header.dwEndloop = header.dwEndloop - header.dwStart + start;
+					header.dwStart = start;
+					frame_count += last - first + 46;
+				}
+				out.shdr.push_back(header);
+			}
+			if(frame_count > UINT32_MAX) return false;
+
+			//terminal records
+			HYDRA::sfPresetHeader eop = {};
+			std::memcpy(eop.achPresetName, "EOP", 4);
+			eop.wPresetBagNdx = (WORD)out.pbag.size();
+			out.phdr.push_back(eop);
+			out.pbag.push_back({(WORD)out.pgen.size(), (WORD)out.pmod.size()});
+			out.pmod.push_back({});
+			out.pgen.push_back({});
+			HYDRA::sfInst eoi = {};
+			std::memcpy(eoi.achInstName, "EOI", 4);
+			eoi.wInstBagNdx = (WORD)out.ibag.size();
+			out.inst.push_back(eoi);
+			out.ibag.push_back({(WORD)out.igen.size(), (WORD)out.imod.size()});
+			out.imod.push_back({});
+			out.igen.push_back({});
+			HYDRA::sfSample eos = {};
+			std::memcpy(eos.achSampleName, "EOS", 4);
+			out.shdr.push_back(eos);
+			//indexes are 16 bit
+			if(out.pbag.size() > 65536 || out.pgen.size() > 65536 || out.pmod.size() > 65536 ||
+				out.ibag.size() > 65536 || out.igen.size() > 65536 || out.imod.size() > 65536) return false;
+
+			//serialize INFO and pdta lists
+			std::vector<BYTE> info, pdta;
+			auto put = [](std::vector<BYTE>& dest, const void* data, size_t size)
+			{
+				dest.insert(dest.end(), (const BYTE*)data, (const BYTE*)data + size);
+			};
+			auto put_chunk = [&](std::vector<BYTE>& dest, const char* id, const void* data, size_t size)
+			{
+				put(dest, id, 4);
+				DWORD chunk_size = (DWORD)size;
+				put(dest, &chunk_size, sizeof(chunk_size));
+				put(dest, data, size);
+				if(size & 1) dest.push_back(0);
+			};
+			//strings are zero terminated and padded to an even size
+			auto put_zstr = [&](const char* id, const std::string& str, size_t max_size)
+			{
+				std::string data = str.substr(0, std::min(str.size(), max_size-1));
+				data.append(2 - data.size() % 2, '\0');
+				put_chunk(info, id, data.data(), data.size());
+			};
+			put_chunk(info, "ifil", &ifil, sizeof(ifil));
+			put_zstr("isng", szSoundEngine.empty()?"EMU8000":szSoundEngine, 256);
+			put_zstr("INAM", szName.empty()?"General MIDI":szName, 256);
+			if(!szROM.empty())
+			{
+				put_zstr("irom", szROM, 256);
+				put_chunk(info, "iver", &iver, sizeof(iver));
+			}
+			if(!szDate.empty()) put_zstr("ICRD", szDate, 256);
+			if(!szCreator.empty()) put_zstr("IENG", szCreator, 256);
+			if(!szProduct.empty()) put_zstr("IPRD", szProduct, 256);
+			if(!szCopyright.empty()) put_zstr("ICOP", szCopyright, 256);
+			if(!szComment.empty()) put_zstr("ICMT", szComment, 65536);
+			if(!szTools.empty()) put_zstr("ISFT", szTools, 256);
+
+			std::vector<BYTE> records;
+			auto put_records = [&](const char* id, auto& list, size_t record_size, auto&& write)
+			{
+				records.clear();
+				for(auto& record : list) write(record);
+				if(records.size() != list.size() * record_size) return false;
+				put_chunk(pdta, id, records.data(), records.size());
+				return true;
+			};
+			auto put_raw = [&](auto& record) { put(records, &record, sizeof(record)); };
+			auto put_phdr = [&](const HYDRA::sfPresetHeader& r)
+			{
+				put(records, r.achPresetName, sizeof(r.achPresetName));
+				put(records, &r.wPreset, sizeof(r.wPreset));
+				put(records, &r.wBank, sizeof(r.wBank));
+				put(records, &r.wPresetBagNdx, sizeof(r.wPresetBagNdx));
+				put(records, &r.dwLibrary, sizeof(r.dwLibrary));
+				put(records, &r.dwGenre, sizeof(r.dwGenre));
+				put(records, &r.dwMorphology, sizeof(r.dwMorphology));
+			};
+			auto put_shdr = [&](const HYDRA::sfSample& r)
+			{
+				put(records, r.achSampleName, sizeof(r.achSampleName));
+				put(records, &r.dwStart, sizeof(r.dwStart));
+				put(records, &r.dwEnd, sizeof(r.dwEnd));
+				put(records, &r.dwStartloop, sizeof(r.dwStartloop));
+				put(records, &r.dwEndloop, sizeof(r.dwEndloop));
+				put(records, &r.dwSampleRate, sizeof(r.dwSampleRate));
+				put(records, &r.byOriginalKey, sizeof(r.byOriginalKey));
+				put(records, &r.chCorrection, sizeof(r.chCorrection));
+				put(records, &r.wSampleLink, sizeof(r.wSampleLink));
+				WORD sample_type = (WORD)r.sfSampleType;
+				put(records, &sample_type, sizeof(sample_type));
+			};
+			bool records_valid =
+				put_records("phdr", out.phdr, 38, put_phdr) &&
+				put_records("pbag", out.pbag, 4, put_raw) &&
+				put_records("pmod", out.pmod, 10, put_raw) &&
+				put_records("pgen", out.pgen, 4, put_raw) &&
+				put_records("inst", out.inst, 22, put_raw) &&
+				put_records("ibag", out.ibag, 4, put_raw) &&
+				put_records("imod", out.imod, 10, put_raw) &&
+				put_records("igen", out.igen, 4, put_raw) &&
+				put_records("shdr", out.shdr, 46, put_shdr);
+			if(!records_valid) return false;
+
+			//sizes of everything are known up front, so sample data is copied straight to the file
+			bool has_24 = sample_data_24_offset != 0;
+			uint64_t smpl_size = uint64_t(frame_count) * sizeof(int16_t);
+			uint64_t sm24_size = has_24?frame_count:0;
+			uint64_t sdta_size = 4 + 8 + smpl_size + (has_24?8 + sm24_size + (sm24_size & 1):0);
+			uint64_t riff_size = 4 + 12 + info.size() + 8 + sdta_size + 12 + pdta.size();
+			if(riff_size > UINT32_MAX) return false;
+
+			std::ofstream file(path, std::ios::binary);
+			if(!file) return false;
+			auto write = [&](const void* data, size_t size) { file.write((const char*)data, size); };
+			auto write_header = [&](const char* id, uint64_t size, const char* type = nullptr)
+			{
+				write(id, 4);
+				DWORD chunk_size = (DWORD)size;
+				write(&chunk_size, sizeof(chunk_size));
+				if(type) write(type, 4);
+			};
+			write_header("RIFF", riff_size, "sfbk");
+			write_header("LIST", 4 + info.size(), "INFO");
+			write(info.data(), info.size());
+			write_header("LIST", sdta_size, "sdta");
+
+			//copies sample data in place if it's in memory, otherwise through a buffer,
+			//data missing from the source is written as zeros
+			std::vector<BYTE> buffer;
+			const BYTE zeros[46*sizeof(int16_t)] = {};
+			auto write_zeros = [&](size_t size)
+			{
+				for(; size > sizeof(zeros); size -= sizeof(zeros)) write(zeros, sizeof(zeros));
+				write(zeros, size);
+			};
+			auto copy_data = [&](const BYTE* loaded, size_t offset, size_t available, size_t frame_size)
+			{
+				for(auto& range : ranges)
+				{
+					size_t first = std::min(range.first, available);
+					size_t count = std::min(range.count, available - first);
+					size_t size = count * frame_size;
+					size_t position = offset + first * frame_size;
+					if(loaded) write(loaded + first * frame_size, size);
+					else if(auto view = stream->view(position, size)) write(view, size);
+					else
+					{
+						for(size_t done = 0; done < size;)
+						{
+							size_t block = std::min<size_t>(size - done, 1 << 20);
+							buffer.resize(block);
+							read_stream(position + done, buffer.data(), block);
+							write(buffer.data(), block);
+							done += block;
+						}
+					}
+					write_zeros((range.count - count + 46) * frame_size);
+				}
+			};
+			write_header("smpl", smpl_size);
+			copy_data(sample_data, sample_data_offset, source_frames, sizeof(int16_t));
+			if(has_24)
+			{
+				write_header("sm24", sm24_size);
+				copy_data(sample_data_24, sample_data_24_offset, sample_data_24_size, 1);
+				if(sm24_size & 1) write(zeros, 1);
+			}
+			write_header("LIST", 4 + pdta.size(), "pdta");
+			write(pdta.data(), pdta.size());
+			return bool(file);
+		}
+
+		//Declared last, so that threads are stopped before anything they use is destroyed
+		std::once_flag sample_loader_once;
+		std::unique_ptr<SampleLoader> sample_loader;
+		std::unique_ptr<DiskStreamer> disk_streamer;
+	};
+}
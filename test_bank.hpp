@@ -0,0 +1,153 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+//Small SoundFont2 bank built in memory for the tests:
+//a mono sample and a linked stereo pair, each played by its own instrument,
+//and three presets in two banks
+namespace test_bank
+{
+    struct SampleInfo {
+        const char* name;
+        uint32_t frames;
+        //relative to the start of the sample
+        uint32_t loop_start;
+        uint32_t loop_end;
+        uint16_t link;
+        uint16_t type;
+    };
+    static const SampleInfo samples[] = {
+        {"mono", 100, 10, 90, 0, 1},
+        {"left", 80, 5, 70, 2, 4},
+        {"right", 80, 5, 70, 1, 2},
+    };
+    static const size_t sample_count = sizeof(samples) / sizeof(samples[0]);
+    //frames of silence after every sample
+    static const uint32_t sample_padding = 46;
+
+    struct PresetInfo {
+        const char* name;
+        uint16_t num;
+        uint16_t bank;
+        uint16_t instrument;
+    };
+    static const PresetInfo presets[] = {
+        {"Piano", 0, 0, 0},
+        {"Strings", 1, 0, 1},
+        {"Drums", 0, 128, 0},
+    };
+    static const size_t preset_count = sizeof(presets) / sizeof(presets[0]);
+
+    //Instruments play samples [first_sample, first_sample + sample_count)
+    struct InstrumentInfo {
+        const char* name;
+        uint16_t first_sample;
+        uint16_t sample_count;
+    };
+    static const InstrumentInfo instruments[] = {
+        {"Solo", 0, 1},
+        {"Stereo", 1, 2},
+    };
+    static const size_t instrument_count = sizeof(instruments) / sizeof(instruments[0]);
+
+    inline int16_t sample_value(size_t sample, uint32_t frame) {
+        return int16_t((sample + 1) * 1000 + frame * 37 - 1500);
+    }
+
+    template <typename T>
+    inline void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    inline void put_name(std::string& out, const char* name) {
+        char field[20] = {};
+        std::strncpy(field, name, sizeof(field) - 1);
+        out.append(field, sizeof(field));
+    }
+
+    inline std::string chunk(const char* id, const std::string& data) {
+        std::string out(id, 4);
+        put(out, uint32_t(data.size()));
+        out += data;
+        if(data.size() & 1) out += '\0';
+        return out;
+    }
+
+    inline std::string make_bank(const char* name) {
+        std::string ifil, inam(name);
+        put(ifil, uint16_t(2));
+        put(ifil, uint16_t(1));
+        inam += '\0';
+
+        std::string smpl, shdr;
+        for(size_t i = 0; i < sample_count; ++i) {
+            auto& s = samples[i];
+            uint32_t start = uint32_t(smpl.size() / 2);
+            for(uint32_t frame = 0; frame < s.frames; ++frame)
+                put(smpl, sample_value(i, frame));
+            smpl.append(sample_padding * 2, '\0');
+            put_name(shdr, s.name);
+            put(shdr, start);
+            put(shdr, start + s.frames);
+            put(shdr, start + s.loop_start);
+            put(shdr, start + s.loop_end);
+            put(shdr, uint32_t(44100));
+            put(shdr, uint8_t(60));
+            put(shdr, int8_t(0));
+            put(shdr, s.link);
+            put(shdr, s.type);
+        }
+        put_name(shdr, "EOS");
+        shdr.append(46 - 20, '\0');
+
+        //one zone per sample of an instrument, generators end with sampleID
+        std::string inst, ibag, imod(10, '\0'), igen;
+        uint16_t zone = 0;
+        for(auto& instrument : instruments) {
+            put_name(inst, instrument.name);
+            put(inst, zone);
+            for(uint16_t i = 0; i < instrument.sample_count; ++i, ++zone) {
+                put(ibag, zone);
+                put(ibag, uint16_t(0));
+                put(igen, uint16_t(53));
+                put(igen, uint16_t(instrument.first_sample + i));
+            }
+        }
+        put_name(inst, "EOI");
+        put(inst, zone);
+        put(ibag, zone);
+        put(ibag, uint16_t(0));
+        put(igen, uint32_t(0));
+
+        //one zone per preset, its generator is the instrument
+        std::string phdr, pbag, pmod(10, '\0'), pgen;
+        for(uint16_t i = 0; i < preset_count; ++i) {
+            put_name(phdr, presets[i].name);
+            put(phdr, presets[i].num);
+            put(phdr, presets[i].bank);
+            put(phdr, i);
+            phdr.append(12, '\0');
+            put(pbag, i);
+            put(pbag, uint16_t(0));
+            put(pgen, uint16_t(41));
+            put(pgen, presets[i].instrument);
+        }
+        put_name(phdr, "EOP");
+        put(phdr, uint32_t(0));
+        put(phdr, uint16_t(preset_count));
+        phdr.append(12, '\0');
+        put(pbag, uint16_t(preset_count));
+        put(pbag, uint16_t(0));
+        put(pgen, uint32_t(0));
+
+        std::string body = "sfbk";
+        body += chunk("LIST", "INFO" + chunk("ifil", ifil) + chunk("INAM", inam));
+        body += chunk("LIST", "sdta" + chunk("smpl", smpl));
+        body += chunk("LIST", "pdta" + chunk("phdr", phdr) + chunk("pbag", pbag) + chunk("pmod", pmod) +
+            chunk("pgen", pgen) + chunk("inst", inst) + chunk("ibag", ibag) + chunk("imod", imod) +
+            chunk("igen", igen) + chunk("shdr", shdr));
+        return chunk("RIFF", body);
+    }
+}
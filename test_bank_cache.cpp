@@ -0,0 +1,131 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <filesystem>
+
+#include "sf2.hpp"
+#include "test_bank.hpp"
+
+namespace fs = std::filesystem;
+
+static bool expect(bool condition, const char* what) {
+    if(!condition) std::cerr << "bank cache: " << what << std::endl;
+    return condition;
+}
+
+static size_t index_of(const SF2::SoundFont2& sf, const SF2::SoundFont2::Sample* sample) {
+    for(size_t i = 0; i < sf.samples.size(); ++i)
+        if(sf.samples[i].get() == sample) return i;
+    return SIZE_MAX;
+}
+
+//Compares resident frames, loops and links with the bank the test made
+static bool check_samples(const SF2::SoundFont2& sf) {
+    if(sf.samples.size() != test_bank::sample_count) return false;
+    for(size_t i = 0; i < sf.samples.size(); ++i) {
+        auto& sample = *sf.samples[i];
+        auto& info = test_bank::samples[i];
+        if(!sample.IsLoaded() || sample.format != SF2::SampleFormat::Float || sample.size != info.frames ||
+            sample.loop_start != info.loop_start || sample.loop_end != info.loop_end ||
+            sample.sample_type != info.type)
+            return false;
+        size_t linked = sample.linked_sample ? index_of(sf, sample.linked_sample) : 0;
+        if(info.type != 1 && linked != info.link) return false;
+        for(uint32_t frame = 0; frame < info.frames; ++frame) {
+            float expected = (float)test_bank::sample_value(i, frame) / 32767.0f;
+            float value = SF2::load_sample<SF2::SampleFormat::Float>(sample.data.get(), frame);
+            if(std::memcmp(&expected, &value, sizeof(float)) != 0) return false;
+        }
+    }
+    return true;
+}
+
+//Compares banks, presets, instruments and zones of a cached bank with the parsed one
+static bool same_structure(const SF2::SoundFont2& a, const SF2::SoundFont2& b) {
+    if(a.banks.size() != b.banks.size() || a.instruments.size() != b.instruments.size()) return false;
+    for(size_t i = 0; i < a.banks.size(); ++i) {
+        auto& x = *a.banks[i];
+        auto& y = *b.banks[i];
+        if(x.num != y.num || x.presets.size() != y.presets.size()) return false;
+        for(size_t j = 0; j < x.presets.size(); ++j) {
+            if(x.presets[j]->name != y.presets[j]->name || x.presets[j]->num != y.presets[j]->num ||
+                x.presets[j]->layers.size() != y.presets[j]->layers.size())
+                return false;
+        }
+    }
+    for(size_t i = 0; i < a.instruments.size(); ++i) {
+        auto& x = *a.instruments[i];
+        auto& y = *b.instruments[i];
+        if(x.name != y.name || x.splits.size() != y.splits.size()) return false;
+        for(size_t j = 0; j < x.splits.size(); ++j) {
+            if(index_of(a, x.splits[j].sample) != index_of(b, y.splits[j].sample)) return false;
+        }
+    }
+    return true;
+}
+
+//Saves a bank to a cache and loads it back, with a matching and a changed identity
+//and with damaged sample data
+static bool check_bank_cache(const fs::path& dir) {
+    auto bank = test_bank::make_bank("Cached");
+    RIFF::memory_reader reader;
+    reader.data = reinterpret_cast<const uint8_t*>(bank.data());
+    reader.size = bank.size();
+    auto s = reader.get_stream();
+    RIFF::RIFF riff;
+    riff.parse(s, RIFF::RIFF::load_policy::metadata());
+    SF2::SoundFont2 sf(&riff, &s);
+    sf.identity = "bank|1";
+
+    bool ok = true;
+    auto path = (dir / "bank.cache").string();
+    ok &= expect(sf.SaveCache(path.c_str()), "save failed");
+    sf.LoadAllSamples();
+    ok &= expect(check_samples(sf), "parsed bank differs from the source");
+
+    auto cached = SF2::SoundFont2::LoadCache(path.c_str(), "bank|1", true);
+    ok &= expect(cached != nullptr, "load failed");
+    if(!cached) return false;
+    ok &= expect(cached->szName == "Cached" && cached->identity == "bank|1", "wrong info");
+    ok &= expect(check_samples(*cached), "cached samples differ");
+    ok &= expect(same_structure(sf, *cached), "cached presets or zones differ");
+
+    //a cached bank has no stream to read from, io_uring isn't used
+    std::vector<SF2::SoundFont2::Sample*> all;
+    for(auto& sample : cached->samples) all.push_back(sample.get());
+    ok &= expect(!cached->LoadSamplesIoUring(all, -1), "io_uring used without a stream");
+    ok &= expect(check_samples(*cached), "cached samples differ after io_uring load");
+
+    //a cache of another version of the file is stale
+    ok &= expect(SF2::SoundFont2::LoadCache(path.c_str(), "bank|2") == nullptr, "changed identity accepted");
+
+    //damaged sample data is only noticed when verified
+    SF2::SoundFont2::CacheHeader header;
+    {
+        std::ifstream file(path, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(header.data_offset + 8);
+        char byte = char(file.get() ^ 0x55);
+        file.seekp(header.data_offset + 8);
+        file.put(byte);
+    }
+    ok &= expect(SF2::SoundFont2::LoadCache(path.c_str(), "bank|1", true) == nullptr, "damaged data accepted");
+    ok &= expect(SF2::SoundFont2::LoadCache(path.c_str(), "bank|1") != nullptr, "unverified load failed");
+
+    if(ok) std::cout << "bank cache: OK" << std::endl;
+    return ok;
+}
+
+int main() {
+    auto dir = fs::temp_directory_path() / "sf2hpp_test_bank_cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    bool ok = check_bank_cache(dir);
+    fs::remove_all(dir);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
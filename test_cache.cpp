@@ -0,0 +1,49 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+
+#include "sf2.hpp"
+
+static std::shared_ptr<const uint8_t[]> make_data(uint8_t value) {
+    std::shared_ptr<uint8_t[]> data(new uint8_t[16]);
+    std::fill(data.get(), data.get() + 16, value);
+    return data;
+}
+
+//Looks up many more distinct keys than the purge threshold,
+//keeping every other buffer alive, so that purging runs repeatedly
+static bool check_purge() {
+    SF2::SampleCache cache;
+    std::vector<std::shared_ptr<const uint8_t[]>> held;
+    const size_t count = 1000;
+    size_t loads = 0;
+    for(size_t i = 0; i < count; ++i) {
+        SF2::SampleCache::Key key = {"bank", i, 16, SF2::SampleFormat::Int16};
+        auto data = cache.Get(key, [&]{ ++loads; return make_data(uint8_t(i)); });
+        if(!data || data[0] != uint8_t(i)) {
+            std::cerr << "purge: wrong data for key " << i << std::endl;
+            return false;
+        }
+        if(i % 2 == 0) held.push_back(data);
+    }
+    //data still in use is shared rather than loaded again
+    for(size_t i = 0; i < count; i += 2) {
+        SF2::SampleCache::Key key = {"bank", i, 16, SF2::SampleFormat::Int16};
+        auto data = cache.Get(key, [&]{ ++loads; return make_data(0); });
+        if(data != held[i / 2]) {
+            std::cerr << "purge: key " << i << " was loaded again" << std::endl;
+            return false;
+        }
+    }
+    if(loads != count || cache.Size() != held.size()) {
+        std::cerr << "purge: " << loads << " loads, " << cache.Size() << " buffers in use" << std::endl;
+        return false;
+    }
+    std::cout << "purge: OK" << std::endl;
+    return true;
+}
+
+int main() {
+    bool ok = check_purge();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
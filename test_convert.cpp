@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+#include "sf2.hpp"
+
+//Reference conversion, as originally done in Sample::load_data
+static float reference(int16_t value16, const uint8_t* value24) {
+    if(value24)
+        return (float)(
+            (
+                (((const uint8_t*)&value16)[1] << 24) |
+                (((const uint8_t*)&value16)[0] << 16) |
+                (*value24 << 8)
+                ) >> 8
+            ) / 8388607.0;
+    return (float)value16 / 32767.0;
+}
+
+typedef void (*convert_func)(float*, const int16_t*, const uint8_t*, size_t);
+
+//Checks every 16 bit value combined with various least significant bytes,
+//at every alignment and with every tail length
+static bool check(const char* name, convert_func convert) {
+    std::vector<int16_t> data16(65536 + 64);
+    std::vector<uint8_t> data24(data16.size());
+    for(size_t i = 0; i < data16.size(); ++i) {
+        data16[i] = int16_t(uint16_t(i - 32768));
+        data24[i] = uint8_t(i * 37 + (i >> 8));
+    }
+    std::vector<float> output(data16.size());
+    for(int pass = 0; pass < 2; ++pass) {
+        const uint8_t* lsb = pass ? data24.data() : nullptr;
+        for(size_t offset = 0; offset < 16; ++offset) {
+            for(size_t tail = 0; tail < 16; ++tail) {
+                size_t count = (offset + tail == 0) ? 65536 : 1024 + tail;
+                std::fill(output.begin(), output.end(), -2.0f);
+                convert(output.data(), data16.data() + offset, lsb ? lsb + offset : nullptr, count);
+                for(size_t i = 0; i < count; ++i) {
+                    float expected = reference(data16[offset + i], lsb ? lsb + offset + i : nullptr);
+                    if(std::memcmp(&expected, &output[i], sizeof(float)) != 0) {
+                        std::cerr << name << ": mismatch at " << i << " (offset " << offset
+                            << ", " << (lsb ? 24 : 16) << " bit): " << output[i] << " != " << expected << std::endl;
+                        return false;
+                    }
+                }
+                if(output[count] != -2.0f) {
+                    std::cerr << name << ": wrote past the end" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    std::cout << name << ": OK" << std::endl;
+    return true;
+}
+
+//Checks that compressed data decodes to the same values as the uncompressed format,
+//with smooth, noisy and full scale alternating data to exercise all predictors and escapes
+static bool check_compression(SF2::SampleFormat format) {
+    const char* name = (format == SF2::SampleFormat::Int24) ? "compressed 24 bit" : "compressed 16 bit";
+    size_t frame_size = SF2::sample_format_size(format);
+    int32_t max = (format == SF2::SampleFormat::Int24) ? 8388607 : 32767;
+    uint32_t seed = 1;
+    for(uint32_t count : {1u, 2u, 127u, 128u, 129u, 1000u, 65536u}) {
+        std::vector<uint8_t> pcm(count * frame_size);
+        for(uint32_t i = 0; i < count; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            int32_t value;
+            if(i < count / 3)
+                value = int32_t(std::sin(i * 0.01) * max);
+            else if(i < count * 2 / 3)
+                value = int32_t(seed >> 8) % (max / 64) - max / 128;
+            else
+                value = (i & 1) ? max : -max - 1;
+            for(size_t b = 0; b < frame_size; ++b)
+                pcm[i * frame_size + b] = uint8_t(uint32_t(value) >> (8 * b));
+        }
+        auto compressed = SF2::compress_samples(pcm.data(), format, count);
+        std::vector<float> block(SF2::compressed_block_frames);
+        for(uint32_t first = 0; first < count; first += SF2::compressed_block_frames) {
+            uint32_t decoded = SF2::decompress_block(compressed.get(), first / SF2::compressed_block_frames, block.data());
+            if(decoded != std::min<uint32_t>(SF2::compressed_block_frames, count - first)) {
+                std::cerr << name << ": wrong block size at " << first << std::endl;
+                return false;
+            }
+            for(uint32_t i = 0; i < decoded; ++i) {
+                float expected = (format == SF2::SampleFormat::Int24) ?
+                    SF2::load_sample<SF2::SampleFormat::Int24>(pcm.data(), first + i) :
+                    SF2::load_sample<SF2::SampleFormat::Int16>(pcm.data(), first + i);
+                if(std::memcmp(&expected, &block[i], sizeof(float)) != 0) {
+                    std::cerr << name << ": mismatch at " << first + i << " of " << count << ": "
+                        << block[i] << " != " << expected << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    std::cout << name << ": OK" << std::endl;
+    return true;
+}
+
+int main() {
+    bool ok = check("scalar", SF2::convert_samples_scalar);
+#ifdef SF2_SSE2_SUPPORTED
+    ok &= check("sse2", SF2::convert_samples_sse2);
+#endif
+#ifdef SF2_AVX2_SUPPORTED
+    if(SF2::cpu_supports_avx2())
+        ok &= check("avx2", SF2::convert_samples_avx2);
+#endif
+    ok &= check("dispatch", SF2::convert_samples);
+    ok &= check_compression(SF2::SampleFormat::Int16);
+    ok &= check_compression(SF2::SampleFormat::Int24);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
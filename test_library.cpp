@@ -0,0 +1,107 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <filesystem>
+
+#include "Library.hpp"
+#include "test_bank.hpp"
+
+namespace fs = std::filesystem;
+
+static void write_file(const fs::path& path, const std::string& data) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+}
+
+static bool expect(bool condition, const char* what) {
+    if(!condition) std::cerr << "library: " << what << std::endl;
+    return condition;
+}
+
+static bool same_entries(const SF2::LibraryIndex& a, const SF2::LibraryIndex& b) {
+    if(a.files.size() != b.files.size()) return false;
+    for(size_t i = 0; i < a.files.size(); ++i) {
+        auto& x = a.files[i];
+        auto& y = b.files[i];
+        if(x.path != y.path || x.size != y.size || x.mtime != y.mtime || x.valid != y.valid ||
+            x.catalog.szName != y.catalog.szName || x.catalog.sample_count != y.catalog.sample_count ||
+            x.catalog.sample_bytes != y.catalog.sample_bytes || x.catalog.presets.size() != y.catalog.presets.size())
+            return false;
+        for(size_t j = 0; j < x.catalog.presets.size(); ++j) {
+            if(x.catalog.presets[j].name != y.catalog.presets[j].name ||
+                x.catalog.presets[j].bank != y.catalog.presets[j].bank)
+                return false;
+        }
+    }
+    return true;
+}
+
+//Updates an index from two roots, with new, changed, removed and broken files,
+//then saves and loads it
+static bool check_library(const fs::path& dir) {
+    auto root_a = dir / "a", root_b = dir / "b";
+    write_file(root_a / "one.sf2", test_bank::make_bank("One"));
+    write_file(root_a / "sub" / "two.SF3", test_bank::make_bank("Two"));
+    write_file(root_a / "notes.txt", "not a soundfont");
+    write_file(root_b / "three.sf2", test_bank::make_bank("Three"));
+    write_file(root_b / "broken.sf2", "RIFF");
+    root_a = fs::canonical(root_a);
+    root_b = fs::canonical(root_b);
+
+    bool ok = true;
+    SF2::LibraryIndex index;
+    auto stats = index.Update(root_a.string(), 2);
+    ok &= expect(stats.scanned == 2 && index.files.size() == 2, "first root not scanned");
+    auto one = index.Find((root_a / "one.sf2").string());
+    ok &= expect(one && one->valid && one->catalog.szName == "One" && one->catalog.presets.size() == 3 &&
+        one->catalog.presets[0].name == "Piano" && one->catalog.presets[2].bank == 128 &&
+        one->catalog.sample_count == 3 && one->catalog.sample_bytes == (100 + 80 + 80) * 2, "wrong catalog");
+    ok &= expect(index.Find((root_a / "sub" / "two.SF3").string()) != nullptr, "sf3 file not indexed");
+
+    //entries of the first root are kept while the second one is scanned
+    stats = index.Update(root_b.string(), 2);
+    ok &= expect(stats.scanned == 2 && stats.removed == 0 && index.files.size() == 4, "second root not scanned");
+    auto broken = index.Find((root_b / "broken.sf2").string());
+    ok &= expect(broken && !broken->valid, "broken file is valid");
+    one = index.Find((root_a / "one.sf2").string());
+    ok &= expect(one && one->catalog.szName == "One", "first root entry lost");
+
+    //only the changed file is scanned again, the removed one is dropped
+    write_file(root_a / "one.sf2", test_bank::make_bank("Uno"));
+    fs::last_write_time(root_a / "one.sf2", fs::last_write_time(root_a / "one.sf2") + std::chrono::seconds(2));
+    fs::remove(root_a / "sub" / "two.SF3");
+    stats = index.Update(root_a.string());
+    ok &= expect(stats.scanned == 1 && stats.unchanged == 0 && stats.removed == 1 && index.files.size() == 3,
+        "incremental update");
+    one = index.Find((root_a / "one.sf2").string());
+    ok &= expect(one && one->catalog.szName == "Uno", "changed file not scanned");
+    stats = index.Update(root_b.string());
+    ok &= expect(stats.scanned == 0 && stats.unchanged == 2, "unchanged files scanned again");
+
+    auto index_path = (dir / "library.index").string();
+    ok &= expect(index.Save(index_path), "save failed");
+    SF2::LibraryIndex loaded;
+    ok &= expect(loaded.Load(index_path) && same_entries(index, loaded), "loaded index differs");
+    stats = loaded.Update(root_a.string());
+    ok &= expect(stats.scanned == 0 && stats.unchanged == 1, "loaded index not reused");
+
+    //damaged index is rejected
+    {
+        std::fstream file(index_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(20);
+        file.put('\x7f');
+    }
+    ok &= expect(!loaded.Load(index_path) && loaded.files.empty(), "damaged index accepted");
+
+    if(ok) std::cout << "library: OK" << std::endl;
+    return ok;
+}
+
+int main() {
+    auto dir = fs::temp_directory_path() / "sf2hpp_test_library";
+    fs::remove_all(dir);
+    bool ok = check_library(dir);
+    fs::remove_all(dir);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include "sf2.hpp"
+#include "test_bank.hpp"
+
+static bool expect(bool condition, const char* what) {
+    if(!condition) std::cerr << "stream: " << what << std::endl;
+    return condition;
+}
+
+//Forward-only source returning at most a few bytes per call, like a slow pipe
+struct ShortReads {
+    const std::string* data;
+    size_t pos = 0;
+    size_t calls = 0;
+
+    static size_t read(void* user, void* dest, size_t size) {
+        auto& source = *static_cast<ShortReads*>(user);
+        size_t count = std::min({size, size_t(7), source.data->size() - source.pos});
+        std::memcpy(dest, source.data->data() + source.pos, count);
+        source.pos += count;
+        ++source.calls;
+        return count;
+    }
+};
+
+//Compares resident frames of every sample with the bank the test made
+static bool check_frames(const SF2::SoundFont2& sf) {
+    if(sf.samples.size() != test_bank::sample_count) return false;
+    for(size_t i = 0; i < sf.samples.size(); ++i) {
+        auto& sample = *sf.samples[i];
+        if(!sample.IsLoaded() || sample.format != SF2::SampleFormat::Float ||
+            sample.size != test_bank::samples[i].frames)
+            return false;
+        for(uint32_t frame = 0; frame < sample.size; ++frame) {
+            float expected = (float)test_bank::sample_value(i, frame) / 32767.0f;
+            float value = SF2::load_sample<SF2::SampleFormat::Float>(sample.data.get(), frame);
+            if(std::memcmp(&expected, &value, sizeof(float)) != 0) return false;
+        }
+    }
+    return true;
+}
+
+//Frames of both banks are bitwise equal
+static bool same_frames(const SF2::SoundFont2& a, const SF2::SoundFont2& b) {
+    if(a.samples.size() != b.samples.size()) return false;
+    for(size_t i = 0; i < a.samples.size(); ++i) {
+        auto& x = *a.samples[i];
+        auto& y = *b.samples[i];
+        if(x.size != y.size || x.format != y.format ||
+            std::memcmp(x.data.get(), y.data.get(), x.size * SF2::sample_format_size(x.format)) != 0)
+            return false;
+    }
+    return true;
+}
+
+//Loads a bank through a forward reader with short reads and from memory,
+//before and after the memory budget evicts its samples
+static bool check_forward_reader() {
+    auto bank = test_bank::make_bank("Streamed");
+    RIFF::memory_reader memory;
+    memory.data = reinterpret_cast<const uint8_t*>(bank.data());
+    memory.size = bank.size();
+    auto ms = memory.get_stream();
+    RIFF::RIFF memory_riff;
+    memory_riff.parse(ms, RIFF::RIFF::load_policy::metadata());
+    SF2::SoundFont2 expected(&memory_riff, &ms);
+    expected.LoadAllSamples();
+
+    ShortReads source{&bank};
+    RIFF::forward_reader reader(ShortReads::read, &source);
+    auto fs = reader.get_stream();
+    RIFF::RIFF riff;
+    riff.parse(fs, RIFF::RIFF::load_policy::all());
+    SF2::SoundFont2 sf(&riff, &fs);
+
+    bool ok = true;
+    ok &= expect(source.pos == bank.size() && source.calls > bank.size() / 7, "source not read in short reads");
+    ok &= expect(sf.szName == "Streamed" && sf.banks.size() == 2, "wrong info");
+    sf.LoadAllSamples();
+    ok &= expect(check_frames(sf) && check_frames(expected), "wrong frames");
+    ok &= expect(same_frames(sf, expected), "frames differ from the memory reader");
+
+    //nothing is pinned, so every sample is evicted and loaded again from the parsed data
+    sf.SetSampleMemoryBudget(1);
+    ok &= expect(sf.GetSampleMemoryUsage() == 0 &&
+        std::none_of(sf.samples.begin(), sf.samples.end(), [](auto& sample) { return sample->IsLoaded(); }),
+        "samples not evicted");
+    sf.SetSampleMemoryBudget(0);
+    sf.LoadAllSamples();
+    ok &= expect(check_frames(sf), "wrong frames after eviction");
+    ok &= expect(same_frames(sf, expected), "frames differ from the memory reader after eviction");
+
+    if(ok) std::cout << "stream: OK" << std::endl;
+    return ok;
+}
+
+int main() {
+    bool ok = check_forward_reader();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
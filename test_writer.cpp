@@ -0,0 +1,121 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <memory>
+#include <filesystem>
+
+#include "sf2.hpp"
+#include "test_bank.hpp"
+
+namespace fs = std::filesystem;
+
+static bool expect(bool condition, const char* what) {
+    if(!condition) std::cerr << "writer: " << what << std::endl;
+    return condition;
+}
+
+//Bank parsed from memory with every chunk loaded, the data must outlive it
+struct ParsedBank {
+    std::string data;
+    RIFF::memory_reader reader;
+    RIFF::stream stream;
+    RIFF::RIFF riff;
+    std::unique_ptr<SF2::SoundFont2> sf;
+
+    explicit ParsedBank(std::string bank): data(std::move(bank)) {
+        reader.data = reinterpret_cast<const uint8_t*>(data.data());
+        reader.size = data.size();
+        stream = reader.get_stream();
+        riff.parse(stream, RIFF::RIFF::load_policy::all());
+        sf = std::make_unique<SF2::SoundFont2>(&riff, &stream);
+    }
+};
+
+static std::string read_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+static std::string name_of(const SF2::CHAR* field) {
+    auto name = reinterpret_cast<const char*>(field);
+    return std::string(name, strnlen(name, 20));
+}
+
+//Checks that the written smpl chunk holds the given source samples in order,
+//each followed by 46 zero frames
+static bool check_sample_data(ParsedBank& bank, std::initializer_list<size_t> source) {
+    SF2::RIFF_SoundFont2 chunks(&bank.riff);
+    auto smpl = chunks.sdta.smpl;
+    size_t expected_frames = 0;
+    for(size_t i : source) expected_frames += test_bank::samples[i].frames + test_bank::sample_padding;
+    if(chunks.structurally_unsound || !smpl || smpl->size != expected_frames * 2) return false;
+    auto data = smpl->get_data();
+    size_t pos = 0;
+    for(size_t i : source) {
+        for(uint32_t frame = 0; frame < test_bank::samples[i].frames + test_bank::sample_padding; ++frame, ++pos) {
+            int16_t value;
+            std::memcpy(&value, data + pos * 2, sizeof(value));
+            int16_t expected = (frame < test_bank::samples[i].frames) ? test_bank::sample_value(i, frame) : 0;
+            if(value != expected) return false;
+        }
+    }
+    return true;
+}
+
+//Writes the stereo preset alone, so that its samples move to the front,
+//then the two presets sharing the mono instrument
+static bool check_writer(const fs::path& dir) {
+    ParsedBank source(test_bank::make_bank("Writer"));
+    bool ok = true;
+
+    auto path = dir / "strings.sf2";
+    auto strings_only = [](uint16_t bank, uint16_t preset) { return bank == 0 && preset == 1; };
+    ok &= expect(source.sf->Write(path.string().c_str(), strings_only), "write failed");
+    ParsedBank strings(read_file(path));
+    auto& hydra = strings.sf->hydra;
+    //last records are terminators
+    ok &= expect(hydra.phdr.size() == 2 && name_of(hydra.phdr[0].achPresetName) == "Strings", "wrong presets");
+    ok &= expect(hydra.inst.size() == 2 && name_of(hydra.inst[0].achInstName) == "Stereo", "wrong instruments");
+    ok &= expect(hydra.pgen.size() == 2 && hydra.pgen[0].genAmount.wAmount == 0, "instrument index not remapped");
+    ok &= expect(hydra.igen.size() == 3 && hydra.igen[0].genAmount.wAmount == 0 && hydra.igen[1].genAmount.wAmount == 1,
+        "sample indices not remapped");
+    ok &= expect(hydra.shdr.size() == 3, "unselected samples written");
+    if(hydra.shdr.size() == 3) {
+        auto& left = hydra.shdr[0];
+        auto& right = hydra.shdr[1];
+        ok &= expect(name_of(left.achSampleName) == "left" && name_of(right.achSampleName) == "right", "wrong samples");
+        ok &= expect(left.wSampleLink == 1 && right.wSampleLink == 0, "links not remapped");
+        ok &= expect(left.dwStart == 0 && left.dwEnd == 80 && left.dwStartloop == 5 && left.dwEndloop == 70,
+            "first sample not rebased");
+        ok &= expect(right.dwStart == 126 && right.dwEnd == 206 && right.dwStartloop == 131 && right.dwEndloop == 196,
+            "second sample not rebased");
+    }
+    ok &= expect(check_sample_data(strings, {1, 2}), "wrong sample data");
+    ok &= expect(strings.sf->banks.size() == 1 && strings.sf->samples.size() == 2 &&
+        strings.sf->samples[0]->linked_sample == strings.sf->samples[1].get(), "written bank doesn't load");
+
+    path = dir / "mono.sf2";
+    auto first_presets = [](uint16_t, uint16_t preset) { return preset == 0; };
+    ok &= expect(source.sf->Write(path.string().c_str(), first_presets), "write failed");
+    ParsedBank mono(read_file(path));
+    ok &= expect(mono.sf->hydra.phdr.size() == 3 && mono.sf->hydra.inst.size() == 2 && mono.sf->hydra.shdr.size() == 2,
+        "shared instrument written twice");
+    ok &= expect(mono.sf->banks.size() == 2 && name_of(mono.sf->hydra.inst[0].achInstName) == "Solo", "wrong instruments");
+    ok &= expect(check_sample_data(mono, {0}), "wrong sample data");
+
+    if(ok) std::cout << "writer: OK" << std::endl;
+    return ok;
+}
+
+int main() {
+    auto dir = fs::temp_directory_path() / "sf2hpp_test_writer";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    bool ok = check_writer(dir);
+    fs::remove_all(dir);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}